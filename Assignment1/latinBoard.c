@@ -0,0 +1,262 @@
+/**
+ * @file latinBoard.c
+ * @brief Implementation of the dynamically sized board of a Latin Square.
+ *
+ * This file provides the functions for allocating and freeing a board, reading and
+ * writing its cells and querying its occupancy state.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "latinBoard.h"
+
+
+int initLatinBoard(LatinBoard **board, int size){
+    if(size <= 0 || size > MAX_SIZE){
+        return EXIT_FAILURE;
+    }
+
+    *board = (LatinBoard *) malloc(sizeof(LatinBoard));
+    if(*board == NULL){
+        perror("Unable to allocate memory for the board.");
+        return EXIT_FAILURE;
+    }
+
+    LatinBoard *b = *board;
+    size_t cells = (size_t) size * (size_t) size;
+    b->size = size;
+    b->cellBytes = (size <= SMALL_SIZE) ? 1 : 2; // narrowest type that holds 0..size
+    b->words = (size + 1 + 63) / 64; // bits 0..size of a mask
+    b->emptyCells = (long) cells;
+    b->repeats = 0;
+
+    // One contiguous row-major block of cells, all empty
+    b->cells = calloc(cells, (size_t) b->cellBytes);
+    b->given = (uint64_t *) calloc((cells + 63) / 64, sizeof(uint64_t));
+    b->rowUsed = (uint64_t *) calloc((size_t) size * b->words, sizeof(uint64_t));
+    b->colUsed = (uint64_t *) calloc((size_t) size * b->words, sizeof(uint64_t));
+    b->valueCount = (int *) calloc((size_t) size + 1, sizeof(int));
+    if(b->cells == NULL || b->given == NULL || b->rowUsed == NULL || b->colUsed == NULL || b->valueCount == NULL){
+        perror("Unable to allocate memory for the board.");
+        freeLatinBoard(b);
+        *board = NULL;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+void freeLatinBoard(LatinBoard *board){
+    if(board == NULL){
+        return;
+    }
+
+    free(board->cells);
+    free(board->given);
+    free(board->rowUsed);
+    free(board->colUsed);
+    free(board->valueCount);
+    free(board);
+}
+
+void clearLatinBoard(LatinBoard *board){
+    size_t cells = (size_t) board->size * (size_t) board->size;
+    size_t masks = (size_t) board->size * board->words;
+    memset(board->cells, 0, cells * board->cellBytes);
+    memset(board->given, 0, (cells + 63) / 64 * sizeof(uint64_t));
+    memset(board->rowUsed, 0, masks * sizeof(uint64_t));
+    memset(board->colUsed, 0, masks * sizeof(uint64_t));
+    memset(board->valueCount, 0, ((size_t) board->size + 1) * sizeof(int));
+    board->emptyCells = (long) cells;
+    board->repeats = 0;
+}
+
+int copyLatinBoard(LatinBoard **copy, const LatinBoard *board){
+    if(initLatinBoard(copy, board->size) != EXIT_SUCCESS){
+        return EXIT_FAILURE;
+    }
+
+    LatinBoard *c = *copy;
+    size_t cells = (size_t) board->size * (size_t) board->size;
+    size_t masks = (size_t) board->size * board->words;
+    memcpy(c->cells, board->cells, cells * board->cellBytes);
+    memcpy(c->given, board->given, (cells + 63) / 64 * sizeof(uint64_t));
+    memcpy(c->rowUsed, board->rowUsed, masks * sizeof(uint64_t));
+    memcpy(c->colUsed, board->colUsed, masks * sizeof(uint64_t));
+    memcpy(c->valueCount, board->valueCount, ((size_t) board->size + 1) * sizeof(int));
+    c->emptyCells = board->emptyCells;
+    c->repeats = board->repeats;
+
+    return EXIT_SUCCESS;
+}
+
+int getCell(const LatinBoard *board, int row, int col){
+    size_t index = (size_t) row * board->size + col;
+    if(board->cellBytes == 1){
+        return ((const uint8_t *) board->cells)[index];
+    }
+    return ((const uint16_t *) board->cells)[index];
+}
+
+/**
+ * @brief Stores a value in a cell without touching the occupancy state.
+ *
+ * @param board The board.
+ * @param index Row-major index of the cell.
+ * @param val Value to store.
+ */
+static void storeCell(LatinBoard *board, size_t index, int val){
+    if(board->cellBytes == 1){
+        ((uint8_t *) board->cells)[index] = (uint8_t) val;
+    } else{
+        ((uint16_t *) board->cells)[index] = (uint16_t) val;
+    }
+}
+
+/**
+ * @brief Checks if a row or column holds a value outside one of its cells.
+ *
+ * @param board The board.
+ * @param first Row-major index of the first cell of the line.
+ * @param step Distance between the cells of the line, 1 for a row or size for a column.
+ * @param skip Position in the line of the cell to leave out.
+ * @param val The value.
+ * @return true if another cell of the line holds the value.
+ */
+static bool lineHolds(const LatinBoard *board, size_t first, size_t step, int skip, int val){
+    for(int k = 0; k < board->size; k++){
+        size_t index = first + (size_t) k * step;
+        int cell = (board->cellBytes == 1) ? ((const uint8_t *) board->cells)[index] : ((const uint16_t *) board->cells)[index];
+        if(k != skip && cell == val){
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Removes a value of a cell from the mask of its row or column.
+ *
+ * The bit is only cleared when no other cell of the line holds the value, which can only
+ * happen while the board has repeats, so a consistent board never scans the line.
+ *
+ * @param board The board.
+ * @param mask The mask of the line.
+ * @param first Row-major index of the first cell of the line.
+ * @param step Distance between the cells of the line, 1 for a row or size for a column.
+ * @param skip Position of the cell in the line.
+ * @param val The value removed.
+ */
+static void releaseValue(LatinBoard *board, uint64_t *mask, size_t first, size_t step, int skip, int val){
+    if(board->repeats > 0 && lineHolds(board, first, step, skip, val)){
+        board->repeats--;
+        return;
+    }
+    mask[val / 64] &= ~(UINT64_C(1) << (val % 64));
+}
+
+void setCell(LatinBoard *board, int row, int col, int val){
+    int old = getCell(board, row, col);
+    size_t size = (size_t) board->size;
+    uint64_t *rowMask = board->rowUsed + (size_t) row * board->words;
+    uint64_t *colMask = board->colUsed + (size_t) col * board->words;
+
+    // Remove the old value from the state, the masks keep it if it is repeated in the line
+    if(old != 0){
+        releaseValue(board, rowMask, (size_t) row * size, 1, col, old);
+        releaseValue(board, colMask, (size_t) col, size, row, old);
+        board->valueCount[old]--;
+        board->emptyCells++;
+    }
+
+    // Add the new value to the state, counting it if the line already holds it
+    if(val != 0){
+        uint64_t bit = UINT64_C(1) << (val % 64);
+        board->repeats += ((rowMask[val / 64] & bit) != 0) + ((colMask[val / 64] & bit) != 0);
+        rowMask[val / 64] |= bit;
+        colMask[val / 64] |= bit;
+        board->valueCount[val]++;
+        board->emptyCells--;
+    }
+
+    storeCell(board, (size_t) row * size + col, val);
+}
+
+void setGivenCell(LatinBoard *board, int row, int col, int val){
+    size_t index = (size_t) row * board->size + col;
+    setCell(board, row, col, val);
+    board->given[index / 64] |= UINT64_C(1) << (index % 64);
+}
+
+bool isGivenCell(const LatinBoard *board, int row, int col){
+    size_t index = (size_t) row * board->size + col;
+    return (board->given[index / 64] >> (index % 64)) & 1;
+}
+
+bool rowContains(const LatinBoard *board, int row, int val){
+    const uint64_t *mask = board->rowUsed + (size_t) row * board->words;
+    return (mask[val / 64] >> (val % 64)) & 1;
+}
+
+bool columnContains(const LatinBoard *board, int col, int val){
+    const uint64_t *mask = board->colUsed + (size_t) col * board->words;
+    return (mask[val / 64] >> (val % 64)) & 1;
+}
+
+
+#ifdef DEBUG_LBOARD
+
+int main(){
+    int sizes[] = { 4, 300 }; // 8-bit and 16-bit cells
+
+    for(int t = 0; t < 2; t++){
+        LatinBoard *board = NULL;
+        int n = sizes[t];
+        if(initLatinBoard(&board, n) != EXIT_SUCCESS){
+            printf("Failed to allocate a %dx%d board.\n", n, n);
+            return EXIT_FAILURE;
+        }
+        printf("Testing %dx%d board with %d-byte cells...\n", n, n, board->cellBytes);
+
+        // Fill the cyclic square (i + j) mod n + 1, with the first row given
+        for(int i = 0; i < n; i++){
+            for(int j = 0; j < n; j++){
+                if(i == 0){
+                    setGivenCell(board, i, j, (i + j) % n + 1);
+                } else{
+                    setCell(board, i, j, (i + j) % n + 1);
+                }
+            }
+        }
+        printf("Empty cells after filling: %ld (expected 0)\n", board->emptyCells);
+        printf("Value %d appears %d times (expected %d)\n", n, board->valueCount[n], n);
+
+        // Clear a cell and check the occupancy state
+        int val = getCell(board, n - 1, n - 1);
+        setCell(board, n - 1, n - 1, 0);
+        printf("After clearing: row has %d: %d, column has %d: %d (expected 0, 0)\n",
+               val, rowContains(board, n - 1, val), val, columnContains(board, n - 1, val));
+        printf("Given cells: (0,0) %d, (1,0) %d (expected 1, 0)\n", isGivenCell(board, 0, 0), isGivenCell(board, 1, 0));
+
+        freeLatinBoard(board);
+    }
+
+    // A repeated value stays in the masks until its last cell in the line is cleared
+    LatinBoard *board = NULL;
+    initLatinBoard(&board, 4);
+    setCell(board, 0, 0, 1);
+    setCell(board, 0, 1, 1);
+    setCell(board, 0, 0, 0);
+    int kept = rowContains(board, 0, 1);
+    setCell(board, 0, 1, 0);
+    printf("Repeated value: kept %d, then cleared %d, repeats %ld (expected 1, 1, 0)\n", kept, !rowContains(board, 0, 1), board->repeats);
+    freeLatinBoard(board);
+
+    printf("Board test completed.\n");
+    return 0;
+}
+#endif // DEBUG_LBOARD
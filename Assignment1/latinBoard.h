@@ -0,0 +1,145 @@
+/**
+ * @file latinBoard.h
+ * @brief Header file for the dynamically sized board of a Latin Square.
+ *
+ * The board of an n x n Latin Square is kept in a single row-major allocation, with cells
+ * of the narrowest type that holds the values 0..n (`uint8_t` up to 255, `uint16_t` above).
+ * Pre-given cells are marked in a separate bitset, so cell values are never negative.
+ *
+ * The board also keeps its occupancy state: a bitmask of the values used in every row and
+ * column, the number of cells holding each value and the number of empty cells. The state
+ * is updated on every change of a cell, so a move is validated in constant time.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs
+ */
+
+#ifndef LATINBOARD_H
+#define LATINBOARD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define MAX_SIZE 65535 /**< Maximum size of a Latin Square (largest value of a 16-bit cell). */
+#define SMALL_SIZE 255 /**< Largest size of a Latin Square with 8-bit cells. */
+
+/**
+ * @brief The board of a Latin Square together with its occupancy state.
+ */
+typedef struct {
+    int size; /**< Number of rows and columns. */
+    int cellBytes; /**< Bytes per cell, 1 or 2. */
+    void *cells; /**< size x size values in row-major order, 0 for an empty cell. */
+    uint64_t *given; /**< Bit row * size + col is set for pre-given cells. */
+    int words; /**< 64-bit words of each row and column mask (bit val for values 1..size). */
+    uint64_t *rowUsed; /**< Values used in each row, `words` words per row. */
+    uint64_t *colUsed; /**< Values used in each column, `words` words per column. */
+    int *valueCount; /**< Number of cells holding each value (index 0 unused). */
+    long emptyCells; /**< Number of cells that are still empty. */
+    long repeats; /**< Values placed in a row or column that already held them, 0 on a consistent board. */
+} LatinBoard;
+
+
+/**
+ * @brief Allocates an empty board of the given size.
+ *
+ * @param board Pointer to store the allocated board.
+ * @param size Number of rows and columns, from 1 to MAX_SIZE.
+ * @return EXIT_SUCCESS on success, or EXIT_FAILURE if the size is invalid or memory runs out.
+ */
+int initLatinBoard(LatinBoard **board, int size);
+
+
+/**
+ * @brief Frees a board.
+ *
+ * @param board The board to free (may be NULL).
+ */
+void freeLatinBoard(LatinBoard *board);
+
+
+/**
+ * @brief Empties every cell of a board and clears its pre-given cells and occupancy state.
+ *
+ * @param board The board to clear.
+ */
+void clearLatinBoard(LatinBoard *board);
+
+
+/**
+ * @brief Allocates a copy of a board, including its pre-given cells and occupancy state.
+ *
+ * @param copy Pointer to store the allocated copy.
+ * @param board The board to copy.
+ * @return EXIT_SUCCESS on success, or EXIT_FAILURE if memory runs out.
+ */
+int copyLatinBoard(LatinBoard **copy, const LatinBoard *board);
+
+
+/**
+ * @brief Returns the value of a cell.
+ *
+ * @param board The board.
+ * @param row Row index (0-based).
+ * @param col Column index (0-based).
+ * @return The value of the cell, or 0 if it is empty.
+ */
+int getCell(const LatinBoard *board, int row, int col);
+
+
+/**
+ * @brief Sets a cell of the board and updates its occupancy state.
+ *
+ * @param board The board.
+ * @param row Row index (0-based).
+ * @param col Column index (0-based).
+ * @param val Value to store (1..size), or 0 to clear the cell.
+ */
+void setCell(LatinBoard *board, int row, int col, int val);
+
+
+/**
+ * @brief Sets a cell and marks it as pre-given.
+ *
+ * @param board The board.
+ * @param row Row index (0-based).
+ * @param col Column index (0-based).
+ * @param val Value of the cell (1..size).
+ */
+void setGivenCell(LatinBoard *board, int row, int col, int val);
+
+
+/**
+ * @brief Checks if a cell is pre-given.
+ *
+ * @param board The board.
+ * @param row Row index (0-based).
+ * @param col Column index (0-based).
+ * @return true if the cell can't be modified.
+ */
+bool isGivenCell(const LatinBoard *board, int row, int col);
+
+
+/**
+ * @brief Checks if a value is used in a row.
+ *
+ * @param board The board.
+ * @param row Row index (0-based).
+ * @param val Value to look for (1..size).
+ * @return true if some cell of the row holds the value.
+ */
+bool rowContains(const LatinBoard *board, int row, int val);
+
+
+/**
+ * @brief Checks if a value is used in a column.
+ *
+ * @param board The board.
+ * @param col Column index (0-based).
+ * @param val Value to look for (1..size).
+ * @return true if some cell of the column holds the value.
+ */
+bool columnContains(const LatinBoard *board, int col, int val);
+
+#endif // LATINBOARD_H
@@ -0,0 +1,285 @@
+/**
+ * @file latinCache.c
+ * @brief Implementation of the persistent cache of Latin Square solutions.
+ *
+ * This file provides the loading and appending of the cache file, the hash table of its
+ * entries and the solving of a board through the cache.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "latinCache.h"
+#include "latinCanon.h"
+#include "latinFile.h"
+#include "latinParallel.h"
+#include "latinStats.h"
+#include "latinVerify.h"
+
+/**
+ * @brief Checks if the pre-given cells of a stored solution are a canonical puzzle.
+ *
+ * @param solution The stored solution.
+ * @param canonical The canonical puzzle, whose filled cells are all pre-given.
+ * @return true if both have the same size and the same pre-given cells.
+ */
+static bool samePuzzle(const LatinBoard *solution, const LatinBoard *canonical){
+    if(solution->size != canonical->size){
+        return false;
+    }
+
+    size_t cells = (size_t) solution->size * (size_t) solution->size;
+    if(memcmp(solution->given, canonical->given, (cells + 63) / 64 * sizeof(uint64_t)) != 0){
+        return false;
+    }
+    for(int i = 0; i < solution->size; i++){
+        for(int j = 0; j < solution->size; j++){
+            if(isGivenCell(canonical, i, j) && getCell(solution, i, j) != getCell(canonical, i, j)){
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Places an entry in the first free slot of its probe sequence.
+ *
+ * @param cache The cache, with at least one free slot.
+ * @param entry Index of the entry.
+ */
+static void placeEntry(LatinCache *cache, long entry){
+    long mask = cache->slotCount - 1;
+    long slot = (long) (cache->entries[entry].hash & (uint64_t) mask);
+    while(cache->slots[slot] != 0){
+        slot = (slot + 1) & mask;
+    }
+    cache->slots[slot] = entry + 1;
+}
+
+/**
+ * @brief Adds an entry to the table, growing it when needed.
+ *
+ * @param cache The cache.
+ * @param solution The canonical solution, taken over by the cache on success.
+ * @param hash The hash of its canonical puzzle.
+ * @return EXIT_SUCCESS on success, or EXIT_FAILURE if memory runs out.
+ */
+static int addEntry(LatinCache *cache, LatinBoard *solution, uint64_t hash){
+    if(cache->count == cache->capacity){
+        long capacity = 2 * cache->capacity;
+        CacheEntry *entries = (CacheEntry *) realloc(cache->entries, (size_t) capacity * sizeof(CacheEntry));
+        if(entries == NULL){
+            return EXIT_FAILURE;
+        }
+        cache->entries = entries;
+        cache->capacity = capacity;
+    }
+
+    // Keep the table at most half full, so the probe sequences stay short
+    if(2 * (cache->count + 1) > cache->slotCount){
+        long *slots = (long *) calloc(2 * (size_t) cache->slotCount, sizeof(long));
+        if(slots == NULL){
+            return EXIT_FAILURE;
+        }
+        free(cache->slots);
+        cache->slots = slots;
+        cache->slotCount *= 2;
+        for(long k = 0; k < cache->count; k++){
+            placeEntry(cache, k);
+        }
+    }
+
+    cache->entries[cache->count].hash = hash;
+    cache->entries[cache->count].solution = solution;
+    placeEntry(cache, cache->count);
+    cache->count++;
+    return EXIT_SUCCESS;
+}
+
+int openLatinCache(LatinCache **cache, const char *filename){
+    *cache = (LatinCache *) malloc(sizeof(LatinCache));
+    if(*cache == NULL){
+        return EXIT_FAILURE;
+    }
+
+    LatinCache *c = *cache;
+    c->count = 0;
+    c->capacity = CACHE_SLOTS / 2;
+    c->slotCount = CACHE_SLOTS;
+    c->filename = filename;
+    c->file = NULL;
+    c->entries = (CacheEntry *) malloc((size_t) c->capacity * sizeof(CacheEntry));
+    c->slots = (long *) calloc((size_t) c->slotCount, sizeof(long));
+    if(c->entries == NULL || c->slots == NULL){
+        closeLatinCache(c);
+        *cache = NULL;
+        return EXIT_FAILURE;
+    }
+
+    LatinReader *reader = NULL;
+    if(openLatinReader(&reader, filename) != EXIT_SUCCESS){
+        if(errno == ENOENT){ // a new cache
+            return EXIT_SUCCESS;
+        }
+        closeLatinCache(c);
+        *cache = NULL;
+        return EXIT_FAILURE;
+    }
+
+    // Load every entry that is a completed square, the rest of a damaged file is dropped
+    int status = EXIT_SUCCESS;
+    long dropped = 0;
+    while(status != READ_END && status != READ_FATAL){
+        LatinBoard *solution = NULL;
+        const char *error = NULL;
+        char violation[VIOLATION_LENGTH];
+        status = scanLatinSquare(reader, &solution, &error);
+        if(status == EXIT_SUCCESS && verifyLatinSquare(solution, NULL, violation, sizeof(violation)) == EXIT_SUCCESS
+           && addEntry(c, solution, hashLatinPuzzle(solution)) == EXIT_SUCCESS){
+            continue;
+        }
+        if(status != READ_END){
+            dropped++;
+        }
+        freeLatinBoard(solution);
+    }
+    closeLatinReader(reader);
+
+    if(dropped > 0){
+        fprintf(stderr, "Dropped %ld damaged entries of the cache %s.\n", dropped, filename);
+    }
+    return EXIT_SUCCESS;
+}
+
+void closeLatinCache(LatinCache *cache){
+    if(cache == NULL){
+        return;
+    }
+
+    for(long k = 0; k < cache->count; k++){
+        freeLatinBoard(cache->entries[k].solution);
+    }
+    if(cache->file != NULL){
+        fclose(cache->file);
+    }
+    free(cache->entries);
+    free(cache->slots);
+    free(cache);
+}
+
+const LatinBoard *findCachedSolution(const LatinCache *cache, const LatinBoard *canonical, uint64_t hash){
+    long mask = cache->slotCount - 1;
+    for(long slot = (long) (hash & (uint64_t) mask); cache->slots[slot] != 0; slot = (slot + 1) & mask){
+        const CacheEntry *entry = &cache->entries[cache->slots[slot] - 1];
+        if(entry->hash == hash && samePuzzle(entry->solution, canonical)){
+            return entry->solution;
+        }
+    }
+    return NULL;
+}
+
+int storeCachedSolution(LatinCache *cache, LatinBoard *solution, uint64_t hash){
+    if(addEntry(cache, solution, hash) != EXIT_SUCCESS){
+        freeLatinBoard(solution);
+        return EXIT_FAILURE;
+    }
+
+    if(cache->file == NULL){
+        cache->file = fopen(cache->filename, "ab");
+        if(cache->file == NULL){
+            return EXIT_FAILURE; // the entry is still used by this run
+        }
+    }
+    printBoardImage(cache->file, solution);
+    return (fflush(cache->file) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int solveCachedLatinSquare(LatinCache *cache, LatinBoard *board, int threads){
+    LatinBoard *canonical = NULL;
+    LatinIsotopy *isotopy = NULL;
+    if(cache == NULL || canonicalizeLatinSquare(board, &canonical, &isotopy) != EXIT_SUCCESS){
+        return solveParallel(board, threads);
+    }
+
+    // A hit is permuted back onto the empty cells of the board
+    uint64_t hash = hashLatinPuzzle(canonical);
+    const LatinBoard *cached = findCachedSolution(cache, canonical, hash);
+    if(cached != NULL){
+        mapFromCanonical(isotopy, cached, board);
+        latinStats.cacheHits++;
+        freeLatinBoard(canonical);
+        freeLatinIsotopy(isotopy);
+        return EXIT_SUCCESS;
+    }
+
+    latinStats.cacheMisses++;
+    int status = solveParallel(board, threads);
+    if(status == EXIT_SUCCESS){
+        mapToCanonical(isotopy, board, canonical);
+        if(storeCachedSolution(cache, canonical, hash) != EXIT_SUCCESS){
+            fprintf(stderr, "Unable to write to the cache %s.\n", cache->filename);
+        }
+    } else{
+        freeLatinBoard(canonical);
+    }
+    freeLatinIsotopy(isotopy);
+    return status;
+}
+
+
+#ifdef DEBUG_LCACHE
+
+int main(){
+    const char *fileName = "latinCacheTest.lsq";
+    remove(fileName);
+
+    // A puzzle and a row, column and value permutation of it
+    int n = 5;
+    int rows[] = { 2, 0, 4, 1, 3 }, cols[] = { 1, 3, 0, 4, 2 }, vals[] = { 0, 3, 5, 1, 2, 4 };
+    LatinBoard *puzzle = NULL, *permuted = NULL;
+    initLatinBoard(&puzzle, n);
+    initLatinBoard(&permuted, n);
+    for(int i = 0; i < n; i++){
+        for(int j = 0; j < n; j++){
+            if((2 * i + j * j + i * j) % 4 == 0){
+                setGivenCell(puzzle, i, j, (i + 2 * j) % n + 1);
+                setGivenCell(permuted, rows[i], cols[j], vals[(i + 2 * j) % n + 1]);
+            }
+        }
+    }
+
+    LatinCache *cache = NULL;
+    if(openLatinCache(&cache, fileName) != EXIT_SUCCESS){
+        printf("Unable to open the cache.\n");
+        return EXIT_FAILURE;
+    }
+    int first = solveCachedLatinSquare(cache, puzzle, 1);
+    printf("First puzzle solved: %d, misses %lld, entries %ld (expected 1, 1, 1)\n", first == EXIT_SUCCESS, latinStats.cacheMisses, cache->count);
+    closeLatinCache(cache);
+
+    // The permuted puzzle is answered from the file without searching
+    openLatinCache(&cache, fileName);
+    LatinBoard *copy = NULL;
+    char violation[VIOLATION_LENGTH];
+    copyLatinBoard(&copy, permuted);
+    int second = solveCachedLatinSquare(cache, copy, 1);
+    int valid = verifyLatinSquare(copy, permuted, violation, sizeof(violation));
+    printf("Permuted puzzle solved: %d, hits %lld, loaded entries %ld: %s (expected 1, 1, 1: pass)\n", second == EXIT_SUCCESS,
+           latinStats.cacheHits, cache->count, (valid == EXIT_SUCCESS) ? "pass" : violation);
+    closeLatinCache(cache);
+
+    freeLatinBoard(puzzle);
+    freeLatinBoard(permuted);
+    freeLatinBoard(copy);
+    remove(fileName);
+    printf("Cache test completed.\n");
+    return 0;
+}
+#endif // DEBUG_LCACHE
@@ -0,0 +1,108 @@
+/**
+ * @file latinCache.h
+ * @brief Header file for the persistent cache of Latin Square solutions (`--cache`).
+ *
+ * The cache maps the canonical form of a puzzle (see latinCanon.h) to a solution of that
+ * canonical form, so a puzzle that is a permutation of one solved before is answered by
+ * permuting the stored solution back, without searching.
+ *
+ * The cache file is a stream of board images, one per entry: the cells are the canonical
+ * solution and the pre-given cells mark the canonical puzzle, so an entry needs no other
+ * key. The permutation back to a puzzle is the inverse of the one that canonicalized it,
+ * so it is never stored. New entries are appended to the file as they are solved, and the
+ * entries are checked when the file is loaded, so a damaged entry is dropped instead of
+ * giving a wrong answer.
+ *
+ * In memory the entries are kept in an open-addressing hash table of their puzzle hashes,
+ * and a hit is only taken when the pre-given cells of the entry equal the canonical puzzle.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs
+ */
+
+#ifndef LATINCACHE_H
+#define LATINCACHE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "latinBoard.h"
+
+#define CACHE_SLOTS 1024 /**< Initial number of slots of the hash table, a power of two. */
+
+/**
+ * @brief One stored solution.
+ */
+typedef struct {
+    uint64_t hash; /**< Hash of the canonical puzzle. */
+    LatinBoard *solution; /**< Canonical solution, its pre-given cells are the canonical puzzle. */
+} CacheEntry;
+
+/**
+ * @brief The solutions loaded from and appended to a cache file.
+ */
+typedef struct {
+    CacheEntry *entries; /**< The stored solutions. */
+    long count; /**< Number of entries. */
+    long capacity; /**< Number of entries allocated. */
+    long *slots; /**< Index + 1 of the entry in each slot of the hash table, 0 if free. */
+    long slotCount; /**< Number of slots, kept at least twice the number of entries. */
+    const char *filename; /**< Name of the cache file. */
+    FILE *file; /**< The cache file opened for appending, NULL until the first new entry. */
+} LatinCache;
+
+
+/**
+ * @brief Loads the cache of a file, which is created with the first new entry if it doesn't exist.
+ *
+ * @param cache Pointer to store the allocated cache.
+ * @param filename The name of the cache file.
+ * @return EXIT_SUCCESS on success, or EXIT_FAILURE if the file can't be read or memory runs out.
+ */
+int openLatinCache(LatinCache **cache, const char *filename);
+
+
+/**
+ * @brief Frees a cache and closes its file.
+ *
+ * @param cache The cache to free (may be NULL).
+ */
+void closeLatinCache(LatinCache *cache);
+
+
+/**
+ * @brief Finds the stored solution of a canonical puzzle.
+ *
+ * @param cache The cache.
+ * @param canonical The canonical puzzle, as made by canonicalizeLatinSquare.
+ * @param hash The hash of the canonical puzzle.
+ * @return The canonical solution, or NULL if none is stored.
+ */
+const LatinBoard *findCachedSolution(const LatinCache *cache, const LatinBoard *canonical, uint64_t hash);
+
+
+/**
+ * @brief Adds the solution of a canonical puzzle to the cache and appends it to its file.
+ *
+ * @param cache The cache.
+ * @param solution The canonical solution, whose pre-given cells are the canonical puzzle.
+ *                 The cache takes it over, even on failure.
+ * @param hash The hash of the canonical puzzle.
+ * @return EXIT_SUCCESS on success, or EXIT_FAILURE if memory runs out or the file can't be written.
+ */
+int storeCachedSolution(LatinCache *cache, LatinBoard *solution, uint64_t hash);
+
+
+/**
+ * @brief Fills a board with a solution, from the cache when it holds one for its canonical form.
+ *
+ * A solution that is searched for is added to the cache. Hits and misses are counted in
+ * the statistics of the run.
+ *
+ * @param cache The cache, or NULL to always search.
+ * @param board The board to solve.
+ * @param threads Number of threads to search on.
+ * @return EXIT_SUCCESS if the board was solved, or EXIT_FAILURE as solveParallel.
+ */
+int solveCachedLatinSquare(LatinCache *cache, LatinBoard *board, int threads);
+
+#endif // LATINCACHE_H
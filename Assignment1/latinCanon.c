@@ -0,0 +1,320 @@
+/**
+ * @file latinCanon.c
+ * @brief Implementation of the canonical form of Latin Square puzzles.
+ *
+ * This file provides the color refinement of the rows, columns and values of a board, the
+ * canonical board it orders, the mapping of boards to and from their canonical form, and
+ * the hash of a puzzle.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "latinCanon.h"
+
+#define FNV_OFFSET UINT64_C(14695981039346656037) /**< Initial value of a FNV-1a hash. */
+#define FNV_PRIME UINT64_C(1099511628211) /**< Multiplier of a FNV-1a hash. */
+
+/**
+ * @brief A row, column or value with its color, for sorting.
+ */
+typedef struct {
+    uint64_t color; /**< Color after the last round of refinement. */
+    int index; /**< The row, column or value. */
+} ColoredPart;
+
+/**
+ * @brief Scrambles a 64-bit value (the finalizer of splitmix64).
+ *
+ * @param x The value.
+ * @return The scrambled value.
+ */
+static uint64_t mix(uint64_t x){
+    x ^= x >> 30;
+    x *= UINT64_C(0xbf58476d1ce4e5b9);
+    x ^= x >> 27;
+    x *= UINT64_C(0x94d049bb133111eb);
+    x ^= x >> 31;
+    return x;
+}
+
+/**
+ * @brief Hashes an ordered pair of colors.
+ *
+ * @param first The first color.
+ * @param second The second color.
+ * @return The hash of the pair.
+ */
+static uint64_t mixPair(uint64_t first, uint64_t second){
+    return mix(first + mix(second ^ UINT64_C(0x9e3779b97f4a7c15)));
+}
+
+/**
+ * @brief Orders parts by color, then by index.
+ *
+ * @param a The first part.
+ * @param b The second part.
+ * @return A negative, zero or positive number, as for qsort.
+ */
+static int compareParts(const void *a, const void *b){
+    const ColoredPart *x = (const ColoredPart *) a;
+    const ColoredPart *y = (const ColoredPart *) b;
+    if(x->color != y->color){
+        return (x->color < y->color) ? -1 : 1;
+    }
+    return x->index - y->index;
+}
+
+/**
+ * @brief Sorts parts by color and stores their order.
+ *
+ * @param parts Scratch array of `count` parts.
+ * @param colors Color of each part, indexed from `first`.
+ * @param first Index of the first part.
+ * @param count Number of parts.
+ * @param order Index of the part at each position of the order.
+ */
+static void orderParts(ColoredPart *parts, const uint64_t *colors, int first, int count, int *order){
+    for(int k = 0; k < count; k++){
+        parts[k].color = colors[first + k];
+        parts[k].index = first + k;
+    }
+    qsort(parts, (size_t) count, sizeof(ColoredPart), compareParts);
+    for(int k = 0; k < count; k++){
+        order[k] = parts[k].index;
+    }
+}
+
+/**
+ * @brief Allocates a permutation of the given size.
+ *
+ * @param size Number of rows and columns.
+ * @return The permutation, or NULL if memory runs out.
+ */
+static LatinIsotopy *allocIsotopy(int size){
+    LatinIsotopy *isotopy = (LatinIsotopy *) malloc(sizeof(LatinIsotopy));
+    if(isotopy == NULL){
+        return NULL;
+    }
+
+    isotopy->size = size;
+    isotopy->rows = (int *) malloc((size_t) size * sizeof(int));
+    isotopy->cols = (int *) malloc((size_t) size * sizeof(int));
+    isotopy->symbols = (int *) malloc(((size_t) size + 1) * sizeof(int));
+    isotopy->inverse = (int *) malloc(((size_t) size + 1) * sizeof(int));
+    if(isotopy->rows == NULL || isotopy->cols == NULL || isotopy->symbols == NULL || isotopy->inverse == NULL){
+        freeLatinIsotopy(isotopy);
+        return NULL;
+    }
+    return isotopy;
+}
+
+/**
+ * @brief Refines the colors of the rows, columns and values of a board.
+ *
+ * @param board The board.
+ * @param colors Colors of the rows (0..size-1), the columns (size..2*size-1) and the values
+ *               (2*size+1..3*size), set to the number of their filled cells.
+ * @param next Scratch array of the same size.
+ */
+static void refineColors(const LatinBoard *board, uint64_t *colors, uint64_t *next){
+    int size = board->size;
+    uint64_t *rowColor = colors, *colColor = colors + size, *valColor = colors + 2 * size;
+
+    for(int round = 0; round < REFINE_ROUNDS; round++){
+        for(int k = 0; k <= 3 * size; k++){
+            next[k] = mix(colors[k] + (uint64_t) round);
+        }
+
+        // Every filled cell adds the colors of its other two parts, so the order of the cells doesn't matter
+        for(int i = 0; i < size; i++){
+            for(int j = 0; j < size; j++){
+                int val = getCell(board, i, j);
+                if(val != 0){
+                    next[i] += mixPair(colColor[j], valColor[val]);
+                    next[size + j] += mixPair(rowColor[i], valColor[val]);
+                    next[2 * size + val] += mixPair(rowColor[i], colColor[j]);
+                }
+            }
+        }
+
+        for(int k = 0; k <= 3 * size; k++){
+            colors[k] = next[k];
+        }
+    }
+}
+
+int canonicalizeLatinSquare(const LatinBoard *board, LatinBoard **canonical, LatinIsotopy **isotopy){
+    int size = board->size;
+    LatinIsotopy *iso = allocIsotopy(size);
+    uint64_t *colors = (uint64_t *) calloc(3 * (size_t) size + 1, sizeof(uint64_t));
+    uint64_t *next = (uint64_t *) malloc((3 * (size_t) size + 1) * sizeof(uint64_t));
+    ColoredPart *parts = (ColoredPart *) malloc((size_t) size * sizeof(ColoredPart));
+    if(iso == NULL || colors == NULL || next == NULL || parts == NULL || initLatinBoard(canonical, size) != EXIT_SUCCESS){
+        freeLatinIsotopy(iso);
+        free(colors);
+        free(next);
+        free(parts);
+        return EXIT_FAILURE;
+    }
+
+    // Start from the number of filled cells of every part
+    for(int i = 0; i < size; i++){
+        for(int j = 0; j < size; j++){
+            if(getCell(board, i, j) != 0){
+                colors[i]++;
+                colors[size + j]++;
+            }
+        }
+    }
+    for(int val = 1; val <= size; val++){
+        colors[2 * size + val] = (uint64_t) board->valueCount[val];
+    }
+    refineColors(board, colors, next);
+
+    // Order the rows and columns by color, then renumber the values in the order they first appear
+    orderParts(parts, colors, 0, size, iso->rows);
+    orderParts(parts, colors, size, size, iso->cols);
+    for(int k = 0; k < size; k++){
+        iso->cols[k] -= size;
+    }
+    for(int val = 0; val <= size; val++){
+        iso->symbols[val] = 0;
+    }
+    int symbols = 0;
+    for(int i = 0; i < size; i++){
+        for(int j = 0; j < size; j++){
+            int val = getCell(board, iso->rows[i], iso->cols[j]);
+            if(val != 0 && iso->symbols[val] == 0){
+                iso->symbols[val] = ++symbols;
+            }
+        }
+    }
+    for(int val = 1; val <= size; val++){ // values that never appear are interchangeable
+        if(iso->symbols[val] == 0){
+            iso->symbols[val] = ++symbols;
+        }
+    }
+    iso->inverse[0] = 0;
+    for(int val = 1; val <= size; val++){
+        iso->inverse[iso->symbols[val]] = val;
+    }
+
+    for(int i = 0; i < size; i++){
+        for(int j = 0; j < size; j++){
+            int val = getCell(board, iso->rows[i], iso->cols[j]);
+            if(val != 0){
+                setGivenCell(*canonical, i, j, iso->symbols[val]);
+            }
+        }
+    }
+
+    free(colors);
+    free(next);
+    free(parts);
+    *isotopy = iso;
+    return EXIT_SUCCESS;
+}
+
+void freeLatinIsotopy(LatinIsotopy *isotopy){
+    if(isotopy == NULL){
+        return;
+    }
+
+    free(isotopy->rows);
+    free(isotopy->cols);
+    free(isotopy->symbols);
+    free(isotopy->inverse);
+    free(isotopy);
+}
+
+void mapToCanonical(const LatinIsotopy *isotopy, const LatinBoard *board, LatinBoard *canonical){
+    for(int i = 0; i < isotopy->size; i++){
+        for(int j = 0; j < isotopy->size; j++){
+            int val = getCell(board, isotopy->rows[i], isotopy->cols[j]);
+            if(val != 0 && getCell(canonical, i, j) == 0){
+                setCell(canonical, i, j, isotopy->symbols[val]);
+            }
+        }
+    }
+}
+
+void mapFromCanonical(const LatinIsotopy *isotopy, const LatinBoard *canonical, LatinBoard *board){
+    for(int i = 0; i < isotopy->size; i++){
+        for(int j = 0; j < isotopy->size; j++){
+            int val = getCell(canonical, i, j);
+            if(val != 0 && getCell(board, isotopy->rows[i], isotopy->cols[j]) == 0){
+                setCell(board, isotopy->rows[i], isotopy->cols[j], isotopy->inverse[val]);
+            }
+        }
+    }
+}
+
+uint64_t hashLatinPuzzle(const LatinBoard *board){
+    uint64_t hash = (FNV_OFFSET ^ (uint64_t) board->size) * FNV_PRIME;
+    for(int i = 0; i < board->size; i++){
+        for(int j = 0; j < board->size; j++){
+            int val = isGivenCell(board, i, j) ? getCell(board, i, j) : 0;
+            hash = (hash ^ (uint64_t) (val & 0xff)) * FNV_PRIME;
+            hash = (hash ^ (uint64_t) (val >> 8)) * FNV_PRIME;
+        }
+    }
+    return hash;
+}
+
+
+#ifdef DEBUG_LCANON
+
+#include "latinVerify.h"
+
+int main(){
+    int n = 7;
+    LatinBoard *solution = NULL, *puzzle = NULL, *permuted = NULL;
+    initLatinBoard(&solution, n);
+    initLatinBoard(&puzzle, n);
+    initLatinBoard(&permuted, n);
+
+    // Some cells of the cyclic square as a puzzle, and the same puzzle with its rows, columns and values permuted
+    int rows[] = { 3, 0, 6, 5, 1, 4, 2 }, cols[] = { 2, 4, 0, 6, 5, 3, 1 }, vals[] = { 0, 4, 7, 6, 1, 3, 5, 2 };
+    for(int i = 0; i < n; i++){
+        for(int j = 0; j < n; j++){
+            int val = (i + j) % n + 1;
+            setCell(solution, i, j, val);
+            if((i * i + 3 * j + i * j) % 5 == 0){
+                setGivenCell(puzzle, i, j, val);
+                setGivenCell(permuted, rows[i], cols[j], vals[val]);
+            }
+        }
+    }
+
+    LatinBoard *first = NULL, *second = NULL;
+    LatinIsotopy *firstMap = NULL, *secondMap = NULL;
+    if(canonicalizeLatinSquare(puzzle, &first, &firstMap) != EXIT_SUCCESS || canonicalizeLatinSquare(permuted, &second, &secondMap) != EXIT_SUCCESS){
+        printf("Failed to canonicalize the boards.\n");
+        return EXIT_FAILURE;
+    }
+    printf("Same canonical hash: %d (expected 1)\n", hashLatinPuzzle(first) == hashLatinPuzzle(second));
+
+    // The solution of the first puzzle, through the canonical form, solves the second
+    LatinBoard *answer = NULL;
+    char violation[VIOLATION_LENGTH];
+    copyLatinBoard(&answer, permuted);
+    mapToCanonical(firstMap, solution, first);
+    mapFromCanonical(secondMap, first, answer);
+    int status = verifyLatinSquare(answer, permuted, violation, sizeof(violation));
+    printf("Mapped solution of the permuted puzzle: %s (expected pass)\n", (status == EXIT_SUCCESS) ? "pass" : violation);
+
+    freeLatinBoard(solution);
+    freeLatinBoard(puzzle);
+    freeLatinBoard(permuted);
+    freeLatinBoard(answer);
+    freeLatinBoard(first);
+    freeLatinBoard(second);
+    freeLatinIsotopy(firstMap);
+    freeLatinIsotopy(secondMap);
+    printf("Canonical form test completed.\n");
+    return 0;
+}
+#endif // DEBUG_LCANON
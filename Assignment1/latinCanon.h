@@ -0,0 +1,89 @@
+/**
+ * @file latinCanon.h
+ * @brief Header file for the canonical form of Latin Square puzzles.
+ *
+ * Permuting the rows, the columns or the values of a puzzle (an isotopy) gives a puzzle
+ * with the same solutions up to the same permutation. The canonical form orders the rows,
+ * columns and values of a puzzle by invariants that no isotopy changes, so most isotopic
+ * puzzles have the same canonical form and one solution serves all of them.
+ *
+ * The invariants come from color refinement: every row, column and value starts with the
+ * number of its filled cells, and in every round it is recolored with the colors of the
+ * other two parts of its filled cells. The rows and columns are sorted by color, and the
+ * values are renumbered in the order they first appear on the sorted board. Rows or columns
+ * that still share a color are left in their original order, so puzzles with such ties may
+ * get different forms, which only costs a solution cache a hit.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs
+ */
+
+#ifndef LATINCANON_H
+#define LATINCANON_H
+
+#include <stdint.h>
+#include "latinBoard.h"
+
+#define REFINE_ROUNDS 4 /**< Rounds of color refinement. */
+
+/**
+ * @brief The permutation from a board to its canonical form.
+ */
+typedef struct {
+    int size; /**< Number of rows and columns. */
+    int *rows; /**< Row of the board at each canonical row. */
+    int *cols; /**< Column of the board at each canonical column. */
+    int *symbols; /**< Canonical value of each value of the board, symbols[0] = 0. */
+    int *inverse; /**< Value of the board of each canonical value, inverse[0] = 0. */
+} LatinIsotopy;
+
+
+/**
+ * @brief Computes the canonical form of the filled cells of a board.
+ *
+ * @param board The board.
+ * @param canonical Pointer to store the allocated canonical board, where every filled cell
+ *                  of the board is a pre-given cell.
+ * @param isotopy Pointer to store the allocated permutation from the board to its canonical form.
+ * @return EXIT_SUCCESS on success, or EXIT_FAILURE if memory runs out.
+ */
+int canonicalizeLatinSquare(const LatinBoard *board, LatinBoard **canonical, LatinIsotopy **isotopy);
+
+
+/**
+ * @brief Frees a permutation.
+ *
+ * @param isotopy The permutation to free (may be NULL).
+ */
+void freeLatinIsotopy(LatinIsotopy *isotopy);
+
+
+/**
+ * @brief Fills the empty cells of a canonical board with the permuted cells of the board.
+ *
+ * @param isotopy The permutation from the board to the canonical board.
+ * @param board The board, usually solved.
+ * @param canonical The canonical board to fill.
+ */
+void mapToCanonical(const LatinIsotopy *isotopy, const LatinBoard *board, LatinBoard *canonical);
+
+
+/**
+ * @brief Fills the empty cells of a board with the cells of a canonical board, permuted back.
+ *
+ * @param isotopy The permutation from the board to the canonical board.
+ * @param canonical The canonical board, usually solved.
+ * @param board The board to fill.
+ */
+void mapFromCanonical(const LatinIsotopy *isotopy, const LatinBoard *canonical, LatinBoard *board);
+
+
+/**
+ * @brief Hashes the size and the pre-given cells of a board (FNV-1a).
+ *
+ * @param board The board.
+ * @return The hash, the same for boards with the same pre-given cells whatever their other cells.
+ */
+uint64_t hashLatinPuzzle(const LatinBoard *board);
+
+#endif // LATINCANON_H
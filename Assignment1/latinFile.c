@@ -0,0 +1,756 @@
+/**
+ * @file latinFile.c
+ * @brief Implementation of reading and writing Latin Squares in their text and binary formats.
+ *
+ * This file provides the reader and writer of Latin Square records shared by the game,
+ * the solver and the batch mode.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "latinFile.h"
+
+#define NUMBER_LIMIT 1000000000000LL /**< Parsed numbers saturate here, far outside any valid value. */
+#define SMALL_OUTPUT 4096 /**< Bytes of the output buffer kept on the stack. */
+#define FAILED_RECORD "The Latin Square of the record was not solved." /**< Error of a record of size 0. */
+
+
+/**
+ * @brief Tries to memory-map a regular file.
+ *
+ * @param reader The reader to fill with the mapping.
+ * @param filename The name of the file.
+ * @return EXIT_SUCCESS if the file was mapped (or is empty), or EXIT_FAILURE if it must be read instead.
+ */
+static int mapInput(LatinReader *reader, const char *filename){
+    int fd = open(filename, O_RDONLY);
+    if(fd < 0){
+        return EXIT_FAILURE;
+    }
+
+    struct stat info;
+    if(fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)){
+        close(fd);
+        return EXIT_FAILURE; // pipes and devices are read through the buffer
+    }
+
+    reader->length = (size_t) info.st_size;
+    reader->mapped = true;
+    if(reader->length == 0){ // empty files can't be mapped, there is nothing to read anyway
+        close(fd);
+        reader->data = NULL;
+        return EXIT_SUCCESS;
+    }
+
+    void *mapping = mmap(NULL, reader->length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping stays valid without the descriptor
+    if(mapping == MAP_FAILED){
+        reader->mapped = false;
+        reader->length = 0;
+        return EXIT_FAILURE;
+    }
+
+    posix_madvise(mapping, reader->length, POSIX_MADV_SEQUENTIAL); // only a hint, failure is harmless
+    reader->data = (char *) mapping;
+    return EXIT_SUCCESS;
+}
+
+int openLatinReader(LatinReader **reader, const char *filename){
+    *reader = (LatinReader *) malloc(sizeof(LatinReader));
+    if(*reader == NULL){
+        return EXIT_FAILURE;
+    }
+
+    LatinReader *r = *reader;
+    r->data = NULL;
+    r->length = 0;
+    r->position = 0;
+    r->mapped = false;
+    r->file = NULL;
+    r->failedRecords = false;
+
+    bool useStdin = (strcmp(filename, STDIN_NAME) == 0);
+    if(!useStdin && mapInput(r, filename) == EXIT_SUCCESS){
+        return EXIT_SUCCESS;
+    }
+
+    // Fall back to reading the input in chunks
+    r->file = useStdin ? stdin : fopen(filename, "r");
+    r->data = (char *) malloc(INPUT_CHUNK_SIZE);
+    if(r->file == NULL || r->data == NULL){
+        if(r->file != NULL && !useStdin){
+            fclose(r->file);
+        }
+        free(r->data);
+        free(r);
+        *reader = NULL;
+        return EXIT_FAILURE; // errno is left for the caller's message
+    }
+
+    return EXIT_SUCCESS;
+}
+
+void closeLatinReader(LatinReader *reader){
+    if(reader == NULL){
+        return;
+    }
+
+    if(reader->mapped){
+        if(reader->data != NULL){
+            munmap(reader->data, reader->length);
+        }
+    } else{
+        free(reader->data);
+        if(reader->file != stdin){
+            fclose(reader->file);
+        }
+    }
+    free(reader);
+}
+
+/**
+ * @brief Reads the next chunk of a buffered input.
+ *
+ * Numbers are parsed one byte at a time, so the bytes already parsed can be dropped.
+ *
+ * @param reader The reader.
+ * @return true if more bytes were read, false at the end of the input.
+ */
+static bool fillInput(LatinReader *reader){
+    if(reader->mapped){
+        return false;
+    }
+    reader->length = fread(reader->data, 1, INPUT_CHUNK_SIZE, reader->file);
+    reader->position = 0;
+    return reader->length > 0;
+}
+
+/**
+ * @brief Skips white space and returns the next byte of an input without consuming it.
+ *
+ * @param reader The reader.
+ * @return The next byte, or EOF at the end of the input.
+ */
+static int skipSpace(LatinReader *reader){
+    while(true){
+        if(reader->position == reader->length && !fillInput(reader)){
+            return EOF;
+        }
+        int c = (unsigned char) reader->data[reader->position];
+        if(c != ' ' && (c < '\t' || c > '\r')){
+            return c;
+        }
+        reader->position++;
+    }
+}
+
+/**
+ * @brief Consumes the next byte of an input.
+ *
+ * @param reader The reader.
+ * @return The byte, or EOF at the end of the input.
+ */
+static int nextByte(LatinReader *reader){
+    if(reader->position == reader->length && !fillInput(reader)){
+        return EOF;
+    }
+    return (unsigned char) reader->data[(reader->position)++];
+}
+
+/**
+ * @brief Parses the next number of an input, like `fscanf` with "%d".
+ *
+ * White space before the number is skipped, and the number may have a sign. Numbers too
+ * large for any valid value saturate instead of overflowing.
+ *
+ * @param reader The reader.
+ * @param value Pointer to store the number.
+ * @return 1 if a number was read, 0 if the next item is not a number, or EOF at the end of the input.
+ */
+static int scanNumber(LatinReader *reader, long long *value){
+    int c = skipSpace(reader);
+    if(c == EOF){
+        return EOF;
+    }
+
+    bool negative = (c == '-');
+    if(c == '-' || c == '+'){
+        reader->position++;
+    }
+
+    // Accumulate the digits
+    long long number = 0;
+    int digits = 0;
+    while(reader->position < reader->length || fillInput(reader)){
+        unsigned int digit = (unsigned int) ((unsigned char) reader->data[reader->position] - '0');
+        if(digit > 9){
+            break;
+        }
+        if(number < NUMBER_LIMIT){
+            number = number * 10 + digit;
+        }
+        digits++;
+        reader->position++;
+    }
+
+    if(digits == 0){
+        return 0;
+    }
+    *value = negative ? -number : number;
+    return 1;
+}
+
+/**
+ * @brief Returns an empty board for a record, reusing a spare board of the same size.
+ *
+ * @param spare A board that may be reused, or NULL. Set to NULL if it was used.
+ * @param size Number of rows and columns of the record.
+ * @return The board, or NULL if memory runs out.
+ */
+static LatinBoard *takeBoard(LatinBoard **spare, int size){
+    LatinBoard *b = *spare;
+    if(b != NULL && b->size == size){
+        *spare = NULL;
+        clearLatinBoard(b);
+        return b;
+    }
+
+    b = NULL;
+    return (initLatinBoard(&b, size) == EXIT_SUCCESS) ? b : NULL;
+}
+
+/**
+ * @brief Returns the number of bits a packed cell value takes on a board of a given size.
+ *
+ * @param size Number of rows and columns.
+ * @return The smallest number of bits that holds 0..size.
+ */
+static int cellBits(long long size){
+    int bits = 1;
+    while((1LL << bits) <= size){
+        bits++;
+    }
+    return bits;
+}
+
+/**
+ * @brief Stores a board image header as little-endian bytes.
+ *
+ * @param header The header.
+ * @param bytes Buffer of BOARD_IMAGE_HEADER_SIZE bytes.
+ */
+static void packImageHeader(const BoardImageHeader *header, unsigned char *bytes){
+    memcpy(bytes, header->magic, sizeof(header->magic));
+    bytes[4] = (unsigned char) (header->version & 0xFF);
+    bytes[5] = (unsigned char) (header->version >> 8);
+    bytes[6] = (unsigned char) (header->bits & 0xFF);
+    bytes[7] = (unsigned char) (header->bits >> 8);
+    for(int k = 0; k < 4; k++){
+        bytes[8 + k] = (unsigned char) ((header->size >> (8 * k)) & 0xFF);
+    }
+}
+
+/**
+ * @brief Reads a board image header from its little-endian bytes.
+ *
+ * @param header The header to fill.
+ * @param bytes Buffer of BOARD_IMAGE_HEADER_SIZE bytes.
+ */
+static void unpackImageHeader(BoardImageHeader *header, const unsigned char *bytes){
+    memcpy(header->magic, bytes, sizeof(header->magic));
+    header->version = (uint16_t) (bytes[4] | (bytes[5] << 8));
+    header->bits = (uint16_t) (bytes[6] | (bytes[7] << 8));
+    header->size = 0;
+    for(int k = 0; k < 4; k++){
+        header->size |= (uint32_t) bytes[8 + k] << (8 * k);
+    }
+}
+
+/**
+ * @brief Reads a board image record, which starts at the next byte of an input.
+ *
+ * @param reader The reader.
+ * @param board Pointer to store the board, only set on success.
+ * @param spare A board that is used instead of a new one if it has the size of the record, or NULL.
+ * @param error Pointer to store the error message when the record can't be read.
+ * @return EXIT_SUCCESS, EXIT_FAILURE or READ_FATAL, as scanLatinSquare.
+ */
+static int scanBoardImage(LatinReader *reader, LatinBoard **board, LatinBoard **spare, const char **error){
+    // Read the header a byte at a time, it may span two chunks of the input
+    unsigned char bytes[BOARD_IMAGE_HEADER_SIZE];
+    for(size_t k = 0; k < sizeof(bytes); k++){
+        int c = nextByte(reader);
+        if(c == EOF){
+            *error = "Unsupported board image!";
+            return READ_FATAL;
+        }
+        bytes[k] = (unsigned char) c;
+    }
+    BoardImageHeader header;
+    unpackImageHeader(&header, bytes);
+    if(memcmp(header.magic, BOARD_IMAGE_MAGIC, sizeof(header.magic)) != 0 || header.version != BOARD_IMAGE_VERSION){
+        *error = "Unsupported board image!";
+        return READ_FATAL;
+    }
+    if(header.size == 0 && header.bits == 0 && reader->failedRecords){ // the image of a square that wasn't solved
+        *error = FAILED_RECORD;
+        return EXIT_FAILURE;
+    }
+    if(header.size == 0 || header.size > MAX_SIZE){
+        *error = "Invalid size of Latin Square!";
+        return READ_FATAL;
+    }
+    if(header.bits != cellBits(header.size)){
+        *error = "Unsupported board image!";
+        return READ_FATAL;
+    }
+
+    int size = (int) header.size;
+    LatinBoard *b = takeBoard(spare, size);
+    if(b == NULL){
+        *error = "Unable to allocate memory for the board.";
+        return READ_FATAL;
+    }
+
+    // The given-cell bitset goes straight into the board
+    size_t cells = (size_t) size * size;
+    for(size_t k = 0; k < (cells + 7) / 8; k++){
+        int c = nextByte(reader);
+        if(c == EOF){
+            *error = "Error reading Latin Square values.";
+            freeLatinBoard(b);
+            return READ_FATAL;
+        }
+        b->given[k / 8] |= (uint64_t) c << (8 * (k % 8));
+    }
+    if(cells % 64 != 0){
+        b->given[cells / 64] &= (UINT64_C(1) << (cells % 64)) - 1; // bits past the last cell
+    }
+
+    // Unpack the values, a given cell must hold one
+    int bits = header.bits;
+    uint64_t buffer = 0;
+    int buffered = 0;
+    int status = EXIT_SUCCESS;
+    for(int i = 0; i < size; i++){
+        for(int j = 0; j < size; j++){
+            while(buffered < bits){
+                int c = nextByte(reader);
+                if(c == EOF){
+                    if(status == EXIT_SUCCESS){
+                        *error = "Error reading Latin Square values.";
+                    }
+                    freeLatinBoard(b);
+                    return READ_FATAL;
+                }
+                buffer |= (uint64_t) c << buffered;
+                buffered += 8;
+            }
+            int value = (int) (buffer & ((UINT64_C(1) << bits) - 1));
+            buffer >>= bits;
+            buffered -= bits;
+
+            if(value > size || (value == 0 && isGivenCell(b, i, j))){
+                if(status == EXIT_SUCCESS){
+                    *error = "File contains invalid values!";
+                }
+                status = EXIT_FAILURE;
+            } else if(value > 0){
+                setCell(b, i, j, value);
+            }
+        }
+    }
+
+    if(status != EXIT_SUCCESS){
+        freeLatinBoard(b);
+        return status;
+    }
+
+    *board = b;
+    return EXIT_SUCCESS;
+}
+
+bool isBoardImage(LatinReader *reader){
+    return skipSpace(reader) == BOARD_IMAGE_MAGIC[0];
+}
+
+/**
+ * @brief Reads the next Latin Square record of an input, as scanLatinSquare.
+ *
+ * @param reader The reader.
+ * @param board Pointer to store the board, only set on success.
+ * @param spare A board that is used instead of a new one if it has the size of the record, or NULL.
+ * @param error Pointer to store the error message when the record can't be read.
+ * @return EXIT_SUCCESS, EXIT_FAILURE, READ_END or READ_FATAL, as scanLatinSquare.
+ */
+static int scanRecord(LatinReader *reader, LatinBoard **board, LatinBoard **spare, const char **error){
+    if(isBoardImage(reader)){
+        return scanBoardImage(reader, board, spare, error);
+    }
+
+    // Check n (size of latin square)
+    long long size;
+    int status = scanNumber(reader, &size);
+    if(status == 1 && size == 0 && reader->failedRecords){ // a square that wasn't solved
+        *error = FAILED_RECORD;
+        return EXIT_FAILURE;
+    }
+    if(status != 1 || size <= 0 || size > MAX_SIZE){
+        *error = "Invalid size of Latin Square!";
+        return (status == EOF) ? READ_END : READ_FATAL;
+    }
+
+    LatinBoard *b = takeBoard(spare, (int) size);
+    if(b == NULL){
+        *error = "Unable to allocate memory for the board.";
+        return READ_FATAL;
+    }
+
+    // Read numbers of square, an invalid value is reported after the rest of the record
+    status = EXIT_SUCCESS;
+    for(int i = 0; i < size; i++){
+        for(int j = 0; j < size; j++){
+            long long value;
+            if(scanNumber(reader, &value) != 1){
+                if(status == EXIT_SUCCESS){
+                    *error = "Error reading Latin Square values.";
+                }
+                freeLatinBoard(b);
+                return READ_FATAL;
+            } else if(value > size || value < -size){ // values of latin square are in [1, size]
+                if(status == EXIT_SUCCESS){
+                    *error = "File contains invalid values!";
+                }
+                status = EXIT_FAILURE;
+            } else if(value < 0){ // negative values are pre-given
+                setGivenCell(b, i, j, (int) -value);
+            } else if(value > 0){
+                setCell(b, i, j, (int) value);
+            }
+        }
+    }
+
+    if(status != EXIT_SUCCESS){
+        freeLatinBoard(b);
+        return status;
+    }
+
+    *board = b;
+    return EXIT_SUCCESS;
+}
+
+int scanLatinSquare(LatinReader *reader, LatinBoard **board, const char **error){
+    LatinBoard *spare = NULL;
+    return scanRecord(reader, board, &spare, error);
+}
+
+int rescanLatinSquare(LatinReader *reader, LatinBoard **board, const char **error){
+    LatinBoard *spare = *board;
+    *board = NULL;
+    int status = scanRecord(reader, board, &spare, error);
+    freeLatinBoard(spare); // the previous board, unless it was reused
+    return status;
+}
+
+bool hasMoreData(LatinReader *reader){
+    long long value;
+    return isBoardImage(reader) || scanNumber(reader, &value) == 1;
+}
+
+/**
+ * @brief Output buffer that is written to a stream whenever it fills up.
+ */
+typedef struct {
+    FILE *fp; // destination stream
+    char *data; // the small buffer or an allocated one
+    size_t length; // bytes in data
+    size_t capacity; // size of data
+    char small[SMALL_OUTPUT]; // buffer used for small records
+} ChunkWriter;
+
+/**
+ * @brief Prepares an output buffer for a record of about a given size.
+ *
+ * @param writer The buffer.
+ * @param fp The destination stream.
+ * @param needed The largest number of bytes of the record.
+ */
+static void initChunkWriter(ChunkWriter *writer, FILE *fp, size_t needed){
+    writer->fp = fp;
+    writer->length = 0;
+    writer->capacity = (needed < OUTPUT_CHUNK_SIZE) ? needed : OUTPUT_CHUNK_SIZE;
+    writer->data = (writer->capacity > SMALL_OUTPUT) ? (char *) malloc(writer->capacity) : NULL;
+    if(writer->data == NULL){ // small records, or no memory for a larger buffer
+        writer->data = writer->small;
+        writer->capacity = SMALL_OUTPUT;
+    }
+}
+
+/**
+ * @brief Makes room for a number of bytes, writing the buffer out if they don't fit.
+ *
+ * @param writer The buffer.
+ * @param bytes The number of bytes about to be added (at most SMALL_OUTPUT).
+ */
+static void reserveOutput(ChunkWriter *writer, size_t bytes){
+    if(writer->length + bytes > writer->capacity){
+        fwrite(writer->data, 1, writer->length, writer->fp);
+        writer->length = 0;
+    }
+}
+
+/**
+ * @brief Writes out the rest of an output buffer and frees it.
+ *
+ * @param writer The buffer.
+ */
+static void finishChunkWriter(ChunkWriter *writer){
+    fwrite(writer->data, 1, writer->length, writer->fp);
+    if(writer->data != writer->small){
+        free(writer->data);
+    }
+}
+
+/**
+ * @brief Appends a number and the character after it to an output buffer.
+ *
+ * @param buffer The output buffer, with room for at least 12 more bytes.
+ * @param length Pointer to the number of bytes in the buffer.
+ * @param value The number.
+ * @param separator The character after the number.
+ */
+static void appendNumber(char *buffer, size_t *length, int value, char separator){
+    char digits[12];
+    int count = 0;
+    unsigned int magnitude = (value < 0) ? (unsigned int) -value : (unsigned int) value;
+    do{
+        digits[count++] = (char) ('0' + magnitude % 10);
+        magnitude /= 10;
+    } while(magnitude > 0);
+
+    if(value < 0){
+        buffer[(*length)++] = '-';
+    }
+    while(count > 0){
+        buffer[(*length)++] = digits[--count];
+    }
+    buffer[(*length)++] = separator;
+}
+
+void printLatinSquare(FILE *fp, const LatinBoard *board){
+    int size = board->size;
+
+    // Small boards are formatted on the stack, larger ones in chunks of OUTPUT_CHUNK_SIZE
+    ChunkWriter writer;
+    initChunkWriter(&writer, fp, (size_t) size * size * 7 + 16); // up to 6 characters and a separator per value
+
+    // Write the size on 1st row, then the latin square's content
+    appendNumber(writer.data, &writer.length, size, '\n');
+    for(int i = 0; i < size; i++){
+        for(int j = 0; j < size; j++){
+            reserveOutput(&writer, 12);
+            int value = getCell(board, i, j);
+            appendNumber(writer.data, &writer.length, isGivenCell(board, i, j) ? -value : value, (j + 1 < size) ? ' ' : '\n'); // pre-given values are negative
+        }
+    }
+
+    finishChunkWriter(&writer);
+}
+
+void printBoardImage(FILE *fp, const LatinBoard *board){
+    int size = board->size;
+    int bits = cellBits(size);
+    size_t cells = (size_t) size * size;
+
+    BoardImageHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BOARD_IMAGE_MAGIC, sizeof(header.magic));
+    header.version = BOARD_IMAGE_VERSION;
+    header.bits = (uint16_t) bits;
+    header.size = (uint32_t) size;
+
+    ChunkWriter writer;
+    initChunkWriter(&writer, fp, BOARD_IMAGE_HEADER_SIZE + (cells + 7) / 8 + (cells * bits + 7) / 8);
+    packImageHeader(&header, (unsigned char *) writer.data);
+    writer.length = BOARD_IMAGE_HEADER_SIZE;
+
+    // Given-cell bitset, lowest bit first
+    for(size_t k = 0; k < (cells + 7) / 8; k++){
+        reserveOutput(&writer, 1);
+        writer.data[writer.length++] = (char) ((board->given[k / 8] >> (8 * (k % 8))) & 0xFF);
+    }
+
+    // Values packed with the same bit order
+    uint64_t buffer = 0;
+    int buffered = 0;
+    for(int i = 0; i < size; i++){
+        for(int j = 0; j < size; j++){
+            buffer |= (uint64_t) getCell(board, i, j) << buffered;
+            buffered += bits;
+            reserveOutput(&writer, 3);
+            while(buffered >= 8){
+                writer.data[writer.length++] = (char) (buffer & 0xFF);
+                buffer >>= 8;
+                buffered -= 8;
+            }
+        }
+    }
+    if(buffered > 0){
+        reserveOutput(&writer, 1);
+        writer.data[writer.length++] = (char) (buffer & 0xFF);
+    }
+
+    finishChunkWriter(&writer);
+}
+
+void printFailedRecord(FILE *fp, bool image){
+    if(!image){
+        fputs("0\n", fp);
+        return;
+    }
+
+    BoardImageHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BOARD_IMAGE_MAGIC, sizeof(header.magic));
+    header.version = BOARD_IMAGE_VERSION;
+    unsigned char bytes[BOARD_IMAGE_HEADER_SIZE];
+    packImageHeader(&header, bytes);
+    fwrite(bytes, 1, sizeof(bytes), fp);
+}
+
+
+#ifdef DEBUG_LFILE
+
+int main(){
+    // Three records: a valid one, one with an invalid value, and another valid one
+    const char *fileName = "latinFileDEBUG.txt";
+    FILE *fp = fopen(fileName, "w");
+    if(fp == NULL){
+        printf("Unable to create test file.\n");
+        return EXIT_FAILURE;
+    }
+    fprintf(fp, "2\n-1 0\n0 0\n2\n1 3\n0 0\n1\n\t-1");
+    fclose(fp);
+
+    LatinReader *reader = NULL;
+    if(openLatinReader(&reader, fileName) != EXIT_SUCCESS){
+        printf("Unable to open test file.\n");
+        return EXIT_FAILURE;
+    }
+    const char *expected[] = { "read", "File contains invalid values!", "read", "end" };
+    for(int k = 0; k < 4; k++){
+        LatinBoard *board = NULL;
+        const char *error = "";
+        int status = scanLatinSquare(reader, &board, &error);
+        printf("Record %d: %s (expected %s)\n", k + 1, status == EXIT_SUCCESS ? "read" : (status == READ_END ? "end" : error), expected[k]);
+        if(status == EXIT_SUCCESS){
+            printLatinSquare(stdout, board);
+            freeLatinBoard(board);
+        }
+    }
+    closeLatinReader(reader);
+
+    // A number followed by letters is read up to the letters
+    fp = fopen(fileName, "w");
+    fprintf(fp, "1 -1 7x");
+    fclose(fp);
+    openLatinReader(&reader, fileName);
+    LatinBoard *board = NULL;
+    const char *error = "";
+    int status = scanLatinSquare(reader, &board, &error);
+    printf("Trailing data: %s, %d (expected read, 1)\n", status == EXIT_SUCCESS ? "read" : error, hasMoreData(reader));
+    freeLatinBoard(board);
+    closeLatinReader(reader);
+
+    // A board image followed by a text record reads back the same board
+    LatinBoard *original = NULL;
+    initLatinBoard(&original, 300);
+    for(int i = 0; i < 300; i++){
+        for(int j = 0; j < 300; j++){
+            if((i + 2 * j) % 3 == 0){
+                setGivenCell(original, i, j, (i + j) % 300 + 1);
+            } else if((i + j) % 5 != 0){
+                setCell(original, i, j, (i + j) % 300 + 1);
+            }
+        }
+    }
+    fp = fopen(fileName, "wb");
+    printBoardImage(fp, original);
+    long imageBytes = ftell(fp);
+    fflush(fp);
+    FILE *check = fopen(fileName, "rb");
+    unsigned char head[BOARD_IMAGE_HEADER_SIZE] = { 0 };
+    size_t headBytes = fread(head, 1, sizeof(head), check);
+    fclose(check);
+    printf("Image header: %d, version %d, bits %d, size %d (expected 1, 1, 9, 300)\n", headBytes == sizeof(head) && memcmp(head, BOARD_IMAGE_MAGIC, 4) == 0,
+           head[4] | (head[5] << 8), head[6] | (head[7] << 8), head[8] | (head[9] << 8) | (head[10] << 16) | (head[11] << 24));
+    printLatinSquare(fp, original);
+    long textBytes = ftell(fp) - imageBytes;
+    fclose(fp);
+
+    openLatinReader(&reader, fileName);
+    int same = 1;
+    for(int k = 0; k < 2; k++){
+        if(scanLatinSquare(reader, &board, &error) != EXIT_SUCCESS){
+            same = 0;
+            break;
+        }
+        for(int i = 0; i < 300; i++){
+            for(int j = 0; j < 300; j++){
+                same = same && getCell(board, i, j) == getCell(original, i, j) && isGivenCell(board, i, j) == isGivenCell(original, i, j);
+            }
+        }
+        freeLatinBoard(board);
+    }
+    printf("300x300 image of %ld bytes (text %ld) reads back: %d, then end: %d (expected 1, 1)\n",
+           imageBytes, textBytes, same, scanLatinSquare(reader, &board, &error) == READ_END);
+    closeLatinReader(reader);
+
+    // Reading both records again into one board reuses it
+    openLatinReader(&reader, fileName);
+    board = NULL;
+    rescanLatinSquare(reader, &board, &error);
+    LatinBoard *first = board;
+    status = rescanLatinSquare(reader, &board, &error);
+    printf("Second record read: %d, into the same board: %d, same cells: %d (expected 1, 1, 1)\n", status == EXIT_SUCCESS,
+           board == first, status == EXIT_SUCCESS && getCell(board, 299, 1) == getCell(original, 299, 1) && board->emptyCells == original->emptyCells);
+    freeLatinBoard(board);
+    closeLatinReader(reader);
+
+    // Records of size 0, in text and as an image, fail without ending the stream
+    fp = fopen(fileName, "wb");
+    printFailedRecord(fp, false);
+    printFailedRecord(fp, true);
+    printBoardImage(fp, original);
+    fclose(fp);
+    openLatinReader(&reader, fileName);
+    int plainText = scanLatinSquare(reader, &board, &error);
+    printf("Size 0 without failed records: %s (expected Invalid size of Latin Square!)\n", plainText == READ_FATAL ? error : "read");
+    closeLatinReader(reader);
+    openLatinReader(&reader, fileName);
+    reader->failedRecords = true;
+    int failedText = scanLatinSquare(reader, &board, &error);
+    int failedImage = scanLatinSquare(reader, &board, &error);
+    status = scanLatinSquare(reader, &board, &error);
+    printf("Failed records: %d, %d, then read: %d (expected 1, 1, 1)\n", failedText == EXIT_FAILURE, failedImage == EXIT_FAILURE, status == EXIT_SUCCESS);
+    if(status == EXIT_SUCCESS){
+        freeLatinBoard(board);
+    }
+    closeLatinReader(reader);
+    freeLatinBoard(original);
+
+    remove(fileName);
+    printf("File test completed.\n");
+    return 0;
+}
+#endif // DEBUG_LFILE
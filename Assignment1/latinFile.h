@@ -0,0 +1,170 @@
+/**
+ * @file latinFile.h
+ * @brief Header file for reading and writing Latin Squares in their text and binary formats.
+ *
+ * A Latin Square is stored as its size followed by its rows of values, where 0 is an empty
+ * cell and negative values are pre-given cells. A stream may hold several such records one
+ * after the other. The functions here report errors to the caller instead of exiting, so a
+ * bad record doesn't end the processing of the rest.
+ *
+ * A record may also be a board image: a BoardImageHeader, the given-cell bitset (one bit per
+ * cell in row-major order, eight cells per byte starting from the lowest bit) and then the
+ * cell values packed in the same order with the smallest number of bits that holds 0..n.
+ * Image records start with the letter of BOARD_IMAGE_MAGIC, which no text record starts
+ * with, so both formats are told apart automatically and may be mixed in one stream.
+ *
+ * A record of size 0 marks a square that couldn't be read or solved, so the output of the
+ * batch mode keeps one record per input record: in text it is the single line `0`, and as
+ * an image it is a header with size 0 and no cells. A reader only accepts it when its
+ * `failedRecords` is set, and reading one is then a failure of that record only, so the
+ * records after it are still read; other readers report it as an invalid size.
+ *
+ * Input is read through a LatinReader, which memory-maps regular files and reads anything
+ * else (such as the standard input) in chunks, and numbers are parsed by a single loop over
+ * the bytes instead of `fscanf`. Output is formatted into a buffer that is written with one
+ * `fwrite` per OUTPUT_CHUNK_SIZE bytes.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs
+ */
+
+#ifndef LATINFILE_H
+#define LATINFILE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "latinBoard.h"
+
+#define READ_END 2 /**< Returned by scanLatinSquare when the stream has no records left. */
+#define READ_FATAL 3 /**< Returned by scanLatinSquare when the stream can't be read past the record. */
+#define INPUT_CHUNK_SIZE (1 << 16) /**< Bytes read at a time from inputs that can't be mapped. */
+#define OUTPUT_CHUNK_SIZE (1 << 20) /**< Largest number of bytes formatted before writing them. */
+#define STDIN_NAME "-" /**< File name that stands for the standard input. */
+#define BOARD_IMAGE_MAGIC "LSQB" /**< First bytes of a board image. */
+#define BOARD_IMAGE_VERSION 1 /**< Version of the board image layout. */
+#define BOARD_IMAGE_HEADER_SIZE 12 /**< Bytes of a board image header. */
+
+/**
+ * @brief Header of a board image.
+ *
+ * It is stored in BOARD_IMAGE_HEADER_SIZE bytes: the magic, then the version, the bits and
+ * the size as little-endian numbers of 2, 2 and 4 bytes, so an image reads back on machines
+ * of any byte order, like its packed cells.
+ */
+typedef struct {
+    char magic[4]; /**< BOARD_IMAGE_MAGIC, without its terminating null. */
+    uint16_t version; /**< BOARD_IMAGE_VERSION. */
+    uint16_t bits; /**< Bits per packed cell value. */
+    uint32_t size; /**< Number of rows and columns. */
+} BoardImageHeader;
+
+/**
+ * @brief Reader of the numbers of a mapped or buffered input.
+ */
+typedef struct {
+    char *data; /**< Mapping or read buffer. */
+    size_t length; /**< Valid bytes in data. */
+    size_t position; /**< Next byte to parse. */
+    bool mapped; /**< true if data is a file mapping. */
+    FILE *file; /**< Source of the read buffer. */
+    bool failedRecords; /**< true to read a record of size 0 as a square that wasn't solved, false by default. */
+} LatinReader;
+
+
+/**
+ * @brief Opens a file, or the standard input for STDIN_NAME, for reading.
+ *
+ * @param reader Pointer to store the allocated reader.
+ * @param filename The name of the file.
+ * @return EXIT_SUCCESS on success, or EXIT_FAILURE with errno set if the file can't be opened.
+ */
+int openLatinReader(LatinReader **reader, const char *filename);
+
+
+/**
+ * @brief Closes the input and frees a reader.
+ *
+ * @param reader The reader to close (may be NULL).
+ */
+void closeLatinReader(LatinReader *reader);
+
+
+/**
+ * @brief Reads the next Latin Square record of an input.
+ *
+ * The record may be in the text format or a board image. A record with an invalid value, or
+ * of size 0 when the reader accepts failed records, is read to its end, so the records after it can still be read. A record with
+ * an invalid size, a value that is not a number or a damaged image header can't be skipped.
+ *
+ * @param reader The reader.
+ * @param board Pointer to store the allocated board, only set on success.
+ * @param error Pointer to store the error message when the record can't be read.
+ * @return EXIT_SUCCESS if the record was read, EXIT_FAILURE if it has invalid values or
+ *         marks a square that wasn't solved, READ_END if the input ended before the record, or READ_FATAL if the input
+ *         can't be read any further.
+ */
+int scanLatinSquare(LatinReader *reader, LatinBoard **board, const char **error);
+
+
+/**
+ * @brief Reads the next Latin Square record of an input into the board of the previous one.
+ *
+ * Works like scanLatinSquare, but when the previous board has the size of the record it is
+ * cleared and filled again instead of allocating a new board, so a stream of boards of one
+ * size is read without allocations. The previous board is freed otherwise.
+ *
+ * @param reader The reader.
+ * @param board The board of the previous record, or NULL. Set to the board of the record,
+ *              or to NULL when the record can't be read.
+ * @param error Pointer to store the error message when the record can't be read.
+ * @return EXIT_SUCCESS, EXIT_FAILURE, READ_END or READ_FATAL, as scanLatinSquare.
+ */
+int rescanLatinSquare(LatinReader *reader, LatinBoard **board, const char **error);
+
+
+/**
+ * @brief Checks if the next record of an input is a board image.
+ *
+ * @param reader The reader.
+ * @return true if the next item of the input starts with the letter of BOARD_IMAGE_MAGIC.
+ */
+bool isBoardImage(LatinReader *reader);
+
+
+/**
+ * @brief Checks if another number follows in an input.
+ *
+ * @param reader The reader.
+ * @return true if the next item of the input is a number (which is consumed) or a board image.
+ */
+bool hasMoreData(LatinReader *reader);
+
+
+/**
+ * @brief Writes a Latin Square record to a stream.
+ *
+ * @param fp The stream.
+ * @param board The board of the Latin Square.
+ */
+void printLatinSquare(FILE *fp, const LatinBoard *board);
+
+
+/**
+ * @brief Writes a Latin Square record to a stream as a board image.
+ *
+ * @param fp The stream, opened in binary mode.
+ * @param board The board of the Latin Square.
+ */
+void printBoardImage(FILE *fp, const LatinBoard *board);
+
+
+/**
+ * @brief Writes the record of size 0 that marks a square that couldn't be read or solved.
+ *
+ * @param fp The stream, opened in binary mode for an image.
+ * @param image true to write it as a board image, false as text.
+ */
+void printFailedRecord(FILE *fp, bool image);
+
+#endif // LATINFILE_H
@@ -0,0 +1,394 @@
+/**
+ * @file latinGenerator.c
+ * @brief Implementation of the generator of random Latin Square puzzles.
+ *
+ * This file runs the Jacobson-Matthews chain on the line sums of the incidence cube and
+ * punches holes into the resulting square. Compiled with BENCH_LGENERATOR, it is the
+ * benchmark of `make bench`, which times the reading, validation, solving and writing of
+ * generated puzzles of several sizes.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+#include "latinGenerator.h"
+
+
+/**
+ * @brief A line of the incidence cube, as the sums of the positions of its entries.
+ */
+typedef struct {
+    int64_t sum; // sum of position * entry
+    int64_t squares; // sum of position^2 * entry
+} CubeLine;
+
+/**
+ * @brief State of the Jacobson-Matthews chain.
+ */
+typedef struct {
+    int size;
+    CubeLine *cells; // line of cell (row, column), over the values
+    CubeLine *rows; // line of (row, value), over the columns
+    CubeLine *cols; // line of (column, value), over the rows
+    bool improper; // true if the cube has a -1 entry
+    int row, col, val; // position of the -1 entry
+    uint64_t seed; // state of the xorshift generator
+} MarkovChain;
+
+/**
+ * @brief Returns the next number of a xorshift generator.
+ *
+ * @param seed The state of the generator (not 0).
+ * @param bound The number of possible results.
+ * @return A number in 0..bound-1.
+ */
+static uint64_t nextRandom(uint64_t *seed, uint64_t bound){
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 7;
+    *seed ^= *seed << 17;
+    return *seed % bound;
+}
+
+/**
+ * @brief Adds to an entry of the incidence cube.
+ *
+ * @param chain The chain.
+ * @param row The row of the entry.
+ * @param col The column of the entry.
+ * @param val The value of the entry (0-based).
+ * @param delta The amount to add (1 or -1).
+ */
+static void addEntry(MarkovChain *chain, int row, int col, int val, int delta){
+    int n = chain->size;
+    CubeLine *cell = &(chain->cells[(size_t) row * n + col]);
+    CubeLine *rowLine = &(chain->rows[(size_t) row * n + val]);
+    CubeLine *colLine = &(chain->cols[(size_t) col * n + val]);
+    cell->sum += delta * val;
+    cell->squares += (int64_t) delta * val * val;
+    rowLine->sum += delta * col;
+    rowLine->squares += (int64_t) delta * col * col;
+    colLine->sum += delta * row;
+    colLine->squares += (int64_t) delta * row * row;
+}
+
+/**
+ * @brief Picks one of the two positive positions of a line through the -1 entry.
+ *
+ * With +1 at a and b and -1 at x, the sums give a + b and a^2 + b^2, and so a and b.
+ *
+ * @param chain The chain.
+ * @param line The line.
+ * @param negative The position of its -1 entry.
+ * @return a or b, at random.
+ */
+static int pickPositive(MarkovChain *chain, const CubeLine *line, int negative){
+    int64_t total = line->sum + negative; // a + b
+    int64_t squares = line->squares + (int64_t) negative * negative; // a^2 + b^2
+    int64_t gapSquared = 2 * squares - total * total; // (a - b)^2
+    int64_t gap = (int64_t) sqrt((double) gapSquared);
+    while(gap * gap > gapSquared){
+        gap--;
+    }
+    while((gap + 1) * (gap + 1) <= gapSquared){
+        gap++;
+    }
+    return (int) ((nextRandom(&(chain->seed), 2) == 0) ? (total - gap) / 2 : (total + gap) / 2);
+}
+
+/**
+ * @brief Makes one step of the Jacobson-Matthews chain.
+ *
+ * @param chain The chain.
+ */
+static void stepChain(MarkovChain *chain){
+    int n = chain->size;
+    int row, col, val, otherRow, otherCol, otherVal;
+
+    if(!chain->improper){ // a random 0 entry of the cube, and the 1 entries of its lines
+        do{
+            row = (int) nextRandom(&(chain->seed), n);
+            col = (int) nextRandom(&(chain->seed), n);
+            val = (int) nextRandom(&(chain->seed), n);
+        } while(chain->cells[(size_t) row * n + col].sum == val);
+        otherVal = (int) chain->cells[(size_t) row * n + col].sum;
+        otherCol = (int) chain->rows[(size_t) row * n + val].sum;
+        otherRow = (int) chain->cols[(size_t) col * n + val].sum;
+    } else{ // the -1 entry, and one of the two 1 entries of each of its lines
+        row = chain->row;
+        col = chain->col;
+        val = chain->val;
+        otherVal = pickPositive(chain, &(chain->cells[(size_t) row * n + col]), val);
+        otherCol = pickPositive(chain, &(chain->rows[(size_t) row * n + val]), col);
+        otherRow = pickPositive(chain, &(chain->cols[(size_t) col * n + val]), row);
+    }
+
+    // The opposite corner is a proper cell line, the square stays proper if it held a 1
+    bool wasOne = (chain->cells[(size_t) otherRow * n + otherCol].sum == otherVal);
+
+    addEntry(chain, row, col, val, 1);
+    addEntry(chain, row, otherCol, otherVal, 1);
+    addEntry(chain, otherRow, col, otherVal, 1);
+    addEntry(chain, otherRow, otherCol, val, 1);
+    addEntry(chain, row, col, otherVal, -1);
+    addEntry(chain, row, otherCol, val, -1);
+    addEntry(chain, otherRow, col, val, -1);
+    addEntry(chain, otherRow, otherCol, otherVal, -1);
+
+    chain->improper = !wasOne;
+    chain->row = otherRow;
+    chain->col = otherCol;
+    chain->val = otherVal;
+}
+
+/**
+ * @brief Randomly permutes the numbers 0..count-1.
+ *
+ * @param order The numbers, filled by the function.
+ * @param count The number of numbers.
+ * @param seed The state of the generator.
+ */
+static void shuffleOrder(int *order, int count, uint64_t *seed){
+    for(int k = 0; k < count; k++){
+        order[k] = k;
+    }
+    for(int k = count - 1; k > 0; k--){
+        int other = (int) nextRandom(seed, (uint64_t) k + 1);
+        int value = order[k];
+        order[k] = order[other];
+        order[other] = value;
+    }
+}
+
+int generateLatinSquare(LatinBoard **board, int size, double fill, uint64_t seed){
+    *board = NULL;
+    if(size < 1 || size > MAX_SIZE || !(fill >= 0.0 && fill <= 1.0)){
+        fprintf(stderr, "Invalid size or fill ratio for the generator.\n");
+        return EXIT_FAILURE;
+    }
+
+    size_t cells = (size_t) size * size;
+    MarkovChain chain = { size, NULL, NULL, NULL, false, 0, 0, 0, (seed == 0) ? UINT64_C(0x9E3779B97F4A7C15) : seed };
+    chain.cells = (CubeLine *) calloc(cells, sizeof(CubeLine));
+    chain.rows = (CubeLine *) calloc(cells, sizeof(CubeLine));
+    chain.cols = (CubeLine *) calloc(cells, sizeof(CubeLine));
+    uint32_t *order = (uint32_t *) malloc(cells * sizeof(uint32_t));
+    int *relabel = (int *) malloc(size * sizeof(int));
+    if(chain.cells == NULL || chain.rows == NULL || chain.cols == NULL || order == NULL || relabel == NULL
+       || initLatinBoard(board, size) != EXIT_SUCCESS){
+        perror("Unable to allocate memory for the generator.");
+        free(chain.cells);
+        free(chain.rows);
+        free(chain.cols);
+        free(order);
+        free(relabel);
+        return EXIT_FAILURE;
+    }
+
+    // Start from the cyclic square and mix it, ending on a proper square
+    for(int i = 0; i < size; i++){
+        for(int j = 0; j < size; j++){
+            addEntry(&chain, i, j, (i + j) % size, 1);
+        }
+    }
+    long steps = (long) cells * size;
+    if(steps > MIXING_STEPS_LIMIT){
+        steps = MIXING_STEPS_LIMIT;
+    }
+    for(long k = 0; (k < steps || chain.improper) && size > 1; k++){
+        stepChain(&chain);
+    }
+
+    // Keep a random set of the cells, with the values relabelled at random
+    shuffleOrder(relabel, size, &(chain.seed));
+    long kept = (long) (fill * (double) cells + 0.5);
+    for(size_t k = 0; k < cells; k++){
+        order[k] = (uint32_t) k;
+    }
+    for(long k = 0; k < kept; k++){ // partial Fisher-Yates shuffle of the cells
+        size_t other = (size_t) k + (size_t) nextRandom(&(chain.seed), cells - (size_t) k);
+        uint32_t cell = order[other];
+        order[other] = order[k];
+        order[k] = cell;
+        setGivenCell(*board, (int) (cell / size), (int) (cell % size), relabel[chain.cells[cell].sum] + 1);
+    }
+
+    free(chain.cells);
+    free(chain.rows);
+    free(chain.cols);
+    free(order);
+    free(relabel);
+    return EXIT_SUCCESS;
+}
+
+
+#ifdef DEBUG_LGENERATOR
+#include "latinSolver.h"
+
+int main(){
+    // Generated squares of several orders are complete and consistent
+    int sizes[] = { 1, 2, 3, 9, 31, 100 };
+    for(int k = 0; k < 6; k++){
+        LatinBoard *board = NULL;
+        generateLatinSquare(&board, sizes[k], 1.0, 42);
+        printf("Order %3d: empty %ld, consistent %d (expected 0, 1)\n", sizes[k], board->emptyCells, isConsistentBoard(board));
+        freeLatinBoard(board);
+    }
+
+    // Holes are punched to the fill ratio, and the same seed gives the same puzzle
+    LatinBoard *first = NULL, *second = NULL;
+    generateLatinSquare(&first, 20, 0.25, 7);
+    generateLatinSquare(&second, 20, 0.25, 7);
+    int same = 1;
+    for(int i = 0; i < 20; i++){
+        for(int j = 0; j < 20; j++){
+            same &= (getCell(first, i, j) == getCell(second, i, j) && isGivenCell(first, i, j) == isGivenCell(second, i, j));
+        }
+    }
+    printf("Fill 0.25 of 20x20: empty %ld, same for the same seed %d (expected 300, 1)\n", first->emptyCells, same);
+    printf("Puzzle solvable: %d (expected 1)\n", solveLatinSquare(first) == EXIT_SUCCESS);
+    freeLatinBoard(first);
+    freeLatinBoard(second);
+
+    // Every one of the 12 Latin Squares of order 3 is reached
+    long seen[12];
+    int found = 0;
+    for(int seed = 1; seed <= 2000; seed++){
+        LatinBoard *board = NULL;
+        generateLatinSquare(&board, 3, 1.0, (uint64_t) seed);
+        long key = 0; // the cells as the digits of a number in base 4
+        for(int cell = 0; cell < 9; cell++){
+            key = key * 4 + getCell(board, cell / 3, cell % 3);
+        }
+        int known = 0;
+        for(int k = 0; k < found; k++){
+            known |= (seen[k] == key);
+        }
+        if(!known && found < 12){
+            seen[found++] = key;
+        }
+        freeLatinBoard(board);
+    }
+    printf("Squares of order 3 reached: %d (expected 12)\n", found);
+
+    printf("Generator test completed.\n");
+    return 0;
+}
+#endif // DEBUG_LGENERATOR
+
+
+#ifdef BENCH_LGENERATOR
+#include <time.h>
+#include "latinFile.h"
+#include "latinSolver.h"
+
+#define BENCH_FILE "latinbench.tmp" /**< Scratch file of the benchmark. */
+#define BENCH_CELLS 20000 /**< Cells of the puzzles of every size class. */
+
+/**
+ * @brief Returns the seconds since a given time.
+ *
+ * @param start The time.
+ * @return The elapsed seconds.
+ */
+static double elapsedSince(const struct timespec *start){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) (now.tv_sec - start->tv_sec) + (double) (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Prints the throughput of a phase of the benchmark.
+ *
+ * @param size The order of the puzzles.
+ * @param count The number of puzzles.
+ * @param phase The name of the phase.
+ * @param seconds The time the phase took.
+ */
+static void printPhase(int size, int count, const char *phase, double seconds){
+    if(seconds <= 0.0){
+        seconds = 1e-9;
+    }
+    printf("%5d %8d  %-9s %10.2f ms %14.0f cells/s %12.0f puzzles/s\n", size, count, phase,
+           seconds * 1e3, (double) size * size * count / seconds, count / seconds);
+}
+
+int main(int argc, char *argv[]){
+    double fill = (argc > 1) ? atof(argv[1]) : 0.2; // fraction of pre-given cells
+    int sizes[] = { 4, 9, 16, 25, 36, 64 };
+
+    printf(" size  puzzles  phase           time         throughput\n");
+    for(int c = 0; c < (int) (sizeof(sizes) / sizeof(sizes[0])); c++){
+        int size = sizes[c];
+        int count = BENCH_CELLS / (size * size);
+        if(count < 5){
+            count = 5;
+        }
+
+        LatinBoard **boards = (LatinBoard **) calloc(count, sizeof(LatinBoard *));
+        for(int k = 0; k < count; k++){
+            if(boards == NULL || generateLatinSquare(&(boards[k]), size, fill, (uint64_t) (k + 1)) != EXIT_SUCCESS){
+                return EXIT_FAILURE;
+            }
+        }
+
+        // Write the puzzles, then read them back
+        struct timespec start;
+        FILE *fp = fopen(BENCH_FILE, "w");
+        if(fp == NULL){
+            perror("Error occurred while attempting to write to file.");
+            return EXIT_FAILURE;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for(int k = 0; k < count; k++){
+            printLatinSquare(fp, boards[k]);
+        }
+        fclose(fp);
+        printPhase(size, count, "write", elapsedSince(&start));
+
+        for(int k = 0; k < count; k++){
+            freeLatinBoard(boards[k]);
+            boards[k] = NULL;
+        }
+        LatinReader *reader = NULL;
+        const char *error = NULL;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        openLatinReader(&reader, BENCH_FILE);
+        for(int k = 0; k < count && reader != NULL; k++){
+            scanLatinSquare(reader, &(boards[k]), &error);
+        }
+        closeLatinReader(reader);
+        printPhase(size, count, "read", elapsedSince(&start));
+
+        // Validate and solve the puzzles that were read
+        int valid = 0, solved = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for(int k = 0; k < count; k++){
+            valid += (boards[k] != NULL && isConsistentBoard(boards[k]));
+        }
+        printPhase(size, count, "validate", elapsedSince(&start));
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for(int k = 0; k < count; k++){
+            solved += (boards[k] != NULL && solveLatinSquare(boards[k]) == EXIT_SUCCESS);
+        }
+        printPhase(size, count, "solve", elapsedSince(&start));
+        if(valid != count || solved != count){
+            printf("Only %d of %d puzzles were valid and %d solved!\n", valid, count, solved);
+        }
+
+        for(int k = 0; k < count; k++){
+            freeLatinBoard(boards[k]);
+        }
+        free(boards);
+    }
+
+    remove(BENCH_FILE);
+    return 0;
+}
+#endif // BENCH_LGENERATOR
@@ -0,0 +1,42 @@
+/**
+ * @file latinGenerator.h
+ * @brief Header file for the generator of random Latin Square puzzles.
+ *
+ * A random Latin Square is produced by the Markov chain of Jacobson and Matthews, which
+ * walks between Latin Squares (through "improper" squares with a single -1 entry) by
+ * changing a 2x2x2 sub-cube of the incidence cube at every step, starting from a cyclic
+ * square. Its stationary distribution is uniform over the Latin Squares of the order.
+ *
+ * The cube is never stored. Every line of it (a cell, a row and value, or a column and
+ * value) keeps the sum and the sum of squares of the positions of its entries, which is
+ * enough to recover the one position of a proper line and the two positions of an
+ * improper one, so the chain takes O(n^2) memory and O(1) time per step.
+ *
+ * Holes are then punched into the square at random until the requested fraction of the
+ * cells is left as pre-given.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs
+ */
+
+#ifndef LATINGENERATOR_H
+#define LATINGENERATOR_H
+
+#include <stdint.h>
+#include "latinBoard.h"
+
+#define MIXING_STEPS_LIMIT (1L << 24) /**< Most steps of the chain, which otherwise takes size^3 steps. */
+
+
+/**
+ * @brief Generates a random Latin Square puzzle.
+ *
+ * @param board Pointer to store the allocated board.
+ * @param size The order of the square (1..MAX_SIZE).
+ * @param fill The fraction of the cells left as pre-given (0..1), the rest are empty.
+ * @param seed Seed of the random choices; the same seed gives the same puzzle.
+ * @return EXIT_SUCCESS on success, or EXIT_FAILURE if the arguments are invalid or memory runs out.
+ */
+int generateLatinSquare(LatinBoard **board, int size, double fill, uint64_t seed);
+
+#endif // LATINGENERATOR_H
@@ -0,0 +1,123 @@
+/**
+ * @file latinJournal.c
+ * @brief Implementation of the journal of the moves of a Latin Square game.
+ *
+ * This file provides the functions for recording, undoing and redoing moves on a board.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "latinJournal.h"
+
+#define INITIAL_MOVES 64 /**< Moves allocated by a new journal. */
+
+
+int initMoveJournal(MoveJournal **journal){
+    *journal = (MoveJournal *) malloc(sizeof(MoveJournal));
+    if(*journal == NULL){
+        perror("Unable to allocate memory for the move journal.");
+        return EXIT_FAILURE;
+    }
+
+    (*journal)->moves = (Move *) malloc(INITIAL_MOVES * sizeof(Move));
+    if((*journal)->moves == NULL){
+        perror("Unable to allocate memory for the move journal.");
+        free(*journal);
+        *journal = NULL;
+        return EXIT_FAILURE;
+    }
+    (*journal)->count = 0;
+    (*journal)->applied = 0;
+    (*journal)->capacity = INITIAL_MOVES;
+
+    return EXIT_SUCCESS;
+}
+
+void freeMoveJournal(MoveJournal *journal){
+    if(journal == NULL){
+        return;
+    }
+
+    free(journal->moves);
+    free(journal);
+}
+
+int recordMove(MoveJournal *journal, LatinBoard *board, int row, int col, int val){
+    Move move = { row, col, (uint16_t) getCell(board, row, col), (uint16_t) val };
+    setCell(board, row, col, val);
+
+    // The undone moves can't be redone after a new move
+    journal->count = journal->applied;
+    if(journal->count == journal->capacity){
+        Move *moves = (Move *) realloc(journal->moves, 2 * journal->capacity * sizeof(Move));
+        if(moves == NULL){
+            perror("Unable to grow the move journal.");
+            return EXIT_FAILURE;
+        }
+        journal->moves = moves;
+        journal->capacity *= 2;
+    }
+
+    journal->moves[journal->count++] = move;
+    journal->applied = journal->count;
+    return EXIT_SUCCESS;
+}
+
+bool undoMove(MoveJournal *journal, LatinBoard *board){
+    if(journal->applied == 0){
+        return false;
+    }
+
+    const Move *move = &(journal->moves[--(journal->applied)]);
+    setCell(board, move->row, move->col, move->before);
+    return true;
+}
+
+bool redoMove(MoveJournal *journal, LatinBoard *board){
+    if(journal->applied == journal->count){
+        return false;
+    }
+
+    const Move *move = &(journal->moves[(journal->applied)++]);
+    setCell(board, move->row, move->col, move->after);
+    return true;
+}
+
+
+#ifdef DEBUG_LJOURNAL
+
+int main(){
+    LatinBoard *board = NULL;
+    MoveJournal *journal = NULL;
+    initLatinBoard(&board, 3);
+    initMoveJournal(&journal);
+
+    // 100 moves grow the journal, each one replaces the value of cell (0,0)
+    for(int k = 0; k < 100; k++){
+        recordMove(journal, board, 0, 0, k % 3 + 1);
+    }
+    printf("After 100 moves: cell %d, empty %ld (expected 1, 8)\n", getCell(board, 0, 0), board->emptyCells);
+
+    // Undo everything, then redo one move
+    int undone = 0;
+    while(undoMove(journal, board)){
+        undone++;
+    }
+    printf("Undone %d moves: cell %d, empty %ld, row has 1: %d (expected 100, 0, 9, 0)\n",
+           undone, getCell(board, 0, 0), board->emptyCells, rowContains(board, 0, 1));
+    redoMove(journal, board);
+    printf("Redone one move: cell %d, column has 1: %d (expected 1, 1)\n", getCell(board, 0, 0), columnContains(board, 0, 1));
+
+    // A new move drops the moves that were undone
+    recordMove(journal, board, 1, 1, 2);
+    printf("New move: journal has %ld moves, redo possible: %d (expected 2, 0)\n", journal->count, redoMove(journal, board));
+
+    freeMoveJournal(journal);
+    freeLatinBoard(board);
+    printf("Journal test completed.\n");
+    return 0;
+}
+#endif // DEBUG_LJOURNAL
@@ -0,0 +1,94 @@
+/**
+ * @file latinJournal.h
+ * @brief Header file for the journal of the moves of a Latin Square game.
+ *
+ * Every move is appended to the journal as the cell, the value it held before and the value
+ * it holds after. Undoing a move stores the old value back in the cell and redoing it stores
+ * the new value again, both through `setCell`, so the occupancy state of the board follows
+ * in constant time without validating the board again. A new move after some undone ones
+ * drops them, like in any editor.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs
+ */
+
+#ifndef LATINJOURNAL_H
+#define LATINJOURNAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "latinBoard.h"
+
+/**
+ * @brief One move of the journal.
+ */
+typedef struct {
+    int row; /**< Row index (0-based). */
+    int col; /**< Column index (0-based). */
+    uint16_t before; /**< Value of the cell before the move, 0 if it was empty. */
+    uint16_t after; /**< Value of the cell after the move, 0 if it was cleared. */
+} Move;
+
+/**
+ * @brief The moves of a game, of which the first `applied` are on the board.
+ */
+typedef struct {
+    Move *moves; /**< Moves in the order they were made. */
+    long count; /**< Number of moves in the journal. */
+    long applied; /**< Number of moves on the board, the rest were undone. */
+    long capacity; /**< Number of moves allocated. */
+} MoveJournal;
+
+
+/**
+ * @brief Allocates an empty journal.
+ *
+ * @param journal Pointer to store the allocated journal.
+ * @return EXIT_SUCCESS on success, or EXIT_FAILURE if memory runs out.
+ */
+int initMoveJournal(MoveJournal **journal);
+
+
+/**
+ * @brief Frees a journal.
+ *
+ * @param journal The journal to free (may be NULL).
+ */
+void freeMoveJournal(MoveJournal *journal);
+
+
+/**
+ * @brief Makes a move on the board and appends it to the journal.
+ *
+ * The move must already be valid. Moves that were undone are dropped.
+ *
+ * @param journal The journal.
+ * @param board The board.
+ * @param row Row index (0-based).
+ * @param col Column index (0-based).
+ * @param val Value to store (1..size), or 0 to clear the cell.
+ * @return EXIT_SUCCESS on success, or EXIT_FAILURE if memory runs out (the move is still made).
+ */
+int recordMove(MoveJournal *journal, LatinBoard *board, int row, int col, int val);
+
+
+/**
+ * @brief Takes back the last move on the board.
+ *
+ * @param journal The journal.
+ * @param board The board.
+ * @return true if a move was undone, false if there was none.
+ */
+bool undoMove(MoveJournal *journal, LatinBoard *board);
+
+
+/**
+ * @brief Makes the last undone move again.
+ *
+ * @param journal The journal.
+ * @param board The board.
+ * @return true if a move was redone, false if there was none.
+ */
+bool redoMove(MoveJournal *journal, LatinBoard *board);
+
+#endif // LATINJOURNAL_H
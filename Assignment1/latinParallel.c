@@ -0,0 +1,432 @@
+/**
+ * @file latinParallel.c
+ * @brief Implementation of the parallel search of Latin Square solutions.
+ *
+ * This file splits the search tree of a board into tasks and runs them on a pool of POSIX
+ * threads with one task queue per thread. A thread only locks another queue when its own
+ * queue is empty, so the queues are the only shared state apart from the result.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "latinParallel.h"
+#include "latinSolver.h"
+
+
+/**
+ * @brief Queue of tasks of one worker, consumed from both ends.
+ */
+typedef struct {
+    int *tasks; // task numbers
+    int head; // oldest task, taken by other workers
+    int tail; // one past the newest task, taken by the owner
+    pthread_mutex_t lock;
+} TaskQueue;
+
+/**
+ * @brief State shared by the workers of a search.
+ */
+typedef struct {
+    LatinBoard *board; // board being searched, receives the solution
+    uint32_t *cells; // row-major indices of the cells filled by each task, one task after the other
+    uint16_t *values; // values of those cells
+    size_t cellCount; // entries of cells and values in use
+    size_t cellCapacity; // entries of cells and values allocated
+    size_t *start; // first entry of each task, with one more entry for the end
+    int taskCount; // number of tasks
+    int taskCapacity; // tasks allocated in start
+    TaskQueue *queues; // one queue per worker
+    int threads; // number of workers
+    bool countAll; // count every solution instead of stopping at the first one
+    int stop; // set once the workers should stop
+    pthread_mutex_t resultLock; // protects the fields below
+    bool found; // a solution was copied to the board
+    long long solutions; // solutions counted so far
+    bool failed; // a worker ran out of memory
+} SearchPool;
+
+/**
+ * @brief A worker thread and its private board.
+ */
+typedef struct {
+    SearchPool *pool;
+    int id; // number of the own queue
+    LatinBoard *board; // copy of the board the tasks are searched on
+    pthread_t thread;
+} Worker;
+
+
+/**
+ * @brief Appends the branch a solver stopped at as a new task.
+ *
+ * @param pool The shared state.
+ * @param solver The solver, stopped at a branch.
+ * @return EXIT_SUCCESS on success, or EXIT_FAILURE if memory runs out.
+ */
+static int addTask(SearchPool *pool, const LatinSolver *solver){
+    size_t needed = pool->cellCount + (size_t) solver->depth;
+    if(needed > pool->cellCapacity){
+        size_t capacity = 2 * needed + 1024;
+        uint32_t *cells = (uint32_t *) realloc(pool->cells, capacity * sizeof(uint32_t));
+        if(cells == NULL){
+            return EXIT_FAILURE;
+        }
+        pool->cells = cells;
+        uint16_t *values = (uint16_t *) realloc(pool->values, capacity * sizeof(uint16_t));
+        if(values == NULL){
+            return EXIT_FAILURE;
+        }
+        pool->values = values;
+        pool->cellCapacity = capacity;
+    }
+    if(pool->taskCount + 1 >= pool->taskCapacity){
+        int capacity = 2 * pool->taskCapacity + 64;
+        size_t *start = (size_t *) realloc(pool->start, (size_t) capacity * sizeof(size_t));
+        if(start == NULL){
+            return EXIT_FAILURE;
+        }
+        pool->start = start;
+        pool->taskCapacity = capacity;
+    }
+
+    // The cells of the branch are the first empty cells of the solver, in search order
+    for(long k = 0; k < solver->depth; k++){
+        pool->cells[pool->cellCount] = solver->empties[k];
+        pool->values[pool->cellCount] = solver->tried[k];
+        pool->cellCount++;
+    }
+    pool->taskCount++;
+    pool->start[pool->taskCount] = pool->cellCount;
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Splits the search of the board into at least a number of tasks.
+ *
+ * Runs the whole search down to a number of choices, one more every round, until it reaches
+ * enough branches or no branch gets that deep. Forced cells don't count as choices, so long
+ * chains of them don't lengthen the rounds.
+ *
+ * @param pool The shared state.
+ * @param target The number of tasks wanted.
+ * @return EXIT_SUCCESS on success, or EXIT_FAILURE if memory runs out.
+ */
+static int splitSearch(SearchPool *pool, int target){
+    for(long limit = 1; ; limit++){
+        LatinSolver *solver = NULL;
+        if(initLatinSolver(&solver, pool->board) != EXIT_SUCCESS){
+            return EXIT_FAILURE;
+        }
+        solver->choiceLimit = limit;
+
+        // Every branch with limit choices, or solution with fewer, becomes a task
+        pool->taskCount = 0;
+        pool->cellCount = 0;
+        bool deeper = false;
+        while(nextSolution(solver)){
+            if(addTask(pool, solver) != EXIT_SUCCESS){
+                restartSolver(solver); // leave the board in its initial state
+                freeLatinSolver(solver);
+                return EXIT_FAILURE;
+            }
+            deeper = deeper || (solver->depth < solver->emptyCount);
+        }
+        freeLatinSolver(solver);
+
+        if(pool->taskCount >= target || !deeper){
+            return EXIT_SUCCESS;
+        }
+    }
+}
+
+/**
+ * @brief Takes the newest task of the own queue, or else the oldest task of another queue.
+ *
+ * @param pool The shared state.
+ * @param id Number of the own queue.
+ * @return The task number, or -1 if every queue is empty.
+ */
+static int takeTask(SearchPool *pool, int id){
+    int task = -1;
+
+    TaskQueue *own = &(pool->queues[id]);
+    pthread_mutex_lock(&own->lock);
+    if(own->tail > own->head){
+        task = own->tasks[--(own->tail)];
+    }
+    pthread_mutex_unlock(&own->lock);
+
+    // Steal from the other queues in turn
+    for(int k = 1; task < 0 && k < pool->threads; k++){
+        TaskQueue *other = &(pool->queues[(id + k) % pool->threads]);
+        pthread_mutex_lock(&other->lock);
+        if(other->tail > other->head){
+            task = other->tasks[(other->head)++];
+        }
+        pthread_mutex_unlock(&other->lock);
+    }
+
+    return task;
+}
+
+/**
+ * @brief Marks the search as failed and stops the workers.
+ *
+ * @param pool The shared state.
+ */
+static void failSearch(SearchPool *pool){
+    pthread_mutex_lock(&pool->resultLock);
+    pool->failed = true;
+    pthread_mutex_unlock(&pool->resultLock);
+    __atomic_store_n(&pool->stop, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Searches one task on the board of a worker.
+ *
+ * @param worker The worker.
+ * @param task The task number.
+ */
+static void runTask(Worker *worker, int task){
+    SearchPool *pool = worker->pool;
+    LatinBoard *board = worker->board;
+    uint32_t size = (uint32_t) board->size;
+
+    // Fill the cells of the branch
+    for(size_t k = pool->start[task]; k < pool->start[task + 1]; k++){
+        setCell(board, (int) (pool->cells[k] / size), (int) (pool->cells[k] % size), pool->values[k]);
+    }
+
+    LatinSolver *solver = NULL;
+    if(initLatinSolver(&solver, board) != EXIT_SUCCESS){
+        failSearch(pool);
+        return;
+    }
+    solver->cancel = &pool->stop;
+
+    if(pool->countAll){
+        long long solutions = 0;
+        while(nextSolution(solver)){
+            solutions++;
+        }
+        pthread_mutex_lock(&pool->resultLock);
+        pool->solutions += solutions;
+        pthread_mutex_unlock(&pool->resultLock);
+    } else if(findSolution(solver)){
+        // The first solution found is copied to the board and stops the other workers
+        pthread_mutex_lock(&pool->resultLock);
+        if(!pool->found){
+            pool->found = true;
+            pool->solutions = 1;
+            for(int i = 0; i < board->size; i++){
+                for(int j = 0; j < board->size; j++){
+                    if(getCell(pool->board, i, j) == 0){
+                        setCell(pool->board, i, j, getCell(board, i, j));
+                    }
+                }
+            }
+        }
+        pthread_mutex_unlock(&pool->resultLock);
+        __atomic_store_n(&pool->stop, 1, __ATOMIC_RELAXED);
+    }
+
+    // Clear the branch, unless the search stopped in it and the worker is done anyway
+    if(solver->exhausted){
+        for(size_t k = pool->start[task]; k < pool->start[task + 1]; k++){
+            setCell(board, (int) (pool->cells[k] / size), (int) (pool->cells[k] % size), 0);
+        }
+    }
+    freeLatinSolver(solver);
+}
+
+/**
+ * @brief Thread function of a worker: runs tasks until there are none left or the search stops.
+ *
+ * @param arg The worker.
+ * @return NULL.
+ */
+static void *workerThread(void *arg){
+    Worker *worker = (Worker *) arg;
+    SearchPool *pool = worker->pool;
+
+    int task;
+    while(!__atomic_load_n(&pool->stop, __ATOMIC_RELAXED) && (task = takeTask(pool, worker->id)) >= 0){
+        runTask(worker, task);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Runs the workers over the tasks of a pool.
+ *
+ * @param pool The shared state, with its tasks.
+ * @return EXIT_SUCCESS on success, or EXIT_FAILURE if memory runs out or no thread starts.
+ */
+static int runWorkers(SearchPool *pool){
+    int threads = pool->threads;
+    Worker *workers = (Worker *) calloc((size_t) threads, sizeof(Worker));
+    pool->queues = (TaskQueue *) calloc((size_t) threads, sizeof(TaskQueue));
+    bool ready = (workers != NULL && pool->queues != NULL);
+
+    // Deal the tasks to the queues and give every worker its own copy of the board
+    int prepared = 0;
+    while(ready && prepared < threads){
+        TaskQueue *queue = &(pool->queues[prepared]);
+        queue->tasks = (int *) malloc(((size_t) pool->taskCount / threads + 1) * sizeof(int));
+        workers[prepared].pool = pool;
+        workers[prepared].id = prepared;
+        if(queue->tasks == NULL || copyLatinBoard(&workers[prepared].board, pool->board) != EXIT_SUCCESS){
+            free(queue->tasks);
+            ready = false;
+            break;
+        }
+        for(int task = prepared; task < pool->taskCount; task += threads){
+            queue->tasks[(queue->tail)++] = task;
+        }
+        pthread_mutex_init(&queue->lock, NULL);
+        prepared++;
+    }
+
+    if(!ready){
+        perror("Unable to allocate memory for the search.");
+        pool->failed = true;
+    } else if(threads == 1){
+        workerThread(&workers[0]);
+    } else{
+        int started = 0;
+        while(started < threads && pthread_create(&workers[started].thread, NULL, workerThread, &workers[started]) == 0){
+            started++;
+        }
+        if(started == 0){ // the tasks of workers that didn't start are stolen by the others
+            fprintf(stderr, "Error: unable to start threads.\n");
+            pool->failed = true;
+        }
+        for(int i = 0; i < started; i++){
+            pthread_join(workers[i].thread, NULL);
+        }
+    }
+
+    for(int i = 0; i < prepared; i++){
+        pthread_mutex_destroy(&pool->queues[i].lock);
+        free(pool->queues[i].tasks);
+        freeLatinBoard(workers[i].board);
+    }
+    free(pool->queues);
+    free(workers);
+    return pool->failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/**
+ * @brief Searches a board on a number of threads.
+ *
+ * @param board The board, which must not have conflicting cells.
+ * @param threads Number of worker threads.
+ * @param countAll Count every solution instead of stopping at the first one.
+ * @param solutions Pointer to store the number of solutions found.
+ * @return EXIT_SUCCESS on success, or EXIT_FAILURE if memory runs out or no thread starts.
+ */
+static int searchBoard(LatinBoard *board, int threads, bool countAll, long long *solutions){
+    SearchPool pool;
+    memset(&pool, 0, sizeof(pool));
+    pool.board = board;
+    pool.threads = threads;
+    pool.countAll = countAll;
+    pthread_mutex_init(&pool.resultLock, NULL);
+
+    // A single thread searches the whole board as one task
+    int status;
+    pool.taskCapacity = 2;
+    pool.start = (size_t *) calloc((size_t) pool.taskCapacity, sizeof(size_t));
+    if(pool.start == NULL){
+        status = EXIT_FAILURE;
+    } else if(threads == 1){
+        pool.taskCount = 1;
+        status = EXIT_SUCCESS;
+    } else{
+        status = splitSearch(&pool, threads * TASKS_PER_THREAD);
+    }
+
+    if(status == EXIT_SUCCESS && pool.taskCount > 0){
+        status = runWorkers(&pool);
+    }
+
+    *solutions = pool.solutions;
+    pthread_mutex_destroy(&pool.resultLock);
+    free(pool.cells);
+    free(pool.values);
+    free(pool.start);
+    return status;
+}
+
+int solveParallel(LatinBoard *board, int threads){
+    if(threads == 1){
+        return solveLatinSquare(board);
+    }
+    if(!isConsistentBoard(board)){
+        return EXIT_FAILURE;
+    }
+
+    long long solutions = 0;
+    if(searchBoard(board, threads, false, &solutions) != EXIT_SUCCESS || solutions == 0){
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+long long countSolutions(LatinBoard *board, int threads){
+    if(!isConsistentBoard(board)){
+        return 0;
+    }
+
+    long long solutions = 0;
+    if(searchBoard(board, threads, true, &solutions) != EXIT_SUCCESS){
+        return -1;
+    }
+    return solutions;
+}
+
+
+#ifdef DEBUG_LPARALLEL
+
+int main(){
+    LatinBoard *board = NULL;
+
+    // Solution counts of empty boards don't depend on the number of threads
+    int threadCounts[] = { 1, 2, 8 };
+    for(int t = 0; t < 3; t++){
+        initLatinBoard(&board, 5);
+        printf("Solutions of an empty 5x5 with %d threads: %lld (expected 161280)\n",
+               threadCounts[t], countSolutions(board, threadCounts[t]));
+        freeLatinBoard(board);
+    }
+
+    // The first solution found on several threads is a valid completion
+    initLatinBoard(&board, 12);
+    setGivenCell(board, 0, 0, 3);
+    setGivenCell(board, 5, 7, 3);
+    int result = solveParallel(board, 4);
+    printf("12x12 on 4 threads: %s, %ld empty cells, consistent %d, given kept %d (expected solved, 0, 1, 1)\n",
+           result == EXIT_SUCCESS ? "solved" : "not solved", board->emptyCells, isConsistentBoard(board),
+           getCell(board, 5, 7) == 3 && isGivenCell(board, 5, 7));
+    freeLatinBoard(board);
+
+    // A board without solutions
+    initLatinBoard(&board, 2);
+    setGivenCell(board, 0, 0, 1);
+    setGivenCell(board, 1, 1, 2);
+    printf("Unsolvable 2x2 on 4 threads: %s, %lld solutions (expected not solved, 0)\n",
+           solveParallel(board, 4) == EXIT_SUCCESS ? "solved" : "not solved", countSolutions(board, 4));
+    freeLatinBoard(board);
+
+    printf("Parallel search test completed.\n");
+    return 0;
+}
+#endif // DEBUG_LPARALLEL
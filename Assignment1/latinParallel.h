@@ -0,0 +1,50 @@
+/**
+ * @file latinParallel.h
+ * @brief Header file for the parallel search of Latin Square solutions.
+ *
+ * The search tree of a board is split at its shallow choices into tasks: the calling thread
+ * runs the solver until a fixed number of choices between two or more values, and every
+ * branch it reaches becomes a task holding the cells filled on the way. The tasks are dealt
+ * to per-thread queues and every worker takes the newest task of its own queue, or steals
+ * the oldest task of another queue once its own is empty. Each worker searches its tasks
+ * on a private copy of the board.
+ *
+ * When only one solution is needed, the first worker to find one copies it to the board and
+ * cancels the others. Otherwise the solutions of all tasks are counted.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs
+ */
+
+#ifndef LATINPARALLEL_H
+#define LATINPARALLEL_H
+
+#include "latinBoard.h"
+
+#define MAX_THREADS 256 /**< Maximum number of worker threads. */
+#define TASKS_PER_THREAD 16 /**< Number of tasks to split the search into for each thread. */
+
+
+/**
+ * @brief Fills a board with a solution using a number of threads.
+ *
+ * @param board The board to solve.
+ * @param threads Number of worker threads, from 1 to MAX_THREADS.
+ * @return EXIT_SUCCESS if the board was solved, or EXIT_FAILURE if it has no solution, its
+ *         filled cells conflict or the threads can't be started.
+ */
+int solveParallel(LatinBoard *board, int threads);
+
+
+/**
+ * @brief Counts the solutions of a board using a number of threads.
+ *
+ * The board is left in its initial state.
+ *
+ * @param board The board.
+ * @param threads Number of worker threads, from 1 to MAX_THREADS.
+ * @return The number of solutions, or -1 if memory runs out or the threads can't be started.
+ */
+long long countSolutions(LatinBoard *board, int threads);
+
+#endif // LATINPARALLEL_H
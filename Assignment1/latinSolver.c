@@ -0,0 +1,714 @@
+/**
+ * @file latinSolver.c
+ * @brief Implementation of the automatic solver of Latin Squares.
+ *
+ * This file provides the backtracking search with minimum remaining values cell selection,
+ * bitmask candidate sets and forward checking over the occupancy state of a board.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "latinSolver.h"
+#include "latinStats.h"
+
+
+int initLatinSolver(LatinSolver **solver, LatinBoard *board){
+    *solver = (LatinSolver *) malloc(sizeof(LatinSolver));
+    if(*solver == NULL){
+        perror("Unable to allocate memory for the solver.");
+        return EXIT_FAILURE;
+    }
+
+    LatinSolver *s = *solver;
+    int size = board->size;
+    s->board = board;
+    s->emptyCount = board->emptyCells;
+    s->depth = 0;
+    s->nodes = 0;
+    s->backtracks = 0;
+    s->restarts = 0;
+    s->nodeLimit = 0;
+    s->choices = 0;
+    s->choiceLimit = 0;
+    s->cancel = NULL;
+    s->seed = UINT64_C(0x9E3779B97F4A7C15);
+    s->pendingIndex = 0;
+    s->pendingValue = 0;
+    s->started = false;
+    s->exhausted = false;
+    s->interrupted = false;
+
+    size_t slots = (s->emptyCount > 0) ? (size_t) s->emptyCount : 1;
+    s->empties = (uint32_t *) malloc(slots * sizeof(uint32_t));
+    s->tried = (uint16_t *) calloc(slots, sizeof(uint16_t));
+    s->forced = (uint16_t *) calloc(slots, sizeof(uint16_t));
+    s->branching = (uint8_t *) calloc(slots, sizeof(uint8_t));
+    s->full = (uint64_t *) calloc((size_t) board->words, sizeof(uint64_t));
+    s->once = (uint64_t *) calloc((size_t) board->words, sizeof(uint64_t));
+    s->twice = (uint64_t *) calloc((size_t) board->words, sizeof(uint64_t));
+    if(s->empties == NULL || s->tried == NULL || s->forced == NULL || s->branching == NULL || s->full == NULL || s->once == NULL || s->twice == NULL){
+        perror("Unable to allocate memory for the solver.");
+        freeLatinSolver(s);
+        *solver = NULL;
+        return EXIT_FAILURE;
+    }
+
+    // Values 1..size are the candidates of an empty row and column
+    for(int val = 1; val <= size; val++){
+        s->full[val / 64] |= UINT64_C(1) << (val % 64);
+    }
+
+    // Collect the empty cells in row-major order
+    long k = 0;
+    for(int i = 0; i < size; i++){
+        for(int j = 0; j < size; j++){
+            if(getCell(board, i, j) == 0){
+                s->empties[k++] = (uint32_t) ((size_t) i * size + j);
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+void freeLatinSolver(LatinSolver *solver){
+    if(solver == NULL){
+        return;
+    }
+
+    addSearchStats(solver->nodes, solver->backtracks, solver->restarts);
+    free(solver->empties);
+    free(solver->tried);
+    free(solver->forced);
+    free(solver->branching);
+    free(solver->full);
+    free(solver->once);
+    free(solver->twice);
+    free(solver);
+}
+
+bool isConsistentBoard(const LatinBoard *board){
+    int size = board->size;
+    int words = board->words;
+    int *rowFilled = (int *) calloc((size_t) size, sizeof(int));
+    int *colFilled = (int *) calloc((size_t) size, sizeof(int));
+    bool consistent = (rowFilled != NULL && colFilled != NULL);
+
+    // A row or column has a repeated value when its mask has fewer bits than filled cells
+    for(int i = 0; consistent && i < size; i++){
+        for(int j = 0; j < size; j++){
+            if(getCell(board, i, j) != 0){
+                rowFilled[i]++;
+                colFilled[j]++;
+            }
+        }
+    }
+    for(int k = 0; consistent && k < size; k++){
+        int rowBits = 0, colBits = 0;
+        for(int w = 0; w < words; w++){
+            rowBits += __builtin_popcountll(board->rowUsed[(size_t) k * words + w]);
+            colBits += __builtin_popcountll(board->colUsed[(size_t) k * words + w]);
+        }
+        consistent = (rowBits == rowFilled[k] && colBits == colFilled[k]);
+    }
+
+    free(rowFilled);
+    free(colFilled);
+    return consistent;
+}
+
+/**
+ * @brief Returns word w of the candidate mask of a cell.
+ *
+ * @param solver The solver.
+ * @param index Row-major index of the cell.
+ * @param w Index of the word.
+ * @return The values that are used neither in the row nor in the column of the cell.
+ */
+static uint64_t candidateWord(const LatinSolver *solver, uint32_t index, int w){
+    const LatinBoard *board = solver->board;
+    size_t row = index / (uint32_t) board->size;
+    size_t col = index % (uint32_t) board->size;
+    return solver->full[w] & ~(board->rowUsed[row * board->words + w] | board->colUsed[col * board->words + w]);
+}
+
+/**
+ * @brief Counts the candidate values of a cell.
+ *
+ * @param solver The solver.
+ * @param index Row-major index of the cell.
+ * @return The number of candidates.
+ */
+static int countCandidates(const LatinSolver *solver, uint32_t index){
+    int count = 0;
+    for(int w = 0; w < solver->board->words; w++){
+        count += __builtin_popcountll(candidateWord(solver, index, w));
+    }
+    return count;
+}
+
+/**
+ * @brief Finds the smallest candidate of a cell that is larger than a given value.
+ *
+ * @param solver The solver.
+ * @param index Row-major index of the cell.
+ * @param after The last value tried, 0 for none.
+ * @return The next candidate, or 0 if there is none.
+ */
+static int nextCandidate(const LatinSolver *solver, uint32_t index, int after){
+    int first = after + 1;
+    for(int w = first / 64; w < solver->board->words; w++){
+        uint64_t mask = candidateWord(solver, index, w);
+        if(w == first / 64){
+            mask &= ~((UINT64_C(1) << (first % 64)) - 1); // drop the values already tried
+        }
+        if(mask != 0){
+            return w * 64 + __builtin_ctzll(mask);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Checks a row or column after an assignment.
+ *
+ * The line fails if one of its empty cells has no candidates or one of its missing values
+ * fits none of its empty cells. A missing value that fits a single cell becomes the pending
+ * value of the solver, unless another one is already pending.
+ *
+ * @param solver The solver.
+ * @param line Index of the row or column.
+ * @param isRow true for a row, false for a column.
+ * @return true if the line can still be completed.
+ */
+static bool checkLine(LatinSolver *solver, int line, bool isRow){
+    const LatinBoard *board = solver->board;
+    int size = board->size;
+    int words = board->words;
+    memset(solver->once, 0, (size_t) words * sizeof(uint64_t));
+    memset(solver->twice, 0, (size_t) words * sizeof(uint64_t));
+
+    // Collect the values that fit at least one and at least two empty cells
+    for(int k = 0; k < size; k++){
+        int row = isRow ? line : k;
+        int col = isRow ? k : line;
+        if(getCell(board, row, col) != 0){
+            continue;
+        }
+        uint32_t index = (uint32_t) ((size_t) row * size + col);
+        uint64_t any = 0;
+        for(int w = 0; w < words; w++){
+            uint64_t mask = candidateWord(solver, index, w);
+            solver->twice[w] |= solver->once[w] & mask;
+            solver->once[w] |= mask;
+            any |= mask;
+        }
+        if(any == 0){ // empty cell without candidates
+            return false;
+        }
+    }
+
+    // Every missing value needs a cell, and a value with a single cell is forced there
+    const uint64_t *used = (isRow ? board->rowUsed : board->colUsed) + (size_t) line * words;
+    for(int w = 0; w < words; w++){
+        uint64_t missing = solver->full[w] & ~used[w];
+        if(missing & ~solver->once[w]){
+            return false;
+        }
+        uint64_t single = missing & ~solver->twice[w];
+        if(single != 0 && solver->pendingValue == 0){
+            int val = w * 64 + __builtin_ctzll(single);
+            for(int k = 0; k < size; k++){
+                int row = isRow ? line : k;
+                int col = isRow ? k : line;
+                uint32_t index = (uint32_t) ((size_t) row * size + col);
+                if(getCell(board, row, col) == 0 && ((candidateWord(solver, index, w) >> (val % 64)) & 1)){
+                    solver->pendingIndex = index;
+                    solver->pendingValue = val;
+                    break;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Checks the lines crossing a row or column that a value was just placed in.
+ *
+ * Placing a value in a column removes it from the candidates of the empty cells of that
+ * column, so every row through one of them that misses the value still needs a cell for it
+ * elsewhere (and the same for a row and the columns through it).
+ *
+ * @param solver The solver.
+ * @param line Index of the row or column the value was placed in.
+ * @param isRow true for a row, false for a column.
+ * @param val The value placed.
+ * @return true if every crossing line still has a cell for the value.
+ */
+static bool checkCrossing(const LatinSolver *solver, int line, bool isRow, int val){
+    const LatinBoard *board = solver->board;
+    int size = board->size;
+
+    for(int k = 0; k < size; k++){
+        int row = isRow ? line : k;
+        int col = isRow ? k : line;
+        if(getCell(board, row, col) != 0){
+            continue;
+        }
+
+        // The crossing line through this cell is column col of a row, or row row of a column
+        bool missing = isRow ? !columnContains(board, col, val) : !rowContains(board, row, val);
+        bool placed = !missing;
+        for(int other = 0; !placed && other < size; other++){
+            int r = isRow ? other : row;
+            int c = isRow ? col : other;
+            placed = getCell(board, r, c) == 0 && !rowContains(board, r, val) && !columnContains(board, c, val);
+        }
+        if(!placed){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Search steps specialized to one order of board.
+ */
+typedef struct {
+    int (*scanCandidates)(const LatinSolver *solver, long *best, int bestCount); /**< The scan of pickCell for the cell with the fewest candidates. */
+    bool (*checkPlacement)(LatinSolver *solver, int row, int col, int val); /**< The forward check of an assignment. */
+} SearchKernel;
+
+/**
+ * @brief Scans the empty cells from the current depth for the one with the fewest candidates,
+ *        as pickCell does, on a board of order n with one mask word and one byte per cell.
+ *
+ * Every kernel inlines this with its own constant n, so the row and column of a cell are
+ * found with a multiplication instead of a division.
+ *
+ * @param solver The solver.
+ * @param best Position in `empties` of the best cell so far, updated.
+ * @param bestCount Number of candidates of the best cell so far.
+ * @param n Order of the board.
+ * @return The number of candidates of the best cell.
+ */
+static inline __attribute__((always_inline)) int scanCandidatesOf(const LatinSolver *solver, long *best, int bestCount, const int n){
+    const uint64_t *rowUsed = solver->board->rowUsed;
+    const uint64_t *colUsed = solver->board->colUsed;
+    uint64_t full = solver->full[0];
+
+    for(long k = solver->depth; bestCount > 1 && k < solver->emptyCount; k++){
+        uint32_t index = solver->empties[k];
+        int count = __builtin_popcountll(full & ~(rowUsed[index / n] | colUsed[index % n]));
+        if(count < bestCount){
+            *best = k;
+            bestCount = count;
+            if(count <= 1){ // dead end or forced value, no better cell exists
+                break;
+            }
+        }
+    }
+    return bestCount;
+}
+
+/**
+ * @brief Checks a row or column after an assignment, as checkLine does, on a board of order n
+ *        with one mask word and one byte per cell.
+ *
+ * @param solver The solver.
+ * @param line Index of the row or column.
+ * @param isRow true for a row, false for a column.
+ * @param n Order of the board.
+ * @return true if the line can still be completed.
+ */
+static inline __attribute__((always_inline)) bool checkLineOf(LatinSolver *solver, int line, bool isRow, const int n){
+    const uint8_t *cells = (const uint8_t *) solver->board->cells;
+    const uint64_t *rowUsed = solver->board->rowUsed;
+    const uint64_t *colUsed = solver->board->colUsed;
+    uint64_t full = solver->full[0];
+    uint64_t once = 0, twice = 0;
+
+    // Collect the values that fit at least one and at least two empty cells
+    for(int k = 0; k < n; k++){
+        int index = isRow ? line * n + k : k * n + line;
+        if(cells[index] != 0){
+            continue;
+        }
+        uint64_t mask = full & ~(isRow ? rowUsed[line] | colUsed[k] : rowUsed[k] | colUsed[line]);
+        if(mask == 0){ // empty cell without candidates
+            return false;
+        }
+        twice |= once & mask;
+        once |= mask;
+    }
+
+    // Every missing value needs a cell, and a value with a single cell is forced there
+    uint64_t missing = full & ~(isRow ? rowUsed[line] : colUsed[line]);
+    if(missing & ~once){
+        return false;
+    }
+    uint64_t single = missing & ~twice;
+    if(single != 0 && solver->pendingValue == 0){
+        int val = __builtin_ctzll(single);
+        for(int k = 0; k < n; k++){
+            int index = isRow ? line * n + k : k * n + line;
+            uint64_t mask = full & ~(isRow ? rowUsed[line] | colUsed[k] : rowUsed[k] | colUsed[line]);
+            if(cells[index] == 0 && ((mask >> val) & 1)){
+                solver->pendingIndex = (uint32_t) index;
+                solver->pendingValue = val;
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Checks the lines crossing a row or column after an assignment, as checkCrossing
+ *        does, on a board of order n with one mask word and one byte per cell.
+ *
+ * @param solver The solver.
+ * @param line Index of the row or column the value was placed in.
+ * @param isRow true for a row, false for a column.
+ * @param val The value placed.
+ * @param n Order of the board.
+ * @return true if every crossing line still has a cell for the value.
+ */
+static inline __attribute__((always_inline)) bool checkCrossingOf(const LatinSolver *solver, int line, bool isRow, int val, const int n){
+    const uint8_t *cells = (const uint8_t *) solver->board->cells;
+    const uint64_t *rowUsed = solver->board->rowUsed;
+    const uint64_t *colUsed = solver->board->colUsed;
+    uint64_t bit = UINT64_C(1) << val;
+
+    for(int k = 0; k < n; k++){
+        int row = isRow ? line : k;
+        int col = isRow ? k : line;
+        if(cells[row * n + col] != 0){
+            continue;
+        }
+
+        // The crossing line through this cell is column col of a row, or row row of a column
+        bool placed = isRow ? (colUsed[col] & bit) != 0 : (rowUsed[row] & bit) != 0;
+        for(int other = 0; !placed && other < n; other++){
+            int r = isRow ? other : row;
+            int c = isRow ? col : other;
+            placed = cells[r * n + c] == 0 && !((rowUsed[r] | colUsed[c]) & bit);
+        }
+        if(!placed){
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Forward checks an assignment on a board of order n: its row and column, then the
+ *        lines crossing them, like the generic search.
+ *
+ * @param solver The solver.
+ * @param row Row of the assigned cell.
+ * @param col Column of the assigned cell.
+ * @param val The value assigned.
+ * @param n Order of the board.
+ * @return true if the branch can still be completed.
+ */
+static inline __attribute__((always_inline)) bool checkPlacementOf(LatinSolver *solver, int row, int col, int val, const int n){
+    return checkLineOf(solver, row, true, n) && checkLineOf(solver, col, false, n)
+           && checkCrossingOf(solver, row, true, val, n) && checkCrossingOf(solver, col, false, val, n);
+}
+
+/**
+ * @brief Defines the kernels of the search for boards of order N.
+ */
+#define SEARCH_KERNEL(N) \
+    static int scanCandidates##N(const LatinSolver *solver, long *best, int bestCount){ \
+        return scanCandidatesOf(solver, best, bestCount, N); \
+    } \
+    static bool checkPlacement##N(LatinSolver *solver, int row, int col, int val){ \
+        return checkPlacementOf(solver, row, col, val, N); \
+    }
+
+SEARCH_KERNEL(4)
+SEARCH_KERNEL(5)
+SEARCH_KERNEL(6)
+SEARCH_KERNEL(7)
+SEARCH_KERNEL(8)
+SEARCH_KERNEL(9)
+SEARCH_KERNEL(10)
+SEARCH_KERNEL(11)
+SEARCH_KERNEL(12)
+SEARCH_KERNEL(13)
+SEARCH_KERNEL(14)
+SEARCH_KERNEL(15)
+SEARCH_KERNEL(16)
+
+#define KERNEL_ENTRY(N) { scanCandidates##N, checkPlacement##N } /**< The kernels of order N. */
+
+/**
+ * @brief The kernels of the orders KERNEL_MIN_SIZE to KERNEL_MAX_SIZE, in order.
+ */
+static const SearchKernel searchKernels[] = {
+    KERNEL_ENTRY(4), KERNEL_ENTRY(5), KERNEL_ENTRY(6), KERNEL_ENTRY(7), KERNEL_ENTRY(8),
+    KERNEL_ENTRY(9), KERNEL_ENTRY(10), KERNEL_ENTRY(11), KERNEL_ENTRY(12), KERNEL_ENTRY(13),
+    KERNEL_ENTRY(14), KERNEL_ENTRY(15), KERNEL_ENTRY(16)
+};
+
+/**
+ * @brief Returns the kernels of the order of a board.
+ *
+ * @param board The board.
+ * @return The kernels, or NULL if the board needs the generic search.
+ */
+static const SearchKernel *findSearchKernel(const LatinBoard *board){
+    if(board->size < KERNEL_MIN_SIZE || board->size > KERNEL_MAX_SIZE){
+        return NULL;
+    }
+    return &searchKernels[board->size - KERNEL_MIN_SIZE];
+}
+
+/**
+ * @brief Picks the next cell to fill and moves it to the current depth.
+ *
+ * The cell of a pending value is picked first, with its value forced. Otherwise the empty
+ * cell with the fewest candidates is picked.
+ *
+ * @param solver The solver.
+ * @param kernel The kernels of the order of the board, or NULL for the generic scan.
+ * @return The number of candidates of the picked cell, 0 if some cell has none.
+ */
+static int pickCell(LatinSolver *solver, const SearchKernel *kernel){
+    long best = solver->depth;
+    int bestCount = solver->board->size + 1;
+    solver->forced[solver->depth] = 0;
+
+    if(solver->pendingValue != 0){
+        for(long k = solver->depth; k < solver->emptyCount; k++){
+            if(solver->empties[k] == solver->pendingIndex){
+                best = k;
+                break;
+            }
+        }
+        solver->forced[solver->depth] = (uint16_t) solver->pendingValue;
+        solver->pendingValue = 0;
+        bestCount = 1;
+    }
+
+    if(kernel != NULL && bestCount > 1){
+        bestCount = kernel->scanCandidates(solver, &best, bestCount);
+    }
+    for(long k = solver->depth; kernel == NULL && bestCount > 1 && k < solver->emptyCount; k++){
+        int count = countCandidates(solver, solver->empties[k]);
+        if(count < bestCount){
+            best = k;
+            bestCount = count;
+            if(count <= 1){ // dead end or forced value, no better cell exists
+                break;
+            }
+        }
+    }
+
+    uint32_t index = solver->empties[best];
+    solver->empties[best] = solver->empties[solver->depth];
+    solver->empties[solver->depth] = index;
+    solver->tried[solver->depth] = 0;
+    return bestCount;
+}
+
+bool nextSolution(LatinSolver *solver){
+    LatinBoard *board = solver->board;
+    const SearchKernel *kernel = findSearchKernel(board);
+    bool forward = true;
+
+    if(solver->exhausted){
+        return false;
+    }
+    if(solver->started){ // continue from the previous solution
+        if(solver->emptyCount == 0){
+            solver->exhausted = true;
+            return false;
+        }
+        solver->depth--;
+        solver->choices -= solver->branching[solver->depth];
+        forward = false;
+    }
+    solver->started = true;
+
+    while(true){
+        if(forward){
+            if(solver->depth == solver->emptyCount || (solver->choiceLimit > 0 && solver->choices == solver->choiceLimit)){
+                return true; // every empty cell is filled, or the branch made enough choices
+            }
+            if((solver->nodeLimit > 0 && solver->nodes >= solver->nodeLimit)
+               || (solver->cancel != NULL && (solver->nodes & 1023) == 0 && __atomic_load_n(solver->cancel, __ATOMIC_RELAXED))){
+                solver->interrupted = true;
+                return false;
+            }
+            int count = pickCell(solver, kernel);
+            solver->branching[solver->depth] = (count > 1);
+            if(count == 0){ // forward check failed, undo the last value
+                if(solver->depth == 0){
+                    solver->exhausted = true;
+                    return false;
+                }
+                solver->depth--;
+                solver->backtracks++;
+                solver->choices -= solver->branching[solver->depth];
+            }
+        }
+
+        // Replace the value of the cell at the current depth with its next candidate
+        uint32_t index = solver->empties[solver->depth];
+        int row = (int) (index / (uint32_t) board->size);
+        int col = (int) (index % (uint32_t) board->size);
+        int after = solver->tried[solver->depth];
+        int forced = solver->forced[solver->depth];
+        if(after != 0){
+            setCell(board, row, col, 0);
+        }
+
+        int val = (forced != 0) ? ((after == 0) ? forced : 0) : nextCandidate(solver, index, after);
+        if(val == 0){ // no candidates left, backtrack
+            solver->tried[solver->depth] = 0;
+            if(solver->depth == 0){
+                solver->exhausted = true;
+                return false;
+            }
+            solver->depth--;
+            solver->backtracks++;
+            solver->choices -= solver->branching[solver->depth];
+            forward = false;
+            continue;
+        }
+
+        setCell(board, row, col, val);
+        solver->tried[solver->depth] = (uint16_t) val;
+        solver->nodes++;
+
+        // Forward check the row and column of the cell, on failure try its next value
+        solver->pendingValue = 0;
+        bool consistent = (kernel != NULL) ? kernel->checkPlacement(solver, row, col, val)
+                          : checkLine(solver, row, true) && checkLine(solver, col, false)
+                            && checkCrossing(solver, row, true, val) && checkCrossing(solver, col, false, val);
+        if(!consistent){
+            forward = false;
+            continue;
+        }
+        solver->choices += solver->branching[solver->depth];
+        solver->depth++;
+        forward = true;
+    }
+}
+
+void restartSolver(LatinSolver *solver){
+    // Clear the cells of the current branch
+    for(long k = 0; k < solver->depth; k++){
+        uint32_t index = solver->empties[k];
+        setCell(solver->board, (int) (index / (uint32_t) solver->board->size), (int) (index % (uint32_t) solver->board->size), 0);
+        solver->tried[k] = 0;
+    }
+
+    // Fisher-Yates shuffle of the empty cells with a xorshift generator
+    for(long k = solver->emptyCount - 1; k > 0; k--){
+        solver->seed ^= solver->seed << 13;
+        solver->seed ^= solver->seed >> 7;
+        solver->seed ^= solver->seed << 17;
+        long other = (long) (solver->seed % (uint64_t) (k + 1));
+        uint32_t index = solver->empties[k];
+        solver->empties[k] = solver->empties[other];
+        solver->empties[other] = index;
+    }
+
+    solver->depth = 0;
+    solver->choices = 0;
+    solver->pendingValue = 0;
+    solver->restarts++;
+    solver->started = false;
+    solver->exhausted = false;
+    solver->interrupted = false;
+}
+
+bool findSolution(LatinSolver *solver){
+    // Restart with twice the budget whenever the search runs out of it
+    long long budget = 4 * (long long) solver->emptyCount + 64;
+    solver->nodeLimit = solver->nodes + budget;
+    bool solved = nextSolution(solver);
+    while(!solved && solver->interrupted){
+        if(solver->cancel != NULL && __atomic_load_n(solver->cancel, __ATOMIC_RELAXED)){
+            break;
+        }
+        restartSolver(solver);
+        budget *= 2;
+        solver->nodeLimit = solver->nodes + budget;
+        solved = nextSolution(solver);
+    }
+    solver->nodeLimit = 0;
+    return solved;
+}
+
+int solveLatinSquare(LatinBoard *board){
+    if(!isConsistentBoard(board)){
+        return EXIT_FAILURE;
+    }
+
+    LatinSolver *solver = NULL;
+    if(initLatinSolver(&solver, board) != EXIT_SUCCESS){
+        return EXIT_FAILURE;
+    }
+
+    bool solved = findSolution(solver);
+    freeLatinSolver(solver);
+    return solved ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+#ifdef DEBUG_LSOLVER
+
+int main(){
+    LatinBoard *board = NULL;
+
+    // An empty board always has a solution
+    initLatinBoard(&board, 9);
+    int result = solveLatinSquare(board);
+    printf("Empty 9x9: %s, %ld empty cells, consistent %d (expected solved, 0, 1)\n",
+           result == EXIT_SUCCESS ? "solved" : "not solved", board->emptyCells, isConsistentBoard(board));
+    freeLatinBoard(board);
+
+    // Every solution of an empty 4x4 board is found exactly once
+    initLatinBoard(&board, 4);
+    LatinSolver *solver = NULL;
+    initLatinSolver(&solver, board);
+    long solutions = 0;
+    while(nextSolution(solver)){
+        solutions++;
+    }
+    printf("Solutions of an empty 4x4: %ld (expected 576), empty cells after the search: %ld (expected 16)\n",
+           solutions, board->emptyCells);
+    freeLatinSolver(solver);
+    freeLatinBoard(board);
+
+    // 1 _ / _ 2 has no solution
+    initLatinBoard(&board, 2);
+    setGivenCell(board, 0, 0, 1);
+    setGivenCell(board, 1, 1, 2);
+    result = solveLatinSquare(board);
+    printf("Unsolvable 2x2: %s (expected not solved)\n", result == EXIT_SUCCESS ? "solved" : "not solved");
+    freeLatinBoard(board);
+
+    // A repeated value in a row is rejected before searching
+    initLatinBoard(&board, 3);
+    setGivenCell(board, 0, 0, 1);
+    setGivenCell(board, 0, 1, 1);
+    printf("Conflicting 3x3: consistent %d (expected 0)\n", isConsistentBoard(board));
+    freeLatinBoard(board);
+
+    printf("Solver test completed.\n");
+    return 0;
+}
+#endif // DEBUG_LSOLVER
@@ -0,0 +1,145 @@
+/**
+ * @file latinSolver.h
+ * @brief Header file for the automatic solver of Latin Squares.
+ *
+ * The solver fills the empty cells of a board by backtracking search. At every step it
+ * picks the empty cell with the fewest candidate values (minimum remaining values), where
+ * the candidates of a cell are computed from the row and column bitmasks of the board.
+ * A cell with a single candidate is filled without looking further.
+ *
+ * After every assignment the row and column of the cell are checked (forward checking):
+ * the branch ends if one of their empty cells has no candidates or one of their missing
+ * values has no cell left, and a missing value with a single cell is placed next.
+ *
+ * The search is iterative, so its depth is only limited by the memory of the board. When
+ * only one solution is needed, the search is restarted with the empty cells in a new random
+ * order whenever it runs out of a node budget, and the budget doubles on every restart, so
+ * an unlucky early choice can't keep it backtracking for long.
+ *
+ * Boards of order KERNEL_MIN_SIZE to KERNEL_MAX_SIZE, where every mask is a single word
+ * and every cell a byte, are searched with kernels generated for each order by a macro,
+ * whose loops run to a constant instead of the size of the board. The other orders use
+ * the generic search, and both visit the same nodes in the same order.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs
+ */
+
+#ifndef LATINSOLVER_H
+#define LATINSOLVER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "latinBoard.h"
+
+#define KERNEL_MIN_SIZE 4 /**< Smallest order with a specialized search kernel. */
+#define KERNEL_MAX_SIZE 16 /**< Largest order with a specialized search kernel. */
+
+/**
+ * @brief State of a search over the empty cells of a board.
+ */
+typedef struct {
+    LatinBoard *board; /**< The board being filled. */
+    uint32_t *empties; /**< Row-major indices of the cells that were empty, filled ones first. */
+    uint16_t *tried; /**< Value tried at each depth of the search, 0 if none yet. */
+    uint16_t *forced; /**< Only value allowed at each depth of the search, 0 if any. */
+    long emptyCount; /**< Number of cells that were empty when the search started. */
+    long depth; /**< Number of empty cells filled by the current branch. */
+    uint64_t *full; /**< Mask with the bits of the values 1..size set. */
+    uint64_t *once; /**< Scratch mask of the values with at least one cell in a line. */
+    uint64_t *twice; /**< Scratch mask of the values with at least two cells in a line. */
+    uint32_t pendingIndex; /**< Cell of the value forced by the last forward check. */
+    int pendingValue; /**< Value forced by the last forward check, 0 if none. */
+    long long nodes; /**< Number of values tried so far. */
+    long long backtracks; /**< Number of times the search went back to a shallower cell. */
+    long long restarts; /**< Number of times the search was restarted in a new order. */
+    long long nodeLimit; /**< Value of nodes at which the search stops, 0 for no limit. */
+    uint8_t *branching; /**< Set at each depth of the search where the cell had two or more candidates. */
+    long choices; /**< Number of depths of the current branch that are set in `branching`. */
+    long choiceLimit; /**< Number of choices at which a branch counts as a solution, 0 for no limit. */
+    const int *cancel; /**< The search stops once this flag is set by another thread, may be NULL. */
+    uint64_t seed; /**< State of the random generator that shuffles the empty cells. */
+    bool started; /**< Set once the search has started. */
+    bool exhausted; /**< Set once every solution has been found. */
+    bool interrupted; /**< Set when the search stopped at the node limit or was cancelled. */
+} LatinSolver;
+
+
+/**
+ * @brief Prepares a search over the empty cells of a board.
+ *
+ * @param solver Pointer to store the allocated solver.
+ * @param board The board to fill.
+ * @return EXIT_SUCCESS on success, or EXIT_FAILURE if memory runs out.
+ */
+int initLatinSolver(LatinSolver **solver, LatinBoard *board);
+
+
+/**
+ * @brief Frees a solver. The board is left as it is.
+ *
+ * The nodes, backtracks and restarts of the solver are added to the statistics of the run.
+ *
+ * @param solver The solver to free (may be NULL).
+ */
+void freeLatinSolver(LatinSolver *solver);
+
+
+/**
+ * @brief Checks that no value appears twice in a row or column of a board.
+ *
+ * The search relies on this, since a conflict of the pre-filled cells can't be undone.
+ *
+ * @param board The board to check.
+ * @return true if the filled cells don't conflict.
+ */
+bool isConsistentBoard(const LatinBoard *board);
+
+
+/**
+ * @brief Continues the search until the next solution.
+ *
+ * The first call fills the board with its first solution; every further call continues
+ * from the previous solution to the next one.
+ *
+ * @param solver The solver.
+ * @return true if a solution was found (and left on the board), or false if there are no
+ *         more solutions, in which case the board is back to its initial state, or if the
+ *         node limit was reached or the search was cancelled, in which case `interrupted`
+ *         is set.
+ */
+bool nextSolution(LatinSolver *solver);
+
+
+/**
+ * @brief Clears the cells filled by the search and starts it over in a new random order.
+ *
+ * @param solver The solver.
+ */
+void restartSolver(LatinSolver *solver);
+
+
+/**
+ * @brief Runs the search of a new solver until its first solution, restarting it whenever
+ *        it runs out of a doubling node budget.
+ *
+ * @param solver The solver, which has not been started.
+ * @return true if a solution was found (and left on the board), or false if there is none
+ *         or the search was cancelled.
+ */
+bool findSolution(LatinSolver *solver);
+
+
+/**
+ * @brief Fills a board with a solution.
+ *
+ * Uses restarts with a doubling node budget, so the solution found depends on the order
+ * of the restarts, but a board without solutions is still proven so.
+ *
+ * @param board The board to solve.
+ * @return EXIT_SUCCESS if the board was solved, or EXIT_FAILURE if it has no solution, its
+ *         filled cells conflict or memory runs out.
+ */
+int solveLatinSquare(LatinBoard *board);
+
+#endif // LATINSOLVER_H
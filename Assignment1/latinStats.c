@@ -0,0 +1,111 @@
+/**
+ * @file latinStats.c
+ * @brief Implementation of the runtime statistics of the game.
+ *
+ * This file provides the global record of the statistics, the phase timers and the JSON
+ * output of `--stats`.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "latinStats.h"
+
+LatinStats latinStats = { false, { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 }, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+/**
+ * @brief Reads a clock in seconds.
+ *
+ * @param clock The clock to read.
+ * @return The time of the clock, or 0 if it can't be read.
+ */
+static double clockSeconds(clockid_t clock){
+    struct timespec now;
+    if(clock_gettime(clock, &now) != 0){
+        return 0;
+    }
+    return (double) now.tv_sec + 1e-9 * (double) now.tv_nsec;
+}
+
+void enableLatinStats(void){
+    if(!latinStats.enabled){
+        latinStats.enabled = true;
+        atexit(printLatinStats); // the game exits from several places
+    }
+}
+
+LatinPhase startLatinPhase(void){
+    LatinPhase start = { 0, 0 };
+    if(latinStats.enabled){
+        start.wall = clockSeconds(CLOCK_MONOTONIC);
+        start.cpu = clockSeconds(CLOCK_PROCESS_CPUTIME_ID);
+    }
+    return start;
+}
+
+void endLatinPhase(LatinPhase *phase, LatinPhase start){
+    if(latinStats.enabled){
+        phase->wall += clockSeconds(CLOCK_MONOTONIC) - start.wall;
+        phase->cpu += clockSeconds(CLOCK_PROCESS_CPUTIME_ID) - start.cpu;
+    }
+}
+
+void addSearchStats(long long nodes, long long backtracks, long long restarts){
+    __atomic_fetch_add(&latinStats.nodes, nodes, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&latinStats.backtracks, backtracks, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&latinStats.restarts, restarts, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Prints a phase as a JSON member.
+ *
+ * @param name The name of the phase.
+ * @param phase The times of the phase.
+ */
+static void printPhase(const char *name, const LatinPhase *phase){
+    fprintf(stderr, "\"%s\":{\"wall_ms\":%.3f,\"cpu_ms\":%.3f},", name, 1e3 * phase->wall, 1e3 * phase->cpu);
+}
+
+void printLatinStats(void){
+    fflush(stdout); // keep the line after the output of the game
+    fprintf(stderr, "{\"phases\":{");
+    printPhase("read", &latinStats.read);
+    printPhase("validate", &latinStats.validation);
+    printPhase("solve", &latinStats.solve);
+    fprintf(stderr, "\"write\":{\"wall_ms\":%.3f,\"cpu_ms\":%.3f}},", 1e3 * latinStats.write.wall, 1e3 * latinStats.write.cpu);
+    fprintf(stderr, "\"moves\":%lld,\"invalid_moves\":%lld,\"records\":%lld,", latinStats.moves, latinStats.invalidMoves, latinStats.records);
+    fprintf(stderr, "\"nodes\":%lld,\"backtracks\":%lld,\"restarts\":%lld,", latinStats.nodes, latinStats.backtracks, latinStats.restarts);
+    fprintf(stderr, "\"cache\":{\"hits\":%lld,\"misses\":%lld}}\n", latinStats.cacheHits, latinStats.cacheMisses);
+}
+
+
+#ifdef DEBUG_LSTATS
+
+int main(){
+    // Nothing is timed before the statistics are enabled
+    LatinPhase start = startLatinPhase();
+    endLatinPhase(&latinStats.solve, start);
+    printf("Solve time while disabled: %.3f ms (expected 0)\n", 1e3 * latinStats.solve.wall);
+
+    enableLatinStats();
+    start = startLatinPhase();
+    volatile double sink = 0;
+    for(int i = 0; i < 1000000; i++){
+        sink += i;
+    }
+    endLatinPhase(&latinStats.solve, start);
+    printf("Busy loop: %.3f ms (above 0)\n", 1e3 * latinStats.solve.wall);
+
+    addSearchStats(100, 10, 1);
+    addSearchStats(50, 5, 0);
+    latinStats.moves = 3;
+    printf("Nodes %lld, backtracks %lld, restarts %lld (expected 150, 15, 1)\n", latinStats.nodes, latinStats.backtracks, latinStats.restarts);
+    printf("The JSON line follows on the standard error at exit.\n");
+    return 0;
+}
+#endif // DEBUG_LSTATS
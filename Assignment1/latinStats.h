@@ -0,0 +1,95 @@
+/**
+ * @file latinStats.h
+ * @brief Header file for the runtime statistics of the game (`--stats`).
+ *
+ * The statistics are kept in a single global record. The counters of the solver are kept
+ * in every `LatinSolver` anyway, so each solver adds them to the record once, when it is
+ * freed, with an atomic add, which works for the solvers of every thread. The other
+ * counters are plain increments of the record, and the clocks are only read once
+ * `enableLatinStats` was called, so without `--stats` a phase costs a single test.
+ *
+ * The record is printed as a single-line JSON object on the standard error when the
+ * program exits, however it exits.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs
+ */
+
+#ifndef LATINSTATS_H
+#define LATINSTATS_H
+
+#include <stdbool.h>
+
+/**
+ * @brief Wall-clock and processor time of a phase, in seconds.
+ */
+typedef struct {
+    double wall; /**< Elapsed real time. */
+    double cpu; /**< Processor time of every thread of the process. */
+} LatinPhase;
+
+/**
+ * @brief The counters and phase timers of a run.
+ */
+typedef struct {
+    bool enabled; /**< Set by `enableLatinStats`, the phases are not timed otherwise. */
+    LatinPhase read; /**< Reading the input board. */
+    LatinPhase solve; /**< Solving, counting or generating boards. */
+    LatinPhase write; /**< Writing boards. */
+    LatinPhase validation; /**< Checking moves, or the boards of `--verify`. */
+    long long moves; /**< Moves, undos and redos made on the board. */
+    long long invalidMoves; /**< Moves that were rejected. */
+    long long records; /**< Boards read by `--batch` or `--verify`. */
+    long long nodes; /**< Values tried by the solvers. */
+    long long backtracks; /**< Times a solver went back to a shallower cell. */
+    long long restarts; /**< Times a solver restarted in a new random order. */
+    long long cacheHits; /**< Boards solved from the solution cache. */
+    long long cacheMisses; /**< Boards searched for because the solution cache had none. */
+} LatinStats;
+
+extern LatinStats latinStats; /**< The statistics of the run. */
+
+
+/**
+ * @brief Starts collecting statistics and prints them when the program exits.
+ */
+void enableLatinStats(void);
+
+
+/**
+ * @brief Starts timing a phase.
+ *
+ * @return The current wall-clock and processor times, or zeros when statistics are not collected.
+ */
+LatinPhase startLatinPhase(void);
+
+
+/**
+ * @brief Adds the time elapsed since the start of a phase to it.
+ *
+ * Does nothing when statistics are not collected.
+ *
+ * @param phase The phase to add the elapsed time to.
+ * @param start The times returned by startLatinPhase.
+ */
+void endLatinPhase(LatinPhase *phase, LatinPhase start);
+
+
+/**
+ * @brief Adds the counters of a finished search to the statistics. Safe to call from any thread.
+ *
+ * @param nodes Values tried by the search.
+ * @param backtracks Times the search went back to a shallower cell.
+ * @param restarts Times the search was restarted.
+ */
+void addSearchStats(long long nodes, long long backtracks, long long restarts);
+
+
+/**
+ * @brief Prints the statistics as a single-line JSON object on the standard error.
+ *
+ * Times are printed in milliseconds.
+ */
+void printLatinStats(void);
+
+#endif // LATINSTATS_H
@@ -0,0 +1,166 @@
+/**
+ * @file latinVerify.c
+ * @brief Implementation of the check of completed Latin Squares.
+ *
+ * This file provides the mask reductions over the rows and columns of a board, the check
+ * of the pre-given cells of its puzzle and the description of the first violation.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "latinVerify.h"
+
+/**
+ * @brief Reads a cell of a board by its row-major index.
+ *
+ * @param board The board.
+ * @param index Row-major index of the cell.
+ * @return The value of the cell, 0 if it is empty.
+ */
+static int cellAt(const LatinBoard *board, size_t index){
+    if(board->cellBytes == 1){
+        return ((const uint8_t *) board->cells)[index];
+    }
+    return ((const uint16_t *) board->cells)[index];
+}
+
+/**
+ * @brief Counts the values set in a row or column mask.
+ *
+ * @param mask The first word of the mask.
+ * @param words Number of words of the mask.
+ * @return Number of bits set.
+ */
+static int maskBits(const uint64_t *mask, int words){
+    int bits = 0;
+    for(int w = 0; w < words; w++){
+        bits += __builtin_popcountll(mask[w]);
+    }
+    return bits;
+}
+
+/**
+ * @brief Describes the first repeated value of a full row or column.
+ *
+ * @param board The board, without empty cells.
+ * @param line The row or column that repeats a value.
+ * @param isRow true for a row, false for a column.
+ * @param violation Buffer for the description.
+ * @param length Size of the buffer.
+ */
+static void describeRepeat(const LatinBoard *board, int line, bool isRow, char *violation, size_t length){
+    int size = board->size;
+    int *seenAt = (int *) calloc((size_t) size + 1, sizeof(int)); // 1-based position of each value, 0 if not seen
+    for(int k = 0; seenAt != NULL && k < size; k++){
+        size_t index = isRow ? (size_t) line * size + k : (size_t) k * size + line;
+        int val = cellAt(board, index);
+        if(seenAt[val] != 0){
+            snprintf(violation, length, "%s %d repeats %d in %s %d and %d", isRow ? "row" : "column", line + 1, val,
+                     isRow ? "columns" : "rows", seenAt[val], k + 1);
+            free(seenAt);
+            return;
+        }
+        seenAt[val] = k + 1;
+    }
+
+    free(seenAt);
+    snprintf(violation, length, "%s %d repeats a value", isRow ? "row" : "column", line + 1); // no memory for the details
+}
+
+int verifyLatinSquare(const LatinBoard *board, const LatinBoard *puzzle, char *violation, size_t length){
+    int size = board->size;
+    int words = board->words;
+    size_t cells = (size_t) size * (size_t) size;
+
+    // The puzzle must have the same size and its givens must be kept
+    if(puzzle != NULL && puzzle->size != size){
+        snprintf(violation, length, "size %d does not match the puzzle of size %d", size, puzzle->size);
+        return EXIT_FAILURE;
+    }
+    for(size_t w = 0; puzzle != NULL && w < (cells + 63) / 64; w++){
+        for(uint64_t bits = puzzle->given[w]; bits != 0; bits &= bits - 1){
+            size_t index = w * 64 + (size_t) __builtin_ctzll(bits);
+            int expected = cellAt(puzzle, index);
+            int found = cellAt(board, index);
+            if(found != expected){
+                snprintf(violation, length, "cell (%d,%d) was given as %d but is %d", (int) (index / size) + 1,
+                         (int) (index % size) + 1, expected, found);
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    if(board->emptyCells != 0){
+        size_t index = 0;
+        while(cellAt(board, index) != 0){
+            index++;
+        }
+        snprintf(violation, length, "cell (%d,%d) is empty", (int) (index / size) + 1, (int) (index % size) + 1);
+        return EXIT_FAILURE;
+    }
+
+    // A full line holds every value once exactly when its mask has a bit for each cell
+    for(int i = 0; i < size; i++){
+        if(maskBits(board->rowUsed + (size_t) i * words, words) != size){
+            describeRepeat(board, i, true, violation, length);
+            return EXIT_FAILURE;
+        }
+    }
+    for(int j = 0; j < size; j++){
+        if(maskBits(board->colUsed + (size_t) j * words, words) != size){
+            describeRepeat(board, j, false, violation, length);
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+
+#ifdef DEBUG_LVERIFY
+
+int main(){
+    char violation[VIOLATION_LENGTH];
+    int n = 5;
+    LatinBoard *board = NULL, *puzzle = NULL;
+    if(initLatinBoard(&board, n) != EXIT_SUCCESS || initLatinBoard(&puzzle, n) != EXIT_SUCCESS){
+        printf("Failed to allocate the boards.\n");
+        return EXIT_FAILURE;
+    }
+
+    // The cyclic square (i + j) mod n + 1, with the diagonal given in the puzzle
+    for(int i = 0; i < n; i++){
+        for(int j = 0; j < n; j++){
+            setCell(board, i, j, (i + j) % n + 1);
+        }
+        setGivenCell(puzzle, i, i, (2 * i) % n + 1);
+    }
+    int status = verifyLatinSquare(board, puzzle, violation, sizeof(violation));
+    printf("Cyclic square: %s (expected pass)\n", (status == EXIT_SUCCESS) ? "pass" : violation);
+
+    // Swapping two cells of a row keeps the row but breaks two columns
+    setCell(board, 1, 3, 1);
+    setCell(board, 1, 4, 5);
+    status = verifyLatinSquare(board, NULL, violation, sizeof(violation));
+    printf("Swapped cells: %s (expected column 4 repeats 1 in rows 2 and 3)\n", (status == EXIT_SUCCESS) ? "pass" : violation);
+
+    // A changed given is reported before the lines
+    setCell(board, 1, 3, 4);
+    setCell(board, 1, 4, 1);
+    setCell(board, 1, 1, 4);
+    status = verifyLatinSquare(board, puzzle, violation, sizeof(violation));
+    printf("Changed given: %s (expected cell (2,2) was given as 3 but is 4)\n", (status == EXIT_SUCCESS) ? "pass" : violation);
+
+    setCell(board, 2, 2, 0);
+    status = verifyLatinSquare(board, NULL, violation, sizeof(violation));
+    printf("Cleared cell: %s (expected cell (3,3) is empty)\n", (status == EXIT_SUCCESS) ? "pass" : violation);
+
+    freeLatinBoard(board);
+    freeLatinBoard(puzzle);
+    printf("Verify test completed.\n");
+    return 0;
+}
+#endif // DEBUG_LVERIFY
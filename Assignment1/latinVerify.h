@@ -0,0 +1,40 @@
+/**
+ * @file latinVerify.h
+ * @brief Header file for checking completed Latin Squares (`--verify`).
+ *
+ * A completed board is checked against the occupancy state it already keeps: a row or
+ * column holds every value 1..n exactly once when the board has no empty cells and its
+ * mask has n bits set, so each line costs a popcount of its mask words. The pre-given
+ * cells of the puzzle are checked by walking the set bits of its `given` bitset.
+ *
+ * The slower work of finding which cells break a line is only done for a board that fails.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs
+ */
+
+#ifndef LATINVERIFY_H
+#define LATINVERIFY_H
+
+#include <stddef.h>
+#include "latinBoard.h"
+
+#define VIOLATION_LENGTH 96 /**< Size of a buffer that holds any violation message. */
+
+
+/**
+ * @brief Checks that a board is a completed Latin Square that keeps the givens of its puzzle.
+ *
+ * The checks are made in order and the first violation found is described: the size of the
+ * puzzle, its pre-given cells in row-major order, the empty cells in row-major order, then
+ * the rows and the columns from the first. Cells are numbered from 1, like the moves of the game.
+ *
+ * @param board The board to check.
+ * @param puzzle The puzzle the board solves, or NULL to only check the Latin property.
+ * @param violation Buffer for the description of the first violation.
+ * @param length Size of the buffer, VIOLATION_LENGTH is always enough.
+ * @return EXIT_SUCCESS if the board passes, or EXIT_FAILURE if it doesn't.
+ */
+int verifyLatinSquare(const LatinBoard *board, const LatinBoard *puzzle, char *violation, size_t length);
+
+#endif // LATINVERIFY_H
@@ -1,11 +1,11 @@
 /**
  * @file latinsquare.c
  * @brief Implementation of a Latin Square game.
- * 
+ *
  * This file contains the core functionality for handling a Latin Square game.
  * It provides options to load a Latin Square from a file, display it, accept
  * user inputs to modify the square, and save the final state to a file.
- * 
+ *
  * @author  Panagiotis Tsembekis
  * @since   21/09/2024
  * @bug     No known bugs
@@ -14,179 +14,358 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include "latinBoard.h"
+#include "latinFile.h"
+#include "latinSolver.h"
+#include "latinParallel.h"
+#include "latinJournal.h"
+#include "latinGenerator.h"
+#include "latinStats.h"
+#include "latinVerify.h"
+#include "latinCache.h"
+
+#define MOVE_COMMAND 0 /**< Command "i,j=val". */
+#define UNDO_COMMAND 1 /**< Command "u", undo the last move. */
+#define REDO_COMMAND 2 /**< Command "r", redo the last undone move. */
+
+#define DISPLAY_FULL 0 /**< Display the whole square on every prompt. */
+#define DISPLAY_QUIET 1 /**< Never display the square (`--quiet`). */
+#define DISPLAY_DIFF 2 /**< Display only the rows that changed since the last display (`--diff`). */
+
+static int binaryOutput = 0; /**< Save boards as board images: set by `--binary` or by reading one. */
+static int displayMode = DISPLAY_FULL; /**< How displayLatinSquare renders the square. */
+static LatinCache *solutionCache = NULL; /**< Solutions of `--cache`, used by `--solve` and `--batch`, or NULL. */
 
-#define N 9 /**< Maximum size of a Latin Square. */
+/**
+ * @brief Output buffer of displayLatinSquare, kept between calls.
+ */
+static struct {
+    char *data; /**< Rendered text. */
+    size_t capacity; /**< Bytes allocated. */
+    LatinBoard *shown; /**< Copy of the square as last displayed, for DISPLAY_DIFF. */
+} display = { NULL, 0, NULL };
 
 /**
  * @brief Reads the Latin Square from a given file.
- * 
+ *
  * The function reads the size and values of a Latin Square from the input file.
  * It ensures that the file contains valid values and appropriate dimensions for the square.
- * 
+ * Negative values in the file are pre-given cells. Board images are detected automatically,
+ * and the board is then saved as an image too.
+ *
  * @param filename The name of the input file containing the Latin Square.
- * @param square 2D array representing the Latin Square.
- * @param size Pointer to store the size of the Latin Square.
+ * @param board Pointer to store the board of the Latin Square.
  */
-void readLatinSquare(const char *filename, short square[N][N], int *size);
+void readLatinSquare(const char *filename, LatinBoard **board);
 
 
 /**
  * @brief Writes the current state of the Latin Square to a file.
- * 
- * The function writes the size and current values of the Latin Square to an output file.
- * The output file name is prefixed with "out-".
- * 
+ *
+ * The function writes the size and current values of the Latin Square to an output file,
+ * with pre-given cells written as negative values, or as a board image with `--binary` or
+ * when the board was read from one. The output file name is prefixed with "out-".
+ *
  * @param filename The name of the original input file (used for constructing output file name).
- * @param square 2D array representing the Latin Square.
- * @param size Size of the Latin Square.
+ * @param board The board of the Latin Square.
  */
-void writeLatinSquare(const char *filename, short square[N][N], int size);
+void writeLatinSquare(const char *filename, const LatinBoard *board);
 
 
 /**
  * @brief Displays the Latin Square in a formatted grid.
- * 
+ *
  * Prints the values of the Latin Square in a tabular format, highlighting pre-given values
- * using parentheses.
- * 
- * @param square 2D array representing the Latin Square.
- * @param size Size of the Latin Square.
+ * using parentheses. Cells are as wide as the largest value needs. The grid is rendered into
+ * a buffer that is kept between calls and written with a single `fwrite`. With `--quiet`
+ * nothing is displayed, and with `--diff` only the rows that changed since the last display
+ * are printed, each after a line with its number.
+ *
+ * @param board The board of the Latin Square.
+ */
+void displayLatinSquare(const LatinBoard *board);
+
+
+/**
+ * @brief Frees the buffers of displayLatinSquare.
  */
-void displayLatinSquare(short square[N][N], int size);
+void releaseDisplay(void);
 
 
 /**
  * @brief Checks if the user input is valid for the Latin Square.
- * 
+ *
  * This function validates the user input (i, j, val) for the Latin Square based on several criteria:
  * - Indices must be within bounds.
  * - Values should not be inserted in pre-given cells.
  * - A value cannot appear more than 'size' times in the square.
  * - Values cannot be repeated in the same row or column.
- * 
+ *
+ * The checks use the occupancy state of the board, so they take constant time.
+ *
  * @param i Row index.
  * @param j Column index.
  * @param val Value to be inserted.
- * @param size Size of the Latin Square.
- * @param square 2D array representing the Latin Square.
+ * @param board The board of the Latin Square.
  * @return Returns 0 if the input is valid, or 1 if the input is invalid.
  */
-int checkUserInput(int i, int j, int val, int size, short square[N][N]);
+int checkUserInput(int i, int j, int val, const LatinBoard *board);
 
 
 /**
  * @brief Gets user input for modifying the Latin Square.
- * 
+ *
  * This function prompts the user for a command in the format "i,j=val" where:
  * - i, j are the row and column indices (1-based).
  * - val is the value to insert (or 0 to clear).
  * - "0,0=0" saves and exits the game.
- * 
+ *
+ * The commands "u" and "r" undo the last move and redo the last undone move.
+ *
  * @param i Pointer to store the row index.
  * @param j Pointer to store the column index.
  * @param val Pointer to store the value.
- * @param size Size of the Latin Square.
- * @param square 2D array representing the Latin Square.
+ * @param board The board of the Latin Square.
+ * @return MOVE_COMMAND, UNDO_COMMAND or REDO_COMMAND.
  */
-void getUserInput(int *i, int *j, int *val, int size, short square[N][N]);
+int getUserInput(int *i, int *j, int *val, const LatinBoard *board);
 
 
 /**
  * @brief Main function to play the Latin Square game.
- * 
+ *
  * This function serves as the main game loop, where user inputs are taken,
  * validated, and processed until the user chooses to exit or the game is completed.
- * 
- * @param square 2D array representing the Latin Square.
- * @param size Size of the Latin Square.
+ * Every move is kept in a journal, so it can be undone and redone.
+ *
+ * @param board The board of the Latin Square.
  * @param filename The name of the input file (used for saving state).
  */
-void play(short square[N][N], int size, const char *filename);
+void play(LatinBoard *board, const char *filename);
+
+
+/**
+ * @brief Solves the Latin Square without user input.
+ *
+ * Fills every empty cell of the board with the automatic solver, displays the solved
+ * square and saves it like a completed game. With countAll the number of solutions is
+ * printed instead and nothing is saved.
+ *
+ * @param board The board of the Latin Square.
+ * @param filename The name of the input file (used for saving state).
+ * @param threads Number of threads to search on.
+ * @param countAll Count every solution instead of solving the square.
+ * @return EXIT_SUCCESS if the square was solved, or EXIT_FAILURE if it has no solution.
+ */
+int solve(LatinBoard *board, const char *filename, int threads, int countAll);
+
+
+/**
+ * @brief Plays a script of moves on the Latin Square without displaying it.
+ *
+ * Every line of the script is a command of the game ("i,j=val", "u" or "r"). The moves are
+ * checked like the moves of a player and invalid ones are reported, but the square and the
+ * prompts are never displayed. The square is saved when the script ends, on "0,0=0", or when
+ * the square is completed.
+ *
+ * @param board The board of the Latin Square.
+ * @param filename The name of the input file (used for saving state).
+ * @param script The name of the file with the moves.
+ * @return EXIT_SUCCESS if the script was played, or EXIT_FAILURE if it can't be read.
+ */
+int replay(LatinBoard *board, const char *filename, const char *script);
+
+
+/**
+ * @brief Solves a stream of Latin Squares without user input.
+ *
+ * Reads every Latin Square record of the given files, or of the standard input for "-",
+ * solves it and writes it to the standard output. A record that can't be read or solved is
+ * written as a single line "0" and reported on the standard error, and the rest of the
+ * records are still processed.
+ *
+ * @param count Number of input files, 0 for the standard input.
+ * @param files Names of the input files.
+ * @param threads Number of threads to search each Latin Square on.
+ * @return EXIT_SUCCESS if every record was solved, otherwise EXIT_FAILURE.
+ */
+int batch(int count, char *files[], int threads);
+
+
+/**
+ * @brief Checks a stream of completed Latin Squares without solving them.
+ *
+ * Reads every Latin Square record of the solutions file, or of the standard input for "-",
+ * and writes a line "Board N: pass" or "Board N: fail, <first violation>" for it to the
+ * standard output. When a puzzles file is given, its records are paired with the solutions
+ * in order and the pre-given cells of each puzzle must keep their values in its solution.
+ * A record that can't be read fails with the reason, and the rest are still checked.
+ *
+ * @param solutions The name of the file with the completed squares.
+ * @param puzzles The name of the file with their puzzles, or NULL.
+ * @return EXIT_SUCCESS if every board passed, otherwise EXIT_FAILURE.
+ */
+int verify(const char *solutions, const char *puzzles);
+
+
+/**
+ * @brief Writes a random Latin Square puzzle to the standard output.
+ *
+ * @param size The order of the square.
+ * @param fill The fraction of the cells left as pre-given.
+ * @param seed Seed of the generator.
+ * @return EXIT_SUCCESS on success, or EXIT_FAILURE if the puzzle can't be generated.
+ */
+int generate(int size, double fill, uint64_t seed);
 
 
 /**
  * @brief Main entry point of the program.
- * 
+ *
  * This function initializes the game by loading the Latin Square from a file
- * and then starting the game loop.
- * 
+ * and then starting the game loop, or solving the square with `--solve`. With `--solve`,
+ * `-j N` searches on N threads and `--count` counts the solutions. `--batch` solves
+ * every record of a list of files or of the standard input. `--replay` plays a script of
+ * moves, `--generate` writes a random puzzle and `--verify` checks completed squares. `--binary` saves the results as board
+ * images. `--quiet` and `--diff` display the square never or only where it changed.
+ * `--cache` answers `--solve` and `--batch` from a file of solutions of equivalent squares.
+ * `--stats` prints the statistics of the run as JSON on the standard error at exit.
+ *
  * @param argc Argument count.
  * @param argv Argument vector containing the filename.
  * @return EXIT_SUCCESS if the program completes successfully, otherwise EXIT_FAILURE.
  */
 int main(int argc, char *argv[]){
 
-    if(argc != 2){ // check if arguments contain 2 inputs, ./latinsquare and input file name
+    // Remove the optional "-j N", "--cache FILE", "--count", "--binary", "--quiet", "--diff" and "--stats" from the arguments, the rest are positional
+    int threads = 1;
+    const char *cacheName = NULL;
+    int countAll = 0;
+    int positional = 1;
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--count") == 0){
+            countAll = 1;
+        } else if(strcmp(argv[i], "--binary") == 0){
+            binaryOutput = 1;
+        } else if(strcmp(argv[i], "--quiet") == 0){
+            displayMode = DISPLAY_QUIET;
+        } else if(strcmp(argv[i], "--diff") == 0){
+            displayMode = DISPLAY_DIFF;
+        } else if(strcmp(argv[i], "--stats") == 0){
+            enableLatinStats();
+        } else if(strcmp(argv[i], "--cache") == 0 && i + 1 < argc){
+            cacheName = argv[++i];
+        } else if(strcmp(argv[i], "-j") == 0 && i + 1 < argc){
+            threads = atoi(argv[++i]);
+            if(threads < 1 || threads > MAX_THREADS){
+                printf("Number of threads must be between 1 and %d.\n", MAX_THREADS);
+                return EXIT_FAILURE;
+            }
+        } else{
+            argv[positional++] = argv[i];
+        }
+    }
+    argc = positional;
+
+    if(cacheName != NULL && openLatinCache(&solutionCache, cacheName) != EXIT_SUCCESS){
+        perror("Error occurred while attempting to read the cache.");
+        return EXIT_FAILURE;
+    }
+
+    if(argc >= 2 && strcmp(argv[1], "--batch") == 0){ // solve every record of the given files
+        int result = batch(argc - 2, argv + 2, threads);
+        closeLatinCache(solutionCache);
+        return result;
+    }
+
+    if((argc == 3 || argc == 4) && strcmp(argv[1], "--verify") == 0){ // check completed squares, against their puzzles if given
+        return verify(argv[2], (argc == 4) ? argv[3] : NULL);
+    }
+
+    if((argc == 4 || argc == 5) && strcmp(argv[1], "--generate") == 0){ // write a random puzzle
+        uint64_t seed = (argc == 5) ? (uint64_t) strtoull(argv[4], NULL, 10) : (uint64_t) time(NULL);
+        return generate(atoi(argv[2]), atof(argv[3]), seed);
+    }
+
+    int solveMode = (argc == 3 && strcmp(argv[1], "--solve") == 0);
+    int replayMode = (argc == 4 && strcmp(argv[1], "--replay") == 0);
+    if(argc != 2 && !solveMode && !replayMode){ // check if arguments contain 2 inputs, ./latinsquare and input file name
         printf("Missing arguments.\n");
-        printf("Usage: ./latinsquares <game-file>\n");
+        printf("Usage: ./latinsquares [--binary] [--quiet | --diff] [--stats] [--solve [-j N] [--count] [--cache FILE]] <game-file>\n");
+        printf("       ./latinsquares [--binary] [--stats] --replay <moves-file> <game-file>\n");
+        printf("       ./latinsquares --batch [--binary] [--stats] [-j N] [--cache FILE] [game-file ...]\n");
+        printf("       ./latinsquares --generate [--binary] [--stats] <size> <fill> [seed]\n");
+        printf("       ./latinsquares --verify [--stats] <solutions-file> [puzzles-file]\n");
         return EXIT_FAILURE;
     }
 
-    const char *filename = argv[1]; // retrieve file name from arguments (2nd input)
-    short square[N][N];
-    int size;
+    const char *filename = argv[argc - 1]; // retrieve file name from arguments (last input)
+    LatinBoard *board = NULL;
 
     // Read values from file
-    readLatinSquare(filename, square, &size);
-
-    // Start game execution
-    play(square, size, filename);
+    LatinPhase start = startLatinPhase();
+    readLatinSquare(filename, &board);
+    endLatinPhase(&latinStats.read, start);
+
+    // Solve the square, or start game execution
+    int result = EXIT_SUCCESS;
+    if(solveMode){
+        result = solve(board, filename, threads, countAll);
+    } else if(replayMode){
+        result = replay(board, filename, argv[2]);
+    } else{
+        play(board, filename);
+    }
 
+    releaseDisplay();
+    freeLatinBoard(board);
+    closeLatinCache(solutionCache);
+    return result;
 }
 
-void readLatinSquare(const char *filename, short square[N][N], int *size){
+void readLatinSquare(const char *filename, LatinBoard **board){
     // Open file for reading
-    FILE *fp = fopen(filename, "r");
-
-    // Check file pointer
-    if(fp == NULL){
+    LatinReader *reader = NULL;
+    if(openLatinReader(&reader, filename) != EXIT_SUCCESS){
         perror("Error occurred while attempting to read from file.\n");
         exit(EXIT_FAILURE); // exit
     }
 
-    // Check n (size of latin square)
-    if(fscanf(fp, "%d", size) != 1 || *size <= 0 || *size > N){ // check fscanf return code and size's value
-        printf("Invalid size of Latin Square!\n");
-        fclose(fp);
-        exit(EXIT_FAILURE); // close file and exit
+    // Read the size and numbers of the square
+    if(isBoardImage(reader)){
+        binaryOutput = 1;
     }
-
-    // Read numbers of square from file
-    for(int i = 0; i < *size; i++){
-        for(int j = 0; j < *size; j++){
-            if(fscanf(fp, "%hd", &square[i][j]) != 1){ // check fscanf return code for error
-                printf("Error reading Latin Square values.\n");
-                fclose(fp);
-                exit(EXIT_FAILURE); // close file and exit
-            } else if(square[i][j] > *size || square[i][j] < -(*size)){ // check if values of latin square are in [1, size]
-                printf("File contains invalid values!\n");
-                fclose(fp);
-                exit(EXIT_FAILURE); // close file and exit
-            }
-        }
+    const char *error = NULL;
+    if(scanLatinSquare(reader, board, &error) != EXIT_SUCCESS){
+        printf("%s\n", error);
+        closeLatinReader(reader);
+        exit(EXIT_FAILURE); // close file and exit
     }
 
     // Check for extra data (rows/columns)
-    int extraValue;
-    if(fscanf(fp, "%d", &extraValue) == 1){  // check if there are extra rows or columns in the file
+    if(hasMoreData(reader)){  // check if there are extra rows or columns in the file
         printf("File contains more data than expected!\n");
-        fclose(fp);
+        freeLatinBoard(*board);
+        closeLatinReader(reader);
         exit(EXIT_FAILURE); // close file and exit
     }
 
-    fclose(fp); // close file if every check is passed
+    closeLatinReader(reader); // close file if every check is passed
 }
 
-void writeLatinSquare(const char *filename, short square[N][N], int size){
+void writeLatinSquare(const char *filename, const LatinBoard *board){
+    LatinPhase start = startLatinPhase();
+
     // Construct output file name
     char outfile[256] = "out-";
     strcat(outfile, filename);
 
     // Print messages before exit
     printf("\n\nSaving to %s...\n", outfile);
-    
+
     // Open file for writing
-    FILE *fp = fopen(outfile, "w");
+    FILE *fp = fopen(outfile, binaryOutput ? "wb" : "w");
 
     // Check file pointer
     if(fp == NULL){
@@ -194,49 +373,172 @@ void writeLatinSquare(const char *filename, short square[N][N], int size){
         exit(EXIT_FAILURE);
     }
 
-    // Write the size on 1st row
-    fprintf(fp, "%d\n", size);
+    // Write the size and the latin square's content
+    if(binaryOutput){
+        printBoardImage(fp, board);
+    } else{
+        printLatinSquare(fp, board);
+    }
 
-    // Write the latin square's content
-    for(int i = 0; i < size; i++){
-        for(int j = 0; j < size; j++){
-            if(j > 0){ fprintf(fp, " "); } // space in between numbers
-            fprintf(fp, "%hd", square[i][j]);
+    fclose(fp); // close file after finished writing
+    endLatinPhase(&latinStats.write, start);
+}
+
+/**
+ * @brief Appends a value padded with spaces to a given width.
+ *
+ * @param buffer The output buffer.
+ * @param value The value (non-negative).
+ * @param width The width of the field.
+ * @return Pointer past the field.
+ */
+static char *appendField(char *buffer, int value, int width){
+    char digits[12];
+    int count = 0;
+    do{
+        digits[count++] = (char) ('0' + value % 10);
+        value /= 10;
+    } while(value > 0);
+
+    for(int k = count; k < width; k++){
+        buffer[k] = ' ';
+    }
+    for(int k = 0; k < count; k++){
+        buffer[k] = digits[count - 1 - k];
+    }
+    return buffer + ((count > width) ? count : width);
+}
+
+/**
+ * @brief Appends the line of the cells of a row, as displayed.
+ *
+ * @param buffer The output buffer.
+ * @param board The board of the Latin Square.
+ * @param row The row.
+ * @param digits Width of the largest value.
+ * @return Pointer past the line.
+ */
+static char *appendRow(char *buffer, const LatinBoard *board, int row, int digits){
+    for(int j = 0; j < board->size; j++){
+        if(isGivenCell(board, row, j)){ // pre-given value, in parenthesis
+            memcpy(buffer, "| (", 3);
+            buffer = appendField(buffer + 3, getCell(board, row, j), digits);
+            *(buffer++) = ')';
+        } else{ // other values (given by user)
+            memcpy(buffer, "|  ", 3);
+            buffer = appendField(buffer + 3, getCell(board, row, j), digits + 1);
         }
-        fprintf(fp, "\n"); // new line after each row
+        *(buffer++) = ' ';
     }
+    memcpy(buffer, "|\n", 2); // change line every finished row
+    return buffer + 2;
+}
 
-    fclose(fp); // close file after finished writing
+/**
+ * @brief Writes out the display buffer if a number of bytes doesn't fit in it.
+ *
+ * @param end Pointer past the rendered text.
+ * @param bytes The number of bytes about to be rendered.
+ * @param limit The number of bytes of the buffer that can be rendered into.
+ * @return Pointer to continue rendering at.
+ */
+static char *reserveDisplay(char *end, size_t bytes, size_t limit){
+    if((size_t) (end - display.data) + bytes > limit){
+        fwrite(display.data, 1, (size_t) (end - display.data), stdout);
+        return display.data;
+    }
+    return end;
 }
 
-void displayLatinSquare(short square[N][N], int size){
-    // Print top border
-    for (int i = 0; i < size; i++) {
-        printf("+-----");
+void displayLatinSquare(const LatinBoard *board){
+    if(displayMode == DISPLAY_QUIET){
+        return;
     }
-    printf("+\n");
 
-    // Print rest of values with borders
-    for(int i = 0; i < size; i++){
-        for(int j = 0; j < size; j++){
-            if(square[i][j] < 0){ // check if value at i,j is negative (pre-given value)
-                printf("| (%-1d) ", -square[i][j]); // print number in parenthesis in space of two
-            } else{ // print other values (given by user)
-                printf("|  %-2d ", square[i][j]);
-            }
+    int size = board->size;
+
+    // Width of the largest value, cells are 4 characters wider
+    int digits = 1;
+    for(int v = size; v >= 10; v /= 10){
+        digits++;
+    }
+    size_t lineBytes = (size_t) size * (digits + 5) + 2;
+
+    // Keep a buffer for the whole grid, or for OUTPUT_CHUNK_SIZE bytes of a very large one, and a border line after it
+    size_t limit = (2 * (size_t) size + 1) * lineBytes;
+    if(limit > OUTPUT_CHUNK_SIZE){
+        limit = (2 * lineBytes + 16 > OUTPUT_CHUNK_SIZE) ? 2 * lineBytes + 16 : OUTPUT_CHUNK_SIZE;
+    }
+    size_t needed = limit + lineBytes;
+    if(display.capacity < needed){
+        char *data = (char *) realloc(display.data, needed);
+        if(data == NULL){
+            perror("Unable to allocate memory for the display.");
+            return;
         }
-        printf("|\n"); // change line every finished row
+        display.data = data;
+        display.capacity = needed;
+    }
 
-        // Print bottom border
-        for (int k = 0; k < size; k++) {
-            printf("+-----");
+    // Only the changed rows of a square that was already displayed
+    if(displayMode == DISPLAY_DIFF && display.shown != NULL && display.shown->size == size){
+        char *end = display.data;
+        for(int i = 0; i < size; i++){
+            int changed = 0;
+            for(int j = 0; j < size; j++){
+                if(getCell(display.shown, i, j) != getCell(board, i, j)){
+                    setCell(display.shown, i, j, getCell(board, i, j));
+                    changed = 1;
+                }
+            }
+            if(changed){
+                end = reserveDisplay(end, lineBytes + 16, limit);
+                end += sprintf(end, "Row %d:\n", i + 1);
+                end = appendRow(end, board, i, digits);
+            }
         }
-        printf("+\n");
+        fwrite(display.data, 1, (size_t) (end - display.data), stdout);
+        return;
+    }
+
+    // Border between rows
+    char *border = display.data + limit;
+    for(int k = 0; k < size; k++){
+        border[k * (digits + 5)] = '+';
+        memset(border + k * (digits + 5) + 1, '-', digits + 4);
+    }
+    memcpy(border + (size_t) size * (digits + 5), "+\n", 2);
+
+    // Print top border, then every row followed by its bottom border
+    char *end = display.data;
+    memcpy(end, border, lineBytes);
+    end += lineBytes;
+    for(int i = 0; i < size; i++){
+        end = reserveDisplay(end, 2 * lineBytes, limit);
+        end = appendRow(end, board, i, digits);
+        memcpy(end, border, lineBytes);
+        end += lineBytes;
+    }
+    fwrite(display.data, 1, (size_t) (end - display.data), stdout);
+
+    if(displayMode == DISPLAY_DIFF){ // remember the displayed square
+        freeLatinBoard(display.shown);
+        display.shown = NULL;
+        copyLatinBoard(&(display.shown), board);
     }
+}
 
+void releaseDisplay(void){
+    free(display.data);
+    freeLatinBoard(display.shown);
+    display.data = NULL;
+    display.capacity = 0;
+    display.shown = NULL;
 }
 
-int checkUserInput(int i, int j, int val, int size, short square[N][N]){
+int checkUserInput(int i, int j, int val, const LatinBoard *board){
+    int size = board->size;
+
     // If 0,0=0 go back to play(), save and exit the game
     if(i == 0 && j == 0 && val == 0){
         return 0;
@@ -249,66 +551,91 @@ int checkUserInput(int i, int j, int val, int size, short square[N][N]){
     }
 
     // Check if cell has pre-given value (can't be cleared)
-    if(square[i - 1][j - 1] < 0){
+    if(isGivenCell(board, i - 1, j - 1)){
         printf("\nError: illegal to modify pre-given cell\n");
         return 1;
     }
 
     // Check if cell is occupied
-    if(val != 0 && square[i - 1][j - 1] !=  0){
+    if(val != 0 && getCell(board, i - 1, j - 1) != 0){
         printf("\nError: cell is already occupied!\n");
         return 1;
     }
 
-    // Calculate total occurrences of val in square
-    int totalOccurrences = 0;
-    for(int row = 0; row < size; row++){
-        for(int col = 0; col < size; col++){
-            if(val!= 0 && abs(square[row][col]) == val){ // count number of occurances
-                totalOccurrences++;
-            }
-        }
+    // Clearing a cell needs no more checks
+    if(val == 0){
+        return 0;
     }
 
     // If total occurrences are equal or more than "size", user's move can't be executed
-    if(totalOccurrences >= size){
+    if(board->valueCount[val] >= size){
         printf("\nError: Illegal value insertion! | Number already appears %d times.\n", size);
         return 1;
     }
 
     // Check if the value already exists in the same row
-    for(int col = 0; col < size; col++){
-        if(val!= 0 &&  abs(square[i - 1][col]) == val){
-            printf("\nError: Illegal value insertion! | Value already exists in row %d!\n", i);
-            return 1;
-        }
+    if(rowContains(board, i - 1, val)){
+        printf("\nError: Illegal value insertion! | Value already exists in row %d!\n", i);
+        return 1;
     }
 
     // Check if the value already exists in the same column
-    for(int row = 0; row < size; row++){
-        if(val!= 0 && abs(square[row][j - 1]) == val){
-            printf("\nError: Illegal value insertion! | Value already exists in column %d!\n", j);
-            return 1;
-        }
+    if(columnContains(board, j - 1, val)){
+        printf("\nError: Illegal value insertion! | Value already exists in column %d!\n", j);
+        return 1;
     }
 
     return 0; // if every check is passed, return 0 for valid input
 }
 
-void getUserInput(int *i, int *j, int *val, int size, short square[N][N]){
+/**
+ * @brief Checks a move with checkUserInput and adds it to the statistics.
+ *
+ * @param i Row index.
+ * @param j Column index.
+ * @param val Value to be inserted.
+ * @param board The board of the Latin Square.
+ * @return Returns 0 if the input is valid, or 1 if the input is invalid.
+ */
+static int validateMove(int i, int j, int val, const LatinBoard *board){
+    LatinPhase start = startLatinPhase();
+    int result = checkUserInput(i, j, val, board);
+    endLatinPhase(&latinStats.validation, start);
+    latinStats.invalidMoves += result;
+    return result;
+}
+
+int getUserInput(int *i, int *j, int *val, const LatinBoard *board){
     int validInput = 0; // assume that input is valid
+    int size = board->size;
+    int c;
 
     while(!validInput){
         // Print the latin square's board
-        displayLatinSquare(square, size);
+        displayLatinSquare(board);
 
         // Print input prompt
         printf("Enter your command in the following format:\n");
         printf("+ i,j=val: for entering val at position (i,j)\n");
         printf("+ i,j=0 : for clearing cell (i,j)\n");
         printf("+ 0,0=0 : for saving and ending the game\n");
+        printf("+ u : for undoing the last move\n");
+        printf("+ r : for redoing the last undone move\n");
         printf("Notice: i,j,val numbering is from [1..%d]\n>", size);
 
+        // Check for undo or redo, otherwise give the character back to scanf
+        do{
+            c = getchar();
+        } while(c == ' ' || c == '\t' || c == '\n' || c == '\r');
+        if(c == 'u' || c == 'r'){
+            int command = (c == 'u') ? UNDO_COMMAND : REDO_COMMAND;
+            while(c != '\n' && c != EOF){ // ignore the rest of the line
+                c = getchar();
+            }
+            return command;
+        }
+        ungetc(c, stdin);
+
         // Read values for i, j and val
         if (scanf("%d,%d=%d", i, j, val) != 3) { // if input values are not exactly 3, the input's format is wrong
             while (getchar() != '\n') {};
@@ -318,58 +645,283 @@ void getUserInput(int *i, int *j, int *val, int size, short square[N][N]){
         }
     }
 
+    return MOVE_COMMAND;
 }
 
-void play(short square[N][N], int size, const char *filename){
+void play(LatinBoard *board, const char *filename){
 
     int gameOver = 0; // 1 = game had ended -> exit
     int i = 0, j = 0, val = 0;
-    
+    MoveJournal *journal = NULL;
+    if(initMoveJournal(&journal) != EXIT_SUCCESS){
+        freeLatinBoard(board);
+        exit(EXIT_FAILURE);
+    }
+
     while(gameOver != 1){
 
         // Get user's input
-        getUserInput(&i, &j, &val, size, square);
-
-        // Check for 0,0=0 input -> exit game
-        if(i == 0 && j == 0 && val == 0){
-            writeLatinSquare(filename, square, size); // write to output file
-            printf("Done.\n");
-            exit(EXIT_SUCCESS);
-        }
+        int command = getUserInput(&i, &j, &val, board);
 
         // Check validity of input
-        while (checkUserInput(i, j, val, size, square) == 1) {
+        while (command == MOVE_COMMAND && validateMove(i, j, val, board) == 1) {
             // If input is invalid (returns 1), get the user input again
-            getUserInput(&i, &j, &val, size, square);
+            command = getUserInput(&i, &j, &val, board);
         }
 
-        // Execute Move
-        if(val == 0){ // clear cell
-            square[i - 1][j - 1] = 0;   
-            printf("\nValue cleared!\n");
-        } else{ // insert value
-            square[i - 1][j - 1] = val;
-            printf("\nValue inserted!\n");
-        }
+        if(command == UNDO_COMMAND){ // take back the last move
+            bool undone = undoMove(journal, board);
+            latinStats.moves += undone;
+            printf(undone ? "\nMove undone!\n" : "\nNothing to undo!\n");
+            continue;
+        } else if(command == REDO_COMMAND){ // make the last undone move again
+            bool redone = redoMove(journal, board);
+            latinStats.moves += redone;
+            printf(redone ? "\nMove redone!\n" : "\nNothing to redo!\n");
+        } else{
+            // Check for 0,0=0 input -> exit game (also when entered after an invalid move)
+            if(i == 0 && j == 0 && val == 0){
+                writeLatinSquare(filename, board); // write to output file
+                printf("Done.\n");
+                freeMoveJournal(journal);
+                releaseDisplay();
+                freeLatinBoard(board);
+                exit(EXIT_SUCCESS);
+            }
 
-        // Check if game is over - board filled
-        int emptyCellCount = 0;
-        for(int i = 0; i < size; i++){
-            for(int j = 0; j < size; j++){
-                if(square[i][j] == 0){
-                    emptyCellCount++;
-                }
+            // Execute Move
+            recordMove(journal, board, i - 1, j - 1, val);
+            latinStats.moves++;
+            if(val == 0){ // clear cell
+                printf("\nValue cleared!\n");
+            } else{ // insert value
+                printf("\nValue inserted!\n");
             }
         }
 
-        if(emptyCellCount == 0){
+        // Check if game is over - board filled
+        if(board->emptyCells == 0){
             gameOver = 1;
             printf("\nGame completed!!!\n");
-            displayLatinSquare(square, size);
-            writeLatinSquare(filename, square, size);
+            displayLatinSquare(board);
+            writeLatinSquare(filename, board);
             printf("Done.\n");
         }
 
     }
 
+    freeMoveJournal(journal);
+}
+
+int solve(LatinBoard *board, const char *filename, int threads, int countAll){
+    LatinPhase start = startLatinPhase();
+    if(countAll){
+        long long solutions = countSolutions(board, threads);
+        endLatinPhase(&latinStats.solve, start);
+        if(solutions < 0){
+            return EXIT_FAILURE;
+        }
+        printf("The Latin Square has %lld solutions.\n", solutions);
+        return EXIT_SUCCESS;
+    }
+
+    int status = solveCachedLatinSquare(solutionCache, board, threads);
+    endLatinPhase(&latinStats.solve, start);
+    if(status != EXIT_SUCCESS){
+        printf("The Latin Square has no solution!\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("Latin Square solved!!!\n");
+    displayLatinSquare(board);
+    writeLatinSquare(filename, board);
+    printf("Done.\n");
+    return EXIT_SUCCESS;
+}
+
+int replay(LatinBoard *board, const char *filename, const char *script){
+    FILE *fp = fopen(script, "r");
+    if(fp == NULL){
+        perror("Error occurred while attempting to read from file.");
+        return EXIT_FAILURE;
+    }
+
+    MoveJournal *journal = NULL;
+    if(initMoveJournal(&journal) != EXIT_SUCCESS){
+        fclose(fp);
+        return EXIT_FAILURE;
+    }
+
+    int size = board->size;
+    char line[256];
+    while(board->emptyCells != 0 && fgets(line, sizeof(line), fp) != NULL){
+        // Ignore the rest of a line that is too long for the buffer
+        if(strchr(line, '\n') == NULL){
+            int c;
+            while((c = fgetc(fp)) != '\n' && c != EOF){};
+        }
+
+        char command = 0;
+        int i = 0, j = 0, val = 0;
+        if(sscanf(line, " %c", &command) != 1){ // skip empty lines
+            continue;
+        }
+        if(command == 'u'){
+            latinStats.moves += undoMove(journal, board);
+        } else if(command == 'r'){
+            latinStats.moves += redoMove(journal, board);
+        } else if(sscanf(line, "%d,%d=%d", &i, &j, &val) != 3){
+            printf("\nWrong format of command. Please enter the command as 'i,j=val', where i and j are between 1 and %d, and val is between 0 and %d.\n", size, size);
+        } else if(i == 0 && j == 0 && val == 0){ // save and stop
+            break;
+        } else if(validateMove(i, j, val, board) == 0){
+            recordMove(journal, board, i - 1, j - 1, val);
+            latinStats.moves++;
+        }
+    }
+
+    if(board->emptyCells == 0){
+        printf("\nGame completed!!!\n");
+    }
+    writeLatinSquare(filename, board);
+    printf("Done.\n");
+
+    freeMoveJournal(journal);
+    fclose(fp);
+    return EXIT_SUCCESS;
+}
+
+int batch(int count, char *files[], int threads){
+    static char *standardInput[] = { STDIN_NAME };
+    if(count == 0){ // read the standard input
+        count = 1;
+        files = standardInput;
+    }
+
+    long records = 0, solved = 0;
+    for(int f = 0; f < count; f++){
+        LatinReader *reader = NULL;
+        if(openLatinReader(&reader, files[f]) != EXIT_SUCCESS){ // a missing file counts as a record that can't be read
+            records++;
+            fprintf(stderr, "Record %ld (%s): Error occurred while attempting to read from file.\n", records, files[f]);
+            printFailedRecord(stdout, binaryOutput);
+            continue;
+        }
+        reader->failedRecords = true; // the output of --batch can be solved again
+
+        // Solve every record of the file until it ends or can't be read further
+        int status = EXIT_SUCCESS;
+        while(status != READ_END && status != READ_FATAL){
+            LatinBoard *board = NULL;
+            const char *error = NULL;
+            LatinPhase start = startLatinPhase();
+            status = scanLatinSquare(reader, &board, &error);
+            endLatinPhase(&latinStats.read, start);
+            if(status == READ_END){
+                break;
+            }
+
+            records++;
+            latinStats.records++;
+            start = startLatinPhase();
+            int result = (status == EXIT_SUCCESS) ? solveCachedLatinSquare(solutionCache, board, threads) : EXIT_FAILURE;
+            endLatinPhase(&latinStats.solve, start);
+            if(result == EXIT_SUCCESS){
+                start = startLatinPhase();
+                if(binaryOutput){
+                    printBoardImage(stdout, board);
+                } else{
+                    printLatinSquare(stdout, board);
+                }
+                endLatinPhase(&latinStats.write, start);
+                solved++;
+            } else{
+                if(status == EXIT_SUCCESS){
+                    error = "The Latin Square has no solution!";
+                }
+                fprintf(stderr, "Record %ld (%s): %s\n", records, files[f], error);
+                printFailedRecord(stdout, binaryOutput);
+            }
+            freeLatinBoard(board);
+        }
+
+        closeLatinReader(reader);
+    }
+
+    fprintf(stderr, "Solved %ld of %ld Latin Squares.\n", solved, records);
+    return (solved == records) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int verify(const char *solutions, const char *puzzles){
+    LatinReader *reader = NULL, *puzzleReader = NULL;
+    if(openLatinReader(&reader, solutions) != EXIT_SUCCESS || (puzzles != NULL && openLatinReader(&puzzleReader, puzzles) != EXIT_SUCCESS)){
+        perror("Error occurred while attempting to read from file.\n");
+        closeLatinReader(reader);
+        return EXIT_FAILURE;
+    }
+    reader->failedRecords = true; // the output of --batch marks the squares it didn't solve
+
+    // Check every record until the solutions end or can't be read further, reusing the boards
+    long records = 0, passed = 0;
+    LatinBoard *board = NULL, *puzzle = NULL;
+    int status = EXIT_SUCCESS, puzzleStatus = EXIT_SUCCESS;
+    while(status != READ_END && status != READ_FATAL){
+        const char *error = NULL;
+        char violation[VIOLATION_LENGTH];
+        LatinPhase start = startLatinPhase();
+        status = rescanLatinSquare(reader, &board, &error);
+        if(status != READ_END && puzzleReader != NULL && puzzleStatus != READ_END && puzzleStatus != READ_FATAL){
+            const char *puzzleError = NULL;
+            puzzleStatus = rescanLatinSquare(puzzleReader, &puzzle, &puzzleError);
+            if(puzzleStatus != EXIT_SUCCESS && status == EXIT_SUCCESS){
+                status = EXIT_FAILURE;
+                error = (puzzleStatus == READ_END) ? "No puzzle left for the square." : puzzleError;
+            }
+        } else if(status == EXIT_SUCCESS && puzzleReader != NULL){ // the puzzles ended before
+            status = EXIT_FAILURE;
+            error = (puzzleStatus == READ_END) ? "No puzzle left for the square." : "The puzzles can't be read further.";
+        }
+        endLatinPhase(&latinStats.read, start);
+        if(status == READ_END){
+            break;
+        }
+
+        records++;
+        latinStats.records++;
+        start = startLatinPhase();
+        if(status == EXIT_SUCCESS && verifyLatinSquare(board, puzzle, violation, sizeof(violation)) == EXIT_SUCCESS){
+            printf("Board %ld: pass\n", records);
+            passed++;
+        } else{
+            printf("Board %ld: fail, %s\n", records, (status == EXIT_SUCCESS) ? violation : error);
+        }
+        endLatinPhase(&latinStats.validation, start);
+    }
+
+    freeLatinBoard(board);
+    freeLatinBoard(puzzle);
+    closeLatinReader(reader);
+    closeLatinReader(puzzleReader);
+    fprintf(stderr, "Passed %ld of %ld Latin Squares.\n", passed, records);
+    return (passed == records) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int generate(int size, double fill, uint64_t seed){
+    LatinBoard *board = NULL;
+    LatinPhase start = startLatinPhase();
+    int status = generateLatinSquare(&board, size, fill, seed);
+    endLatinPhase(&latinStats.solve, start);
+    if(status != EXIT_SUCCESS){
+        return EXIT_FAILURE;
+    }
+
+    start = startLatinPhase();
+    if(binaryOutput){
+        printBoardImage(stdout, board);
+    } else{
+        printLatinSquare(stdout, board);
+    }
+    endLatinPhase(&latinStats.write, start);
+    freeLatinBoard(board);
+    return EXIT_SUCCESS;
 }
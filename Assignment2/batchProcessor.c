@@ -0,0 +1,676 @@
+/**
+ * @file batchProcessor.c
+ * @brief Implementation of the multithreaded batch processing of formula files.
+ *
+ * This source file provides a small pipeline built on POSIX threads. The calling thread
+ * reads the input file into a ring of batches, worker threads take filled batches in
+ * order and process them into in-memory output buffers (which spill to a temporary file
+ * when a batch's output gets too large), and a writer thread writes the
+ * processed batches to the output file strictly in input order. All threads share a
+ * single mutex and condition variable, which are only touched once per batch. With a
+ * single thread the same steps run one after the other on the calling thread.
+ *
+ * Every formula is checked for balanced parentheses right before it is processed, which
+ * replaces the separate validation pass over the input file.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "batchProcessor.h"
+#include "formulaExpander.h"
+#include "outputBuffer.h"
+#include "inputReader.h"
+#include "formulaCache.h"
+
+
+/**
+ * @brief Processing stage of a slot of the batch ring.
+ */
+typedef enum {
+    BATCH_FREE, // can be filled by the reader
+    BATCH_FILLED, // waiting for a worker
+    BATCH_PROCESSING, // taken by a worker
+    BATCH_DONE // waiting for the writer
+} BatchState;
+
+
+/**
+ * @brief A batch of formulas together with their output.
+ */
+typedef struct {
+    char *text; // copies of the formulas back to back, if the input isn't mapped
+    size_t textLength; // used bytes of text
+    size_t textCapacity; // allocated bytes of text
+    const char *line[BATCH_LINES]; // first character of each formula (in the mapping or in text)
+    size_t lineLength[BATCH_LINES]; // length of each formula (without newline)
+    int lines; // number of formulas in the batch
+    long firstLine; // line number of the first formula
+    int unbalanced; // number of unbalanced formulas in the batch
+    int failures; // number of formulas of the batch that couldn't be processed
+    OutputBuffer *output; // results of the formulas
+    OutputBuffer *messages; // error messages of the formulas
+    BatchState state; // processing stage
+} Batch;
+
+
+/**
+ * @brief State shared by the reader, the workers and the writer.
+ */
+typedef struct {
+    Batch *batches; // ring of batches
+    int slots; // number of batches in the ring
+    long total; // number of batches read so far
+    long nextToProcess; // next batch a worker takes
+    bool finished; // reader reached the end of the input
+    bool failed; // a thread ran out of memory or couldn't write
+    pthread_mutex_t lock; // protects everything above
+    pthread_cond_t changed; // signaled whenever a batch changes stage
+    ProcessMode mode; // what is computed for each formula
+    ErrorMode errors; // what is written for unbalanced formulas
+    long unbalanced; // unbalanced formulas written so far (writer only)
+    long failures; // formulas that couldn't be processed written so far (writer only)
+    const SymbolIndex *index; // symbol index for PROTONS_MODE and HIST_MODE
+    FILE *fout; // output file
+    bool collect; // statistics are collected
+    FormulaStats stats; // statistics of finished threads
+} BatchQueue;
+
+
+/**
+ * @brief Processes every formula of a batch into the batch's output buffer.
+ *
+ * A formula found in the cache is balanced and processed already, so its cached output
+ * line is copied. The output line of every other formula that is processed successfully
+ * is added to the cache, unless the output spilled to its temporary file while the line
+ * was written, which leaves only its end in memory.
+ *
+ * @param queue The shared state (mode and symbol index).
+ * @param batch The batch to process.
+ * @param workspace The worker's own reusable memory.
+ * @param cache The worker's own cache of output lines, or NULL.
+ * @param stats The worker's own statistics, or NULL.
+ * @return int Returns 0 on success, or 1 if memory runs out.
+ */
+static int processBatch(BatchQueue *queue, Batch *batch, FormulaWorkspace *workspace, FormulaCache *cache, FormulaStats *stats) {
+    char line[64];
+    AtomCounts atoms;
+    double start = (stats != NULL) ? wallSeconds() : 0;
+    clearOutputBuffer(batch->output);
+    clearOutputBuffer(batch->messages);
+    batch->unbalanced = 0;
+    batch->failures = 0;
+
+    for (int i = 0; i < batch->lines; i++) {
+        const char *formula = batch->line[i];
+        size_t length = batch->lineLength[i];
+        const char *cached;
+        size_t cachedLength;
+        int status;
+
+        if (cache != NULL && lookupFormula(cache, formula, length, &cached, &cachedLength)) { // repeated formula
+            if (appendOutput(batch->output, cached, cachedLength) != EXIT_SUCCESS) {
+                return EXIT_FAILURE;
+            }
+            if (stats != NULL) {
+                countFormulaAtoms(stats, formula, length);
+            }
+            continue;
+        }
+
+        if (!balancedParentheses(formula, length)) { // same message as validateParentheses
+            (batch->unbalanced)++;
+            int n = snprintf(line, sizeof(line), "Parentheses NOT balanced in line: %ld\n", batch->firstLine + i);
+            if (appendOutput(batch->messages, line, (size_t) n) != EXIT_SUCCESS) {
+                return EXIT_FAILURE;
+            }
+            if (queue->errors == PER_LINE_ERRORS
+                && appendOutput(batch->output, UNBALANCED_MARKER "\n", sizeof(UNBALANCED_MARKER)) != EXIT_SUCCESS) {
+                return EXIT_FAILURE;
+            }
+            continue;
+        }
+        if (queue->errors == ALL_OR_NOTHING && batch->unbalanced + batch->failures > 0) {
+            continue; // output will be discarded, only the balance of the rest is needed
+        }
+
+        size_t outputStart = batch->output->length; // the line stays in place unless the output is flushed to its spill
+        unsigned long flushes = batch->output->flushes;
+
+        if (queue->mode == EXPAND_MODE) {
+            status = expandFormula(formula, length, batch->output, workspace);
+        } else if (queue->mode == GROUPED_MODE) {
+            status = groupFormula(formula, length, batch->output, workspace);
+        } else if (queue->mode == HIST_MODE) {
+            status = formulaHistogram(formula, length, queue->index, workspace, &atoms);
+            if (status == EXIT_SUCCESS && writeHistogram(&atoms, queue->index, batch->output) != EXIT_SUCCESS) {
+                return EXIT_FAILURE;
+            }
+        } else {
+            long long totalAtomicNumber = 0;
+            status = formulaProtons(formula, length, queue->index, workspace, &totalAtomicNumber);
+            if (status == EXIT_SUCCESS) {
+                int n = snprintf(line, sizeof(line), "%lld\n", totalAtomicNumber);
+                if (appendOutput(batch->output, line, (size_t) n) != EXIT_SUCCESS) {
+                    return EXIT_FAILURE;
+                }
+            }
+        }
+
+        bool inMemory = (batch->output->flushes == flushes);
+        if (status == EXIT_SUCCESS && cache != NULL && inMemory) {
+            storeFormula(cache, formula, length, batch->output->data + outputStart, batch->output->length - outputStart);
+        }
+        if (status == EXIT_SUCCESS && stats != NULL) { // only counted for formulas that are processed
+            countFormulaShape(stats, formula, length, queue->mode == PROTONS_MODE || queue->mode == HIST_MODE);
+            countFormulaAtoms(stats, formula, length);
+        }
+
+        if (status != EXIT_SUCCESS) { // same message as the single-threaded version, printed in order by the writer
+            if (!inMemory) {
+                return EXIT_FAILURE; // part of the line was written already
+            }
+            batch->output->length = outputStart; // drop what was written of the line
+            (batch->failures)++;
+            if (appendOutput(batch->messages, "Error processing formula: ", 26) != EXIT_SUCCESS
+                || appendOutput(batch->messages, formula, length) != EXIT_SUCCESS
+                || appendOutputChar(batch->messages, '\n') != EXIT_SUCCESS) {
+                return EXIT_FAILURE;
+            }
+            if (queue->errors == PER_LINE_ERRORS
+                && appendOutput(batch->output, FAILED_MARKER "\n", sizeof(FAILED_MARKER)) != EXIT_SUCCESS) {
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    if (stats != NULL) {
+        stats->lines += batch->lines;
+        stats->unbalanced += batch->unbalanced;
+        stats->process += wallSeconds() - start;
+    }
+    return EXIT_SUCCESS;
+}
+
+
+/**
+ * @brief Worker thread: takes filled batches in order and processes them.
+ *
+ * @param arg The shared BatchQueue.
+ * @return void* Always NULL.
+ */
+static void *workerThread(void *arg) {
+    BatchQueue *queue = (BatchQueue *) arg;
+    FormulaWorkspace workspace;
+    FormulaCache *cache = NULL;
+    FormulaStats stats;
+    memset(&stats, 0, sizeof(stats));
+    bool ready = (initFormulaWorkspace(&workspace) == EXIT_SUCCESS);
+    if (ready && initFormulaCache(&cache, CACHE_SLOTS, CACHE_BYTES) != EXIT_SUCCESS) {
+        freeFormulaWorkspace(&workspace);
+        ready = false;
+    }
+
+    pthread_mutex_lock(&queue->lock);
+    if (!ready) {
+        queue->failed = true;
+    }
+
+    while (true) {
+        // Wait until the next batch is filled or there are no more batches
+        Batch *batch = &(queue->batches[queue->nextToProcess % queue->slots]);
+        while (!(queue->nextToProcess < queue->total && batch->state == BATCH_FILLED)
+               && !(queue->finished && queue->nextToProcess >= queue->total)) {
+            pthread_cond_wait(&queue->changed, &queue->lock);
+            batch = &(queue->batches[queue->nextToProcess % queue->slots]);
+        }
+        if (queue->nextToProcess >= queue->total) {
+            break; // reader finished and every batch was taken
+        }
+
+        batch->state = BATCH_PROCESSING;
+        (queue->nextToProcess)++;
+        pthread_mutex_unlock(&queue->lock);
+
+        bool ok = ready && (processBatch(queue, batch, &workspace, cache, queue->collect ? &stats : NULL) == EXIT_SUCCESS);
+
+        pthread_mutex_lock(&queue->lock);
+        if (!ok) {
+            queue->failed = true;
+        }
+        batch->state = BATCH_DONE;
+        pthread_cond_broadcast(&queue->changed);
+    }
+    if (ready && queue->collect) {
+        stats.cache = cache->stats;
+        countWorkspaceStacks(&stats, &workspace);
+        addFormulaStats(&queue->stats, &stats);
+    }
+    pthread_mutex_unlock(&queue->lock);
+
+    if (ready) {
+        freeFormulaCache(cache);
+        freeFormulaWorkspace(&workspace);
+    }
+    return NULL;
+}
+
+
+/**
+ * @brief Writes a processed batch to the output file and prints its messages.
+ *
+ * Once a formula is found unbalanced or can't be processed in ALL_OR_NOTHING mode, the
+ * output is discarded anyway, so nothing more is written to the staging file.
+ *
+ * @param queue The shared state (output file and unbalanced count).
+ * @param batch The processed batch.
+ * @param stats The writer's own statistics, or NULL.
+ * @return int Returns 0 on success, or 1 if writing fails.
+ */
+static int writeBatch(BatchQueue *queue, Batch *batch, FormulaStats *stats) {
+    double start = (stats != NULL) ? wallSeconds() : 0;
+    fwrite(batch->messages->data, 1, batch->messages->length, stdout);
+    queue->unbalanced += batch->unbalanced;
+    queue->failures += batch->failures;
+
+    if (queue->errors == ALL_OR_NOTHING && queue->unbalanced + queue->failures > 0) {
+        return EXIT_SUCCESS;
+    }
+    size_t written;
+    if (copyOutputBuffer(batch->output, queue->fout, &written) != EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+    if (stats != NULL) {
+        stats->bytesWritten += (long long) written;
+        stats->write += wallSeconds() - start;
+    }
+    return EXIT_SUCCESS;
+}
+
+
+/**
+ * @brief Writer thread: writes processed batches to the output file in input order.
+ *
+ * @param arg The shared BatchQueue.
+ * @return void* Always NULL.
+ */
+static void *writerThread(void *arg) {
+    BatchQueue *queue = (BatchQueue *) arg;
+    FormulaStats stats;
+    memset(&stats, 0, sizeof(stats));
+
+    pthread_mutex_lock(&queue->lock);
+    for (long next = 0; ; next++) {
+        Batch *batch = &(queue->batches[next % queue->slots]);
+        while (!(next < queue->total && batch->state == BATCH_DONE) && !(queue->finished && next >= queue->total)) {
+            pthread_cond_wait(&queue->changed, &queue->lock);
+        }
+        if (next >= queue->total) {
+            break; // every batch was written
+        }
+        pthread_mutex_unlock(&queue->lock);
+
+        bool ok = (writeBatch(queue, batch, queue->collect ? &stats : NULL) == EXIT_SUCCESS);
+
+        pthread_mutex_lock(&queue->lock);
+        if (!ok) {
+            queue->failed = true;
+        }
+        batch->state = BATCH_FREE; // slot can be refilled by the reader
+        pthread_cond_broadcast(&queue->changed);
+    }
+    if (queue->collect) {
+        addFormulaStats(&queue->stats, &stats);
+    }
+    pthread_mutex_unlock(&queue->lock);
+
+    return NULL;
+}
+
+
+/**
+ * @brief Reads up to BATCH_LINES formulas of the input file into a batch.
+ *
+ * Formulas of a mapped input are used in place. Otherwise they are only valid until the
+ * next line is read, so they are copied into the text of the batch.
+ *
+ * @param fin The input reader.
+ * @param batch The batch to fill.
+ * @param lineCount The number of lines read so far, updated with the lines of the batch.
+ * @param stats The reader's own statistics, or NULL.
+ * @return int Returns 0 on success, or 1 if memory runs out.
+ */
+static int fillBatch(InputReader *fin, Batch *batch, long *lineCount, FormulaStats *stats) {
+    const char *formula;
+    size_t length;
+    double start = (stats != NULL) ? wallSeconds() : 0;
+    batch->textLength = 0;
+    batch->lines = 0;
+    batch->firstLine = *lineCount + 1;
+
+    while (batch->lines < BATCH_LINES && nextLine(fin, &formula, &length)) {
+        batch->line[batch->lines] = formula;
+        batch->lineLength[batch->lines] = length;
+        (batch->lines)++;
+        if (fin->mapped) {
+            continue; // the mapping outlives the batch
+        }
+
+        if (batch->textLength + length > batch->textCapacity) { // double the text when full
+            size_t newCapacity = (batch->textCapacity > 0) ? 2 * batch->textCapacity : 64 * BATCH_LINES;
+            while (newCapacity < batch->textLength + length) {
+                newCapacity *= 2;
+            }
+            char *newPtr = (char *) realloc(batch->text, newCapacity);
+            if (newPtr == NULL) {
+                perror("Unable to allocate memory for batch.");
+                return EXIT_FAILURE;
+            }
+            batch->text = newPtr;
+            batch->textCapacity = newCapacity;
+        }
+
+        memcpy(batch->text + batch->textLength, formula, length);
+        batch->textLength += length;
+    }
+
+    // Copies are back to back, point at them once the text doesn't move anymore
+    if (!fin->mapped) {
+        size_t offset = 0;
+        for (int i = 0; i < batch->lines; i++) {
+            batch->line[i] = batch->text + offset;
+            offset += batch->lineLength[i];
+        }
+    }
+
+    *lineCount += batch->lines;
+    if (stats != NULL) {
+        for (int i = 0; i < batch->lines; i++) {
+            stats->bytesRead += (long long) batch->lineLength[i] + 1;
+        }
+        stats->read += wallSeconds() - start;
+    }
+    return EXIT_SUCCESS;
+}
+
+
+/**
+ * @brief Frees the memory of the batch ring.
+ *
+ * @param batches The batches to free.
+ * @param slots The number of batches.
+ */
+static void freeBatches(Batch *batches, int slots) {
+    for (int i = 0; i < slots; i++) {
+        free(batches[i].text);
+        freeOutputBuffer(batches[i].output);
+        freeOutputBuffer(batches[i].messages);
+    }
+    free(batches);
+}
+
+
+/**
+ * @brief Reads, processes and writes the batches one after the other on the calling thread.
+ *
+ * @param queue The shared state, with a single batch.
+ * @param fin The input reader.
+ */
+static void runInline(BatchQueue *queue, InputReader *fin) {
+    FormulaWorkspace workspace;
+    FormulaCache *cache = NULL;
+    if (initFormulaWorkspace(&workspace) != EXIT_SUCCESS) {
+        queue->failed = true;
+        return;
+    }
+    if (initFormulaCache(&cache, CACHE_SLOTS, CACHE_BYTES) != EXIT_SUCCESS) {
+        freeFormulaWorkspace(&workspace);
+        queue->failed = true;
+        return;
+    }
+
+    Batch *batch = &(queue->batches[0]);
+    FormulaStats *stats = queue->collect ? &(queue->stats) : NULL; // no other thread runs
+    long lineCount = 0;
+    while (!queue->failed) {
+        if (fillBatch(fin, batch, &lineCount, stats) != EXIT_SUCCESS) {
+            queue->failed = true;
+            break;
+        }
+        if (batch->lines == 0) {
+            break; // end of input
+        }
+        if (processBatch(queue, batch, &workspace, cache, stats) != EXIT_SUCCESS || writeBatch(queue, batch, stats) != EXIT_SUCCESS) {
+            queue->failed = true;
+        }
+    }
+
+    if (stats != NULL) {
+        addCacheStats(&stats->cache, &cache->stats);
+        countWorkspaceStacks(stats, &workspace);
+    }
+    freeFormulaCache(cache);
+    freeFormulaWorkspace(&workspace);
+}
+
+
+/**
+ * @brief Runs the reader on the calling thread with a writer and a pool of workers.
+ *
+ * @param queue The shared state, with 2 * threads + 1 batches.
+ * @param fin The input reader.
+ * @param threads The number of worker threads.
+ */
+static void runThreads(BatchQueue *queue, InputReader *fin, int threads) {
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->changed, NULL);
+
+    // Start the writer and the workers
+    pthread_t writer;
+    pthread_t workers[MAX_THREADS];
+    int started = 0;
+    bool writerStarted = (pthread_create(&writer, NULL, writerThread, queue) == 0);
+    while (writerStarted && started < threads && pthread_create(&workers[started], NULL, workerThread, queue) == 0) {
+        started++;
+    }
+
+    // This thread is the reader: fill free slots in order until the input ends
+    FormulaStats stats;
+    memset(&stats, 0, sizeof(stats));
+    long lineCount = 0;
+    pthread_mutex_lock(&queue->lock);
+    if (!writerStarted || started == 0) {
+        fprintf(stderr, "Error: unable to start threads.\n");
+        queue->failed = true;
+    }
+    while (!queue->failed) {
+        Batch *batch = &(queue->batches[queue->total % queue->slots]);
+        while (batch->state != BATCH_FREE) {
+            pthread_cond_wait(&queue->changed, &queue->lock);
+        }
+        pthread_mutex_unlock(&queue->lock);
+
+        int status = fillBatch(fin, batch, &lineCount, queue->collect ? &stats : NULL);
+
+        pthread_mutex_lock(&queue->lock);
+        if (status != EXIT_SUCCESS) {
+            queue->failed = true;
+            break;
+        }
+        if (batch->lines == 0) {
+            break; // end of input
+        }
+        batch->state = BATCH_FILLED;
+        (queue->total)++;
+        pthread_cond_broadcast(&queue->changed);
+    }
+    queue->finished = true;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+
+    // Wait for the batches already read to be processed and written
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    if (writerStarted) {
+        pthread_join(writer, NULL);
+    }
+    if (queue->collect) {
+        addFormulaStats(&queue->stats, &stats);
+    }
+
+    pthread_cond_destroy(&queue->changed);
+    pthread_mutex_destroy(&queue->lock);
+}
+
+
+/**
+ * @brief Checks if the output should be staged before it replaces the output file.
+ *
+ * Only a regular file, or one that doesn't exist yet, can be left with partial results;
+ * devices, terminals and FIFOs are written directly.
+ *
+ * @param outputFile The name of the output file.
+ * @return bool true if the output should be staged.
+ */
+static bool stagedOutput(const char *outputFile) {
+    struct stat info;
+    if (stat(outputFile, &info) != 0) {
+        return errno == ENOENT;
+    }
+    return S_ISREG(info.st_mode);
+}
+
+
+/**
+ * @brief Copies the staged output into the output file.
+ *
+ * @param staging The staging file, positioned anywhere.
+ * @param outputFile The name of the output file, truncated before the copy.
+ * @return int Returns 0 on success, or 1 if a file can't be read or written.
+ */
+static int copyStagedOutput(FILE *staging, const char *outputFile) {
+    if (fflush(staging) != 0 || fseek(staging, 0, SEEK_SET) != 0) {
+        perror("Unable to read staged output.");
+        return EXIT_FAILURE;
+    }
+    FILE *fout = fopen(outputFile, "w");
+    if (fout == NULL) {
+        perror("Unable to open output file for writing.");
+        return EXIT_FAILURE;
+    }
+
+    char chunk[1 << 16];
+    size_t n;
+    int status = EXIT_SUCCESS;
+    while (status == EXIT_SUCCESS && (n = fread(chunk, 1, sizeof(chunk), staging)) > 0) {
+        if (fwrite(chunk, 1, n, fout) != n) {
+            status = EXIT_FAILURE;
+        }
+    }
+    if (ferror(staging)) {
+        perror("Unable to read staged output.");
+        status = EXIT_FAILURE;
+    }
+    if (fclose(fout) != 0 || status != EXIT_SUCCESS) {
+        perror("Unable to write output.");
+        status = EXIT_FAILURE;
+    }
+    return status;
+}
+
+
+// Validate and process the formulas of a file in one pass, keeping the output in input order
+int processBatches(const char *inputFile, const char *outputFile, ProcessMode mode, const SymbolIndex *index,
+                   int threads, ErrorMode errors, FormulaStats *stats) {
+    if (threads < 1 || threads > MAX_THREADS) {
+        fprintf(stderr, "Error: number of threads must be between 1 and %d.\n", MAX_THREADS);
+        return EXIT_FAILURE;
+    }
+
+    InputReader *fin = NULL;
+    if (openInputReader(&fin, inputFile) != EXIT_SUCCESS) {
+        perror("Unable to open input file for batch processing.");
+        return EXIT_FAILURE;
+    }
+
+    // In all-or-nothing mode the output is staged and only copied to the output file at the end
+    bool staged = (errors == ALL_OR_NOTHING && stagedOutput(outputFile));
+    FILE *fout = staged ? tmpfile() : fopen(outputFile, "w");
+    if (fout == NULL) {
+        perror(staged ? "Unable to create staging file." : "Unable to open output file for writing.");
+        closeInputReader(fin);
+        return EXIT_FAILURE;
+    }
+
+    BatchQueue queue;
+    queue.slots = (threads == 1) ? 1 : 2 * threads + 1; // enough for every worker to hold a batch while others wait to be written
+    queue.batches = (Batch *) calloc((size_t) queue.slots, sizeof(Batch));
+    bool ready = (queue.batches != NULL);
+    if (!ready) {
+        perror("Unable to allocate memory for batches.");
+    }
+    for (int i = 0; ready && i < queue.slots; i++) {
+        ready = (initOutputBuffer(&(queue.batches[i].output), NULL, 64 * BATCH_LINES) == EXIT_SUCCESS
+                 && initOutputBuffer(&(queue.batches[i].messages), NULL, 256) == EXIT_SUCCESS);
+        if (ready) {
+            setOutputSpillLimit(queue.batches[i].output, BATCH_SPILL_BYTES); // a huge expansion doesn't have to fit in memory
+        }
+        queue.batches[i].state = BATCH_FREE;
+    }
+
+    queue.total = 0;
+    queue.nextToProcess = 0;
+    queue.finished = false;
+    queue.failed = !ready;
+    queue.mode = mode;
+    queue.errors = errors;
+    queue.unbalanced = 0;
+    queue.failures = 0;
+    queue.index = index;
+    queue.fout = fout;
+    queue.collect = (stats != NULL);
+    memset(&queue.stats, 0, sizeof(FormulaStats));
+
+    if (ready && threads == 1) {
+        runInline(&queue, fin);
+    } else if (ready) {
+        runThreads(&queue, fin, threads);
+    }
+
+    if (queue.batches != NULL) {
+        freeBatches(queue.batches, queue.slots);
+    }
+    if (stats != NULL) {
+        addFormulaStats(stats, &queue.stats);
+    }
+    closeInputReader(fin);
+
+    // Keep or discard the staged output
+    bool complete = !queue.failed && queue.unbalanced == 0 && queue.failures == 0;
+    if (staged && complete && copyStagedOutput(fout, outputFile) != EXIT_SUCCESS) {
+        queue.failed = true;
+    }
+    if (fclose(fout) != 0 && !staged) {
+        perror("Unable to write output.");
+        queue.failed = true;
+    }
+
+    int status = queue.failed ? EXIT_FAILURE : EXIT_SUCCESS;
+    if (status == EXIT_SUCCESS && errors == ALL_OR_NOTHING && queue.unbalanced > 0) {
+        status = BATCH_UNBALANCED;
+    } else if (status == EXIT_SUCCESS && errors == ALL_OR_NOTHING && queue.failures > 0) {
+        status = BATCH_FAILED;
+    }
+
+    return status;
+}
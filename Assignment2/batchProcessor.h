@@ -0,0 +1,90 @@
+/**
+ * @file batchProcessor.h
+ * @brief Header file for processing the formulas of a file on several threads.
+ *
+ * Every line of a formula file is independent, so the lines are split in batches that
+ * are processed by a pool of worker threads. A reader thread fills batches from the
+ * input file, the workers expand the formulas or count their protons, and a writer
+ * thread writes the finished batches in input order, so the output file is identical
+ * to the one produced by `formulaProcessor` and `countProtons`.
+ *
+ * The balance of the parentheses is checked while each line is processed, so the input
+ * file is read only once. By default the output is written to a temporary staging file
+ * that is copied to the output file only if every formula is balanced; alternatively each
+ * unbalanced formula is reported in its own line of the output.
+ *
+ * Every thread keeps a FormulaCache of the output lines of the formulas it processed, so
+ * a formula that occurs again is written without processing it again.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs.
+ */
+
+#ifndef BATCHPROCESSOR_H
+#define BATCHPROCESSOR_H
+#include "periodicTable.h"
+#include "formulaCache.h"
+#include "formulaStats.h"
+
+#define BATCH_LINES 4096 /**< Number of formulas in a batch */
+#define BATCH_SPILL_BYTES (1 << 24) /**< Output bytes a batch keeps in memory before the rest goes to a temporary file (16 MB) */
+#define MAX_THREADS 256 /**< Maximum number of worker threads */
+#define BATCH_UNBALANCED 2 /**< Return value of processBatches when the output was discarded */
+#define BATCH_FAILED 3 /**< Return value of processBatches when the output was discarded because a formula couldn't be processed */
+#define UNBALANCED_MARKER "Parentheses NOT balanced" /**< Output line of an unbalanced formula */
+#define FAILED_MARKER "Formula NOT processed" /**< Output line of a formula that couldn't be processed, like one with an unknown symbol in -hist */
+
+
+/**
+ * @enum ProcessMode
+ * @brief Enum to specify what is computed for each formula.
+ */
+typedef enum {
+    EXPAND_MODE, /**< Write the expanded formula (-ext) */
+    GROUPED_MODE, /**< Write the grouped form of the formula, which expands to the same line (-ext --grouped) */
+    PROTONS_MODE, /**< Write the total protons of the formula (-pn) */
+    HIST_MODE /**< Write the number of atoms of each element of the formula (-hist) */
+} ProcessMode;
+
+
+/**
+ * @enum ErrorMode
+ * @brief Enum to specify what happens to the output when a formula is not balanced or can't be processed.
+ */
+typedef enum {
+    ALL_OR_NOTHING, /**< Discard the whole output if any formula is not balanced or can't be processed */
+    PER_LINE_ERRORS /**< Write UNBALANCED_MARKER or FAILED_MARKER in place of each such formula */
+} ErrorMode;
+
+
+/**
+ * @brief Validates and processes the formulas of a file in a single pass.
+ *
+ * Each line is checked for balanced parentheses and then expanded or counted. The
+ * output of each batch is kept in memory until it is written, up to BATCH_SPILL_BYTES:
+ * a batch with a larger output, like the expansion of a single huge formula, continues
+ * in a temporary file, which is copied to the output when the batch is written. The
+ * messages of unbalanced or failed formulas are printed in input order together with
+ * their batch. With a single thread the batches are processed by the calling thread.
+ *
+ * In ALL_OR_NOTHING mode the output of a regular (or new) output file goes to a temporary
+ * file, which is copied into `outputFile` at the end or dropped if a formula was not
+ * balanced, so the output file is never left with partial results and keeps its inode and
+ * permissions. Any other output, like /dev/null, a terminal or a FIFO, is written directly.
+ *
+ * @param inputFile The name of the input file containing the compact formulas.
+ * @param outputFile The name of the output file where the results will be written.
+ * @param mode Whether the formulas are expanded or their protons are counted.
+ * @param index The symbol index of the periodic table (used in PROTONS_MODE and HIST_MODE).
+ * @param threads The number of worker threads (1 to MAX_THREADS).
+ * @param errors What happens to the output when a formula is not balanced or can't be processed.
+ * @param[out] stats A pointer to store the statistics of all threads, with the counters of their
+ *                   caches, or NULL to not collect statistics.
+ * @return int Returns 0 on success, BATCH_UNBALANCED if the output was discarded because of an
+ *             unbalanced formula, BATCH_FAILED if it was discarded because of a formula that
+ *             couldn't be processed, or 1 if a file can't be opened or memory runs out.
+ */
+int processBatches(const char *inputFile, const char *outputFile, ProcessMode mode, const SymbolIndex *index,
+                   int threads, ErrorMode errors, FormulaStats *stats);
+
+#endif // BATCHPROCESSOR_H
@@ -0,0 +1,316 @@
+/**
+ * @file benchFormula.c
+ * @brief Benchmark of the -ext, -ext --grouped, -pn and -hist modes of parseFormula.
+ * @author Panagiotis Tsembekis
+ *
+ * This program generates a corpus of random compact formulas and measures the time taken by
+ * `processBatches` on it in each mode, exactly as `parseFormula` runs it, first with `-j 1`
+ * and then with `-j N`. For each run it reports the lines, atoms (of the expanded formulas)
+ * and input bytes processed per second, together with the peak resident memory of the
+ * process so far.
+ *
+ * Usage:
+ * - ./benchFormula [-n lines] [-d depth] [-m multiplier] [-s w1,w2,w3] [-r repeats]
+ *                  [-j threads] [-seed S] [-t periodicTable.txt] [-o output] [-k]
+ *   `-d` is the nesting depth reached by every formula, `-m` the largest multiplier and `-s`
+ *   the weights of one, two and three letter symbols. `-j` is the number of threads of the
+ *   parallel runs (default the number of online processors). Every measurement is repeated
+ *   `-r` times and the fastest run is reported. Results are written to `-o` (default
+ *   /dev/null) and the corpus is kept in `benchCorpus.txt` with `-k`.
+ *
+ * Built and run by `make bench`.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "batchProcessor.h"
+#include "periodicTable.h"
+
+#define CORPUS_FILE "benchCorpus.txt" /**< Name of the generated corpus */
+#define MAX_GROUP_ITEMS 4 /**< Maximum number of elements and groups in a group */
+
+
+/**
+ * @struct BenchConfig
+ * @brief A structure holding the parameters of the generated corpus.
+ */
+typedef struct {
+    long lines; // number of formulas
+    int depth; // nesting depth of every formula
+    long multiplier; // largest multiplier
+    int weights[3]; // weights of 1, 2 and 3 letter symbols
+    const Element *symbols[3][MAX_ELEMENTS]; // elements of the table by symbol length
+    int counts[3]; // number of elements of each symbol length
+} BenchConfig;
+
+
+/**
+ * @brief Picks a random multiplier between 1 and the configured maximum.
+ *
+ * @param config The corpus parameters.
+ * @return long long The multiplier.
+ */
+static long long randomMultiplier(const BenchConfig *config) {
+    return 1 + (long long) (rand() % config->multiplier);
+}
+
+
+/**
+ * @brief Picks a random symbol, choosing its length by the configured weights.
+ *
+ * @param config The corpus parameters.
+ * @return const char* The chemical symbol.
+ */
+static const char *randomSymbol(const BenchConfig *config) {
+    int total = config->weights[0] + config->weights[1] + config->weights[2];
+    int pick = rand() % total;
+    int length = 0;
+    while (pick >= config->weights[length]) {
+        pick -= config->weights[length];
+        length++;
+    }
+    return config->symbols[length][rand() % config->counts[length]]->chemSymbol;
+}
+
+
+/**
+ * @brief Writes a random group body of the given depth.
+ *
+ * The first item of every level is a group, so every formula reaches the requested depth.
+ *
+ * @param fp The corpus file.
+ * @param config The corpus parameters.
+ * @param depth The number of nested groups below this level.
+ * @return long long The number of atoms of the expanded body.
+ */
+static long long writeGroup(FILE *fp, const BenchConfig *config, int depth) {
+    int items = 1 + rand() % MAX_GROUP_ITEMS;
+    long long atoms = 0;
+
+    for (int i = 0; i < items; i++) {
+        long long multiplier = randomMultiplier(config);
+        if (depth > 0 && (i == 0 || rand() % 4 == 0)) { // nested group
+            fputc('(', fp);
+            atoms += writeGroup(fp, config, depth - 1) * multiplier;
+            fputc(')', fp);
+        } else {
+            fputs(randomSymbol(config), fp);
+            atoms += multiplier;
+        }
+        if (multiplier > 1) {
+            fprintf(fp, "%lld", multiplier);
+        }
+    }
+
+    return atoms;
+}
+
+
+/**
+ * @brief Returns the current time of the monotonic clock in seconds.
+ *
+ * @return double The time in seconds.
+ */
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+
+/**
+ * @brief Returns the peak resident memory of the process.
+ *
+ * @return long The peak resident set size in kilobytes.
+ */
+static long peakMemory(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+
+/**
+ * @brief Prints one line of results.
+ *
+ * @param name The name of the measured mode.
+ * @param threads The number of threads of the run.
+ * @param seconds The fastest time of the run.
+ * @param lines The number of formulas of the corpus.
+ * @param atoms The number of atoms of the expanded corpus.
+ * @param bytes The size of the corpus.
+ */
+static void report(const char *name, int threads, double seconds, long lines, long long atoms, long bytes) {
+    if (seconds <= 0) {
+        seconds = 1e-9;
+    }
+    printf("%-14s -j %-3d %10.4f s %14.0f lines/s %16.0f atoms/s %10.2f MB/s %10ld KB\n", name, threads, seconds,
+           (double) lines / seconds, (double) atoms / seconds, (double) bytes / seconds / 1e6, peakMemory());
+}
+
+
+/**
+ * @brief Times processBatches in one mode, keeping the fastest of the repeats.
+ *
+ * @param mode The mode to run.
+ * @param index The symbol index of the periodic table.
+ * @param threads The number of worker threads.
+ * @param repeats The number of runs.
+ * @param outputFile The name of the output file.
+ * @param[out] seconds A pointer to store the fastest time.
+ * @return int Returns 0 on success, or the first non-zero status of processBatches.
+ */
+static int timeMode(ProcessMode mode, const SymbolIndex *index, int threads, int repeats, const char *outputFile,
+                    double *seconds) {
+    for (int r = 0; r < repeats; r++) {
+        double start = now();
+        int status = processBatches(CORPUS_FILE, outputFile, mode, index, threads, ALL_OR_NOTHING, NULL);
+        double elapsed = now() - start;
+        if (status != 0) {
+            return status;
+        }
+        if (r == 0 || elapsed < *seconds) {
+            *seconds = elapsed;
+        }
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Main function which generates the corpus and times each mode on it.
+ *
+ * @param argc The number of command line arguments.
+ * @param argv The array of command line arguments.
+ * @return int Returns 0 on successful execution and 1 on error.
+ */
+int main(int argc, char *argv[]) {
+    BenchConfig config = { 100000, 3, 9, { 20, 70, 10 }, { { NULL } }, { 0, 0, 0 } };
+    const char *tableFile = "periodicTable.txt";
+    const char *outputFile = "/dev/null";
+    unsigned int seed = 1;
+    int repeats = 3;
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = (online < 1) ? 1 : (online > MAX_THREADS) ? MAX_THREADS : (int) online;
+    int keep = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-k") == 0) {
+            keep = 1;
+        } else if (i + 1 >= argc) {
+            printf("Missing value for %s\n", argv[i]);
+            return 1;
+        } else if (strcmp(argv[i], "-n") == 0) {
+            config.lines = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-d") == 0) {
+            config.depth = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-m") == 0) {
+            config.multiplier = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0) {
+            if (sscanf(argv[++i], "%d,%d,%d", &config.weights[0], &config.weights[1], &config.weights[2]) != 3) {
+                printf("Symbol mix must be given as w1,w2,w3\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-r") == 0) {
+            repeats = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-j") == 0) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-seed") == 0) {
+            seed = (unsigned int) strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-t") == 0) {
+            tableFile = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0) {
+            outputFile = argv[++i];
+        } else {
+            printf("Usage: ./benchFormula [-n lines] [-d depth] [-m multiplier] [-s w1,w2,w3] [-r repeats] "
+                   "[-j threads] [-seed S] [-t periodicTable.txt] [-o output] [-k]\n");
+            return 1;
+        }
+    }
+
+    if (config.lines < 1 || config.depth < 0 || config.multiplier < 1 || repeats < 1) {
+        printf("Lines, multiplier and repeats must be positive and depth non-negative.\n");
+        return 1;
+    }
+    if (threads < 1 || threads > MAX_THREADS) {
+        printf("Number of threads must be between 1 and %d.\n", MAX_THREADS);
+        return 1;
+    }
+
+    Element periodicTable[MAX_ELEMENTS];
+    SymbolIndex index;
+    bool indexed;
+    int numElements = loadPeriodicTableIndex(tableFile, periodicTable, &index, &indexed);
+    if (numElements == EXIT_FAILURE || !indexed) {
+        printf("Failed to load periodic table.\n");
+        return 1;
+    }
+
+    // Group the symbols by length, lengths missing from the table get no weight
+    for (int i = 0; i < numElements; i++) {
+        size_t length = strlen(periodicTable[i].chemSymbol);
+        if (length >= 1 && length <= 3) {
+            config.symbols[length - 1][config.counts[length - 1]++] = &periodicTable[i];
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        if (config.counts[i] == 0 || config.weights[i] < 0) {
+            config.weights[i] = 0;
+        }
+    }
+    if (config.weights[0] + config.weights[1] + config.weights[2] == 0) {
+        printf("Symbol mix selects no symbols of the periodic table.\n");
+        return 1;
+    }
+
+    // Generate the corpus
+    FILE *fp = fopen(CORPUS_FILE, "w");
+    if (fp == NULL) {
+        perror("Unable to create corpus file.");
+        return 1;
+    }
+    srand(seed);
+    long long atoms = 0;
+    for (long i = 0; i < config.lines; i++) {
+        atoms += writeGroup(fp, &config, config.depth);
+        fputc('\n', fp);
+    }
+    long bytes = ftell(fp);
+    fclose(fp);
+
+    printf("Corpus: %ld lines, %ld bytes, %lld atoms (depth %d, multipliers up to %ld, symbol mix %d/%d/%d)\n",
+           config.lines, bytes, atoms, config.depth, config.multiplier,
+           config.weights[0], config.weights[1], config.weights[2]);
+
+    // Time each mode as parseFormula runs it, on one thread and then on all of them
+    const char *names[] = { "-ext", "-ext --grouped", "-pn", "-hist" };
+    ProcessMode modes[] = { EXPAND_MODE, GROUPED_MODE, PROTONS_MODE, HIST_MODE };
+    int runs[] = { 1, threads };
+    int status = 0;
+    for (int m = 0; m < 4 && status == 0; m++) {
+        for (int t = 0; t < 2 && status == 0; t++) {
+            if (t == 1 && threads == 1) {
+                break;
+            }
+            double best = 0;
+            status = timeMode(modes[m], &index, runs[t], repeats, outputFile, &best);
+            if (status == 0) {
+                report(names[m], runs[t], best, config.lines, atoms, bytes);
+            } else {
+                printf("%s failed on the corpus.\n", names[m]);
+            }
+        }
+    }
+
+    if (!keep) {
+        remove(CORPUS_FILE);
+    }
+
+    return (status == 0) ? 0 : 1;
+}
@@ -0,0 +1,171 @@
+/**
+ * @file countStack.c
+ * @brief Implementation of the count stack used for multiplier arithmetic.
+ *
+ * This source file provides the implementations of the functions for managing a stack
+ * of group totals. Functions include stack initialization, opening and closing groups,
+ * adding to the innermost group, resetting and freeing the stack.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "countStack.h"
+
+#define INITIAL_COUNT_CAPACITY 16 /**< Initial number of totals that the stack can hold */
+
+
+// Initialize the count stack
+int initCountStack(CountStack **stack) {
+    *stack = (CountStack *) malloc(sizeof(CountStack)); // allocate memory for a count stack
+    if (*stack == NULL) {
+        perror("Unable to allocate memory for count stack initialization.");
+        return EXIT_FAILURE;
+    }
+
+    (*stack)->totals = (long long *) malloc(INITIAL_COUNT_CAPACITY * sizeof(long long));
+    if ((*stack)->totals == NULL) {
+        perror("Unable to allocate memory for count stack totals.");
+        free(*stack);
+        *stack = NULL;
+        return EXIT_FAILURE;
+    }
+
+    // Bottom of the stack holds the total of the whole formula
+    (*stack)->totals[0] = 0;
+    (*stack)->size = 1;
+    (*stack)->capacity = INITIAL_COUNT_CAPACITY;
+    (*stack)->allocations = 1;
+    (*stack)->pushes = 0;
+    (*stack)->pops = 0;
+
+    return EXIT_SUCCESS;
+}
+
+
+// Open a new group with a zero total
+int pushCountGroup(CountStack *stack) {
+    if (stack == NULL) {
+        perror("Count stack is NULL.");
+        return EXIT_FAILURE;
+    }
+
+    if (stack->size == stack->capacity) { // double the array when full
+        long long *newPtr = (long long *) realloc(stack->totals, 2 * stack->capacity * sizeof(long long));
+        if (newPtr == NULL) { // keep the old array so it can still be freed
+            perror("Unable to grow count stack.");
+            return EXIT_FAILURE;
+        }
+        stack->totals = newPtr;
+        stack->capacity *= 2;
+        (stack->allocations)++;
+    }
+
+    stack->totals[(stack->size)++] = 0; // new group starts empty
+    (stack->pushes)++;
+
+    return EXIT_SUCCESS;
+}
+
+
+// Close the innermost group and return its total
+int popCountGroup(CountStack *stack, long long *total) {
+    if (stack == NULL || stack->size <= 1) { // the formula's total is not a group
+        return EXIT_FAILURE;
+    }
+
+    *total = stack->totals[--(stack->size)];
+    (stack->pops)++;
+
+    return EXIT_SUCCESS;
+}
+
+
+// Add to the total of the innermost group
+void addCountTop(CountStack *stack, long long amount) {
+    stack->totals[stack->size - 1] += amount;
+}
+
+
+// Check if there are any open groups
+bool isEmptyCount(CountStack *stack) {
+    return (stack->size <= 1);
+}
+
+
+// Reset the stack to the formula's total only
+void resetCountStack(CountStack *stack) {
+    stack->totals[0] = 0;
+    stack->size = 1;
+}
+
+
+// Free the stack
+void freeCountStack(CountStack *stack) {
+    if (stack == NULL) {
+        return;
+    }
+
+    free(stack->totals);
+    free(stack);
+}
+
+
+#ifdef DEBUG_CSTACK
+
+int main() {
+    CountStack *stack = NULL;
+
+    // Test stack initialization
+    printf("Testing count stack initialization...\n");
+    if (initCountStack(&stack) == EXIT_SUCCESS && isEmptyCount(stack)) {
+        printf("Count stack initialized successfully.\n");
+    } else {
+        printf("Failed to initialize count stack.\n");
+        return EXIT_FAILURE;
+    }
+
+    // The formula's total can't be popped
+    long long total;
+    if (popCountGroup(stack, &total) == EXIT_FAILURE) {
+        printf("Correct behavior: Cannot close a group that was never opened.\n");
+    } else {
+        printf("Error: Popping the formula's total should fail.\n");
+    }
+
+    // Co3(Fe(CN)6)2 -> 27 * 3 + (26 + (6 + 7) * 6) * 2 = 289
+    printf("Testing group arithmetic for Co3(Fe(CN)6)2...\n");
+    addCountTop(stack, 27 * 3);
+    pushCountGroup(stack);
+    addCountTop(stack, 26);
+    pushCountGroup(stack);
+    addCountTop(stack, 6);
+    addCountTop(stack, 7);
+    popCountGroup(stack, &total);
+    addCountTop(stack, total * 6);
+    popCountGroup(stack, &total);
+    addCountTop(stack, total * 2);
+    printf("Total: %lld (expected 289)\n", stack->totals[0]);
+
+    // Test growing past the initial capacity
+    printf("Testing deep nesting...\n");
+    resetCountStack(stack);
+    for (int i = 0; i < 40; i++) {
+        pushCountGroup(stack);
+    }
+    addCountTop(stack, 1);
+    for (int i = 0; i < 40; i++) {
+        popCountGroup(stack, &total);
+        addCountTop(stack, total * 2);
+    }
+    printf("Total after 40 nested groups of 2: %lld (expected %lld)\n", stack->totals[0], 1LL << 40);
+
+    freeCountStack(stack);
+    printf("Count stack operations test completed.\n");
+
+    return 0;
+}
+#endif // DEBUG_CSTACK
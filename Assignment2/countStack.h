@@ -0,0 +1,125 @@
+/**
+ * @file countStack.h
+ * @brief Header file for a stack of running totals used for multiplier arithmetic.
+ *
+ * This file contains the definitions and function declarations for a growable stack
+ * of counters. Each entry holds the running total of one open parenthesized group
+ * of a formula, while the bottom entry holds the total of the whole formula. Opening
+ * a group pushes a new zero total and closing it pops the total so that it can be
+ * multiplied and added to the enclosing group.
+ *
+ * Unlike the UnionStack, the memory used by this stack grows with the nesting depth
+ * of a formula and not with the length of its expanded form.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs.
+ */
+
+#ifndef COUNTSTACK_H
+#define COUNTSTACK_H
+#include <stdbool.h>
+
+
+/**
+ * @struct CountStack
+ * @brief A structure representing a stack of group totals.
+ *
+ * The totals are kept in a contiguous array which is doubled when it runs out of space.
+ *
+ * @var CountStack::totals
+ * Array holding the running total of each open group (index 0 is the whole formula).
+ *
+ * @var CountStack::size
+ * The current number of totals in the stack.
+ *
+ * @var CountStack::capacity
+ * The number of totals the array can currently hold.
+ *
+ * @var CountStack::allocations
+ * The number of allocations of the array, growths included.
+ *
+ * @var CountStack::pushes
+ * The number of groups opened since the stack was initialized.
+ *
+ * @var CountStack::pops
+ * The number of groups closed since the stack was initialized.
+ */
+typedef struct {
+    long long *totals; // running totals, one per open group
+    int size; // current size of the stack
+    int capacity; // allocated slots in totals
+    long allocations; // allocations of totals
+    long long pushes; // groups opened
+    long long pops; // groups closed
+} CountStack;
+
+
+/**
+ * @brief Initializes the count stack.
+ *
+ * This function allocates memory for a new count stack that holds a single zero
+ * total, the total of the whole formula.
+ *
+ * @param[in,out] stack A pointer to the pointer of the stack to be initialized.
+ * @return int Returns 0 if initialization is successful, or 1 if memory allocation fails.
+ */
+int initCountStack(CountStack **stack);
+
+
+/**
+ * @brief Opens a new group by pushing a zero total onto the count stack.
+ *
+ * @param[in,out] stack The stack to push the new group to.
+ * @return int Returns 0 on success, or 1 if memory allocation fails.
+ */
+int pushCountGroup(CountStack *stack);
+
+
+/**
+ * @brief Closes the innermost group by popping its total from the count stack.
+ *
+ * The total of the whole formula (bottom of the stack) can't be popped, since it
+ * doesn't belong to a group. Attempting to do so means that there are more closing
+ * parentheses than opening ones.
+ *
+ * @param[in,out] stack The stack from which to pop the group total.
+ * @param[out] total A pointer to store the popped group total.
+ * @return int Returns 0 on success, or 1 if there is no open group.
+ */
+int popCountGroup(CountStack *stack, long long *total);
+
+
+/**
+ * @brief Adds an amount to the total of the innermost open group.
+ *
+ * @param[in,out] stack The stack whose top total will be increased.
+ * @param[in] amount The amount to add.
+ */
+void addCountTop(CountStack *stack, long long amount);
+
+
+/**
+ * @brief Checks if the count stack has any open groups.
+ *
+ * @param[in] stack The stack to check.
+ * @return bool Returns true if only the total of the whole formula is in the stack.
+ */
+bool isEmptyCount(CountStack *stack);
+
+
+/**
+ * @brief Resets the count stack to a single zero total, keeping its allocated memory.
+ *
+ * @param[in,out] stack The stack to reset.
+ */
+void resetCountStack(CountStack *stack);
+
+
+/**
+ * @brief Frees the count stack and its totals array.
+ *
+ * @param[in] stack The stack to free.
+ */
+void freeCountStack(CountStack *stack);
+
+#endif // COUNTSTACK_H
@@ -0,0 +1,188 @@
+/**
+ * @file formulaCache.c
+ * @brief Implementation of the bounded cache of formula results.
+ *
+ * This source file provides the hashing of formulas and the lookup, storage and
+ * replacement of the entries of a direct-mapped cache.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "formulaCache.h"
+
+
+/**
+ * @brief Hashes the characters of a formula, eight at a time.
+ *
+ * @param formula The formula.
+ * @param length The number of characters of the formula.
+ * @return uint64_t The hash.
+ */
+static uint64_t hashFormula(const char *formula, size_t length) {
+    uint64_t hash = UINT64_C(0x9E3779B97F4A7C15) ^ length;
+    uint64_t word;
+    size_t i = 0;
+
+    for (; i + 8 <= length; i += 8) {
+        memcpy(&word, formula + i, 8);
+        hash = (hash ^ word) * UINT64_C(0xFF51AFD7ED558CCD);
+        hash ^= hash >> 32;
+    }
+    word = 0;
+    memcpy(&word, formula + i, length - i); // last 0 to 7 characters
+    hash = (hash ^ word) * UINT64_C(0xC4CEB9FE1A85EC53);
+    return hash ^ (hash >> 29);
+}
+
+
+// Initialize an empty cache with a power of two slots
+int initFormulaCache(FormulaCache **cache, size_t slots, size_t byteLimit) {
+    size_t count = 1;
+    while (count < slots) {
+        count *= 2;
+    }
+
+    *cache = (FormulaCache *) malloc(sizeof(FormulaCache));
+    if (*cache == NULL) {
+        perror("Unable to allocate memory for formula cache.");
+        return EXIT_FAILURE;
+    }
+
+    (*cache)->entries = (CacheEntry *) calloc(count, sizeof(CacheEntry));
+    if ((*cache)->entries == NULL) {
+        perror("Unable to allocate memory for formula cache entries.");
+        free(*cache);
+        *cache = NULL;
+        return EXIT_FAILURE;
+    }
+
+    (*cache)->mask = count - 1;
+    (*cache)->bytes = 0;
+    (*cache)->byteLimit = byteLimit;
+    memset(&((*cache)->stats), 0, sizeof(CacheStats));
+
+    return EXIT_SUCCESS;
+}
+
+
+// Free the cache and every entry
+void freeFormulaCache(FormulaCache *cache) {
+    if (cache == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i <= cache->mask; i++) {
+        free(cache->entries[i].data);
+    }
+    free(cache->entries);
+    free(cache);
+}
+
+
+// Find the cached result of a formula in its slot
+bool lookupFormula(FormulaCache *cache, const char *formula, size_t length, const char **value, size_t *valueLength) {
+    if (length > CACHE_KEY_LIMIT) {
+        return false; // never cached, not worth hashing
+    }
+
+    uint64_t hash = hashFormula(formula, length);
+    const CacheEntry *entry = &(cache->entries[hash & cache->mask]);
+
+    if (entry->data != NULL && entry->hash == hash && entry->keyLength == length
+        && memcmp(entry->data, formula, length) == 0) {
+        *value = entry->data + length;
+        *valueLength = entry->valueLength;
+        (cache->stats.hits)++;
+        return true;
+    }
+
+    (cache->stats.misses)++;
+    return false;
+}
+
+
+// Store the result of a formula in its slot, replacing what was there
+void storeFormula(FormulaCache *cache, const char *formula, size_t length, const char *value, size_t valueLength) {
+    if (length > CACHE_KEY_LIMIT || valueLength > CACHE_VALUE_LIMIT) {
+        return; // too long to be worth keeping
+    }
+
+    uint64_t hash = hashFormula(formula, length);
+    CacheEntry *entry = &(cache->entries[hash & cache->mask]);
+    size_t oldBytes = (entry->data != NULL) ? entry->keyLength + entry->valueLength : 0;
+    if (cache->bytes - oldBytes + length + valueLength > cache->byteLimit) {
+        return; // cache is full
+    }
+
+    char *data = (char *) malloc(length + valueLength);
+    if (data == NULL) {
+        return; // caching is optional, the result is still written
+    }
+    memcpy(data, formula, length);
+    memcpy(data + length, value, valueLength);
+
+    if (entry->data != NULL) {
+        (cache->stats.evictions)++;
+        free(entry->data);
+    }
+    entry->hash = hash;
+    entry->keyLength = (uint32_t) length;
+    entry->valueLength = (uint32_t) valueLength;
+    entry->data = data;
+    cache->bytes += length + valueLength - oldBytes;
+}
+
+
+// Add the counters of a cache to a total
+void addCacheStats(CacheStats *total, const CacheStats *stats) {
+    total->hits += stats->hits;
+    total->misses += stats->misses;
+    total->evictions += stats->evictions;
+}
+
+
+#ifdef DEBUG_FCACHE
+
+int main() {
+    FormulaCache *cache = NULL;
+    const char *value;
+    size_t valueLength;
+
+    if (initFormulaCache(&cache, 3, 64) != EXIT_SUCCESS) { // rounded up to 4 slots
+        return EXIT_FAILURE;
+    }
+    printf("Slots: %zu (expected 4)\n", cache->mask + 1);
+
+    // Miss, store, then hit
+    printf("Lookup H2O before storing: %d (expected 0)\n", lookupFormula(cache, "H2O", 3, &value, &valueLength));
+    storeFormula(cache, "H2O", 3, "10\n", 3);
+    if (lookupFormula(cache, "H2O", 3, &value, &valueLength)) {
+        printf("Lookup H2O after storing: %.*s", (int) valueLength, value);
+    }
+    printf("Lookup H2 (prefix of a cached formula): %d (expected 0)\n", lookupFormula(cache, "H2", 2, &value, &valueLength));
+
+    // Results over the limit and the byte limit of the cache are not stored
+    char large[CACHE_VALUE_LIMIT + 1];
+    memset(large, 'H', sizeof(large));
+    storeFormula(cache, "H4097", 5, large, sizeof(large));
+    storeFormula(cache, "NaCl", 4, large, 61);
+    printf("Lookups of uncached results: %d %d (expected 0 0)\n", lookupFormula(cache, "H4097", 5, &value, &valueLength),
+           lookupFormula(cache, "NaCl", 4, &value, &valueLength));
+
+    // Many formulas in few slots replace each other
+    char formula[16];
+    for (int i = 0; i < 100; i++) {
+        int n = snprintf(formula, sizeof(formula), "C%dH%d", i, 2 * i + 2);
+        storeFormula(cache, formula, (size_t) n, "x\n", 2);
+    }
+    printf("Bytes held: %zu (at most 64), evictions: %lld (at least 96)\n", cache->bytes, cache->stats.evictions);
+    printf("Hits: %lld, misses: %lld (expected 1, 4)\n", cache->stats.hits, cache->stats.misses);
+
+    freeFormulaCache(cache);
+    return 0;
+}
+#endif // DEBUG_FCACHE
@@ -0,0 +1,163 @@
+/**
+ * @file formulaCache.h
+ * @brief Header file for a bounded cache of the results of repeated formulas.
+ *
+ * This file contains the definitions and function declarations for a hash cache that
+ * maps the text of a formula to the output line it produced: its expansion, its total
+ * protons or its element counts. Formula files tend to repeat the same formulas many
+ * times, and a repeated formula is then written by copying its cached line instead of
+ * being parsed and processed again.
+ *
+ * The cache is direct-mapped: every formula has a single slot chosen by its hash, and a
+ * new formula replaces the one in its slot. Formulas or results longer than the limits
+ * below are never cached, and no entry is added once the cache holds its byte limit, so
+ * both the number of entries and their memory are bounded. A cache is not thread-safe;
+ * each thread uses its own.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs.
+ */
+
+#ifndef FORMULACACHE_H
+#define FORMULACACHE_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CACHE_SLOTS 4096 /**< Default number of slots of a cache (a power of two) */
+#define CACHE_BYTES (8 << 20) /**< Default limit of the bytes held by a cache (8 MB) */
+#define CACHE_KEY_LIMIT 256 /**< Longest formula that is cached */
+#define CACHE_VALUE_LIMIT 4096 /**< Longest result that is cached */
+
+
+/**
+ * @struct CacheStats
+ * @brief Counters of the use of a cache.
+ *
+ * @var CacheStats::hits
+ * Lookups that found their formula.
+ *
+ * @var CacheStats::misses
+ * Lookups that didn't find their formula.
+ *
+ * @var CacheStats::evictions
+ * Entries replaced by a formula with the same slot.
+ */
+typedef struct {
+    long long hits; // lookups that found their formula
+    long long misses; // lookups that didn't find their formula
+    long long evictions; // entries replaced by another formula
+} CacheStats;
+
+
+/**
+ * @struct CacheEntry
+ * @brief A formula and its result, stored back to back in one allocation.
+ *
+ * @var CacheEntry::hash
+ * The hash of the formula.
+ *
+ * @var CacheEntry::keyLength
+ * The number of characters of the formula.
+ *
+ * @var CacheEntry::valueLength
+ * The number of bytes of the result.
+ *
+ * @var CacheEntry::data
+ * The formula followed by its result, or NULL if the slot is empty.
+ */
+typedef struct {
+    uint64_t hash; // hash of the formula
+    uint32_t keyLength; // characters of the formula
+    uint32_t valueLength; // bytes of the result
+    char *data; // formula followed by the result (NULL = empty slot)
+} CacheEntry;
+
+
+/**
+ * @struct FormulaCache
+ * @brief A direct-mapped cache of formula results.
+ *
+ * @var FormulaCache::entries
+ * The slots of the cache.
+ *
+ * @var FormulaCache::mask
+ * The number of slots minus one.
+ *
+ * @var FormulaCache::bytes
+ * The bytes held by the entries.
+ *
+ * @var FormulaCache::byteLimit
+ * The largest number of bytes the entries may hold.
+ *
+ * @var FormulaCache::stats
+ * The counters of the cache.
+ */
+typedef struct {
+    CacheEntry *entries; // slots of the cache
+    size_t mask; // slots - 1
+    size_t bytes; // bytes held by the entries
+    size_t byteLimit; // most bytes the entries may hold
+    CacheStats stats; // hit and miss counters
+} FormulaCache;
+
+
+/**
+ * @brief Initializes an empty cache.
+ *
+ * @param[in,out] cache A pointer to the pointer of the cache to be initialized.
+ * @param[in] slots The number of slots (rounded up to a power of two).
+ * @param[in] byteLimit The largest number of bytes the entries may hold.
+ * @return int Returns 0 if initialization is successful, or 1 if memory allocation fails.
+ */
+int initFormulaCache(FormulaCache **cache, size_t slots, size_t byteLimit);
+
+
+/**
+ * @brief Frees a cache and all of its entries.
+ *
+ * @param[in] cache The cache to free (may be NULL).
+ */
+void freeFormulaCache(FormulaCache *cache);
+
+
+/**
+ * @brief Looks up the result of a formula.
+ *
+ * Every lookup of a formula of up to CACHE_KEY_LIMIT characters counts as a hit or a miss;
+ * longer formulas are never cached and are not looked up.
+ *
+ * @param[in,out] cache The cache.
+ * @param[in] formula The formula (doesn't need to be null-terminated).
+ * @param[in] length The number of characters of the formula.
+ * @param[out] value A pointer to store the cached result, valid until the next store.
+ * @param[out] valueLength A pointer to store the number of bytes of the result.
+ * @return bool Returns true if the formula was found.
+ */
+bool lookupFormula(FormulaCache *cache, const char *formula, size_t length, const char **value, size_t *valueLength);
+
+
+/**
+ * @brief Stores the result of a formula, replacing the entry of its slot.
+ *
+ * Formulas or results over the limits, and entries that would exceed the byte limit of
+ * the cache, are silently not stored.
+ *
+ * @param[in,out] cache The cache.
+ * @param[in] formula The formula (doesn't need to be null-terminated).
+ * @param[in] length The number of characters of the formula.
+ * @param[in] value The result of the formula.
+ * @param[in] valueLength The number of bytes of the result.
+ */
+void storeFormula(FormulaCache *cache, const char *formula, size_t length, const char *value, size_t valueLength);
+
+
+/**
+ * @brief Adds the counters of one cache to a total.
+ *
+ * @param[in,out] total The counters to add to.
+ * @param[in] stats The counters to add.
+ */
+void addCacheStats(CacheStats *total, const CacheStats *stats);
+
+#endif // FORMULACACHE_H
@@ -14,33 +14,29 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
 #include <math.h>
 #include "formulaExpander.h"
+#include "inputReader.h"
+#include "formulaTokenizer.h"
 
-#define MAX_FORMULA_LENGTH 1024 /**< Buffer size for reading formulas */
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
 
-/**
- * @brief Processes a chemical formula and returns its expanded form.
- *
- * This function takes a chemical formula in the form of a string, parses it,
- * and produces an expanded formula where elements are repeated based on
- * multipliers specified in the formula. It supports nested parentheses and
- * handles single, double, and triple-letter chemical symbols.
- *
- * @param formula A string representing the chemical formula to be processed.
- * @return A dynamically allocated string containing the expanded formula,
- *         or NULL if there is an error in allocation or processing.
- */
-static char *processFormula(const char *formula) {
+// Expand a single formula into a newly allocated string using union stacks
+char *processFormula(const char *formula, StackPool *pool) {
     UnionStack *stack = NULL;   
     if (initUnionStack(&stack) != EXIT_SUCCESS) { // initialize stack and handle error
         perror("Error initializing stack.");
         return NULL;
     }
+    attachStackPool(stack, pool);
 
-    const char *p = formula;
+    Tokenizer tokens;
+    Token token;
     StackData poppedData;
     StackDataType poppedType;
 
@@ -54,84 +50,71 @@ static char *processFormula(const char *formula) {
         return NULL;
     }
 
-    while (*p != '\0') {
-        if (isalpha(*p)) {
+    // Elements of the group being closed, grown as needed and reused by every group
+    Element *group = NULL;
+    size_t groupCapacity = 0;
+
+    initTokenizer(&tokens, formula, strlen(formula));
+    while (nextToken(&tokens, &token)) {
+        if (token.type == TOKEN_SYMBOL) {
             Element element;
             element.atomicNumber = 1;
-
-            if (isupper(*p) && islower(*(p + 1)) && islower(*(p + 2))) { // 3-letter elements
-                element.chemSymbol[0] = *p;
-                element.chemSymbol[1] = *(p + 1);
-                element.chemSymbol[2] = *(p + 2);
-                element.chemSymbol[3] = '\0'; // ensure termination character
-                p += 2; // skip next two letters since we handled them above
-            } else if (isupper(*p) && islower(*(p + 1))) { // 2-letter elements
-                element.chemSymbol[0] = *p;
-                element.chemSymbol[1] = *(p + 1);
-                element.chemSymbol[2] = '\0'; // ensure termination character
-                p++; // skip next letter, we handled it above
-            } else { // single letter element
-                element.chemSymbol[0] = *p;
-                element.chemSymbol[1] = '\0';
-            }
+            memcpy(element.chemSymbol, formula + token.offset, token.length); // symbol of 1, 2 or 3 letters
+            element.chemSymbol[token.length] = '\0'; // ensure termination character
 
             pushElementUnion(stack, element);
-        } else if (isdigit(*p)) {
-            int multiplier = 0;
-
-            // Calculate multiplier (handles multi-digit multipliers too)
-            while (isdigit(*p)) {
-                multiplier = (multiplier * 10) + (*p - '0');
-                p++;
-            }
-
+        } else if (token.type == TOKEN_NUMBER) {
             // Pop the last element and add it multiplier-times
             if (popUnion(stack, &poppedData, &poppedType) == EXIT_SUCCESS && poppedType == ELEMENT_TYPE) {
-                for (int i = 0; i < multiplier; i++) {
+                for (long long i = 0; i < token.value; i++) {
                     pushElementUnion(stack, poppedData.elementData); // push multiplier-times
                 }
             }
-
-            continue;
-        } else if (*p == '(') { // begining of group
+        } else if (token.type == TOKEN_OPEN) { // begining of group
             Element dummy = { "(", 0 }; // push dummy element to mark begining of group
             pushElementUnion(stack, dummy);
-        } else if (*p == ')') { // end of group
-            Element tempArray[MAX_FORMULA_LENGTH];
-            int tempIndex = 0;
+        } else { // end of group
+            size_t groupLength = 0;
 
             // Pop until we find the start of group ( '(' )
             while (popUnion(stack, &poppedData, &poppedType) == EXIT_SUCCESS && poppedType == ELEMENT_TYPE && strcmp(poppedData.elementData.chemSymbol, "(") != 0) {
-                tempArray[tempIndex++] = poppedData.elementData;
+                if (groupLength == groupCapacity) { // group doesn't fit, double the array
+                    size_t newCapacity = (groupCapacity == 0) ? 64 : 2 * groupCapacity;
+                    Element *newGroup = (Element *) realloc(group, newCapacity * sizeof(Element));
+                    if (!newGroup) {
+                        perror("Failed to realloc memory for formula group");
+                        free(group);
+                        free(expandedFormula);
+                        free(stack);
+                        return NULL;
+                    }
+                    group = newGroup;
+                    groupCapacity = newCapacity;
+                }
+                group[groupLength++] = poppedData.elementData;
             }
 
             // Look for multipliers after the end of group
-            p++;
-            int groupMultiplier = 1;
-            if (isdigit(*p)) {
-                groupMultiplier = 0;
-                while (isdigit(*p)) {
-                    groupMultiplier = (groupMultiplier * 10) + (*p - '0');
-                    p++;
-                }
-            }
+            long long groupMultiplier = nextMultiplier(&tokens);
 
             // Push elements of the group back with applied multiplier
-            for (int i = 0; i < groupMultiplier; i++) {
-                for (int j = tempIndex - 1; j >= 0; j--) {
-                    pushElementUnion(stack, tempArray[j]);
+            for (long long i = 0; i < groupMultiplier; i++) {
+                for (size_t j = groupLength; j > 0; j--) {
+                    pushElementUnion(stack, group[j - 1]);
                 }
             }
-    
-            continue; // continue parsing after handling group
         }
-
-        p++; // move to next character of formula
     }
+    free(group);
 
     // Use a temporary stack to inverse the elements inside the main stack
     UnionStack *tempStack = NULL;
-    initUnionStack(&tempStack);
+    if (initUnionStack(&tempStack) != EXIT_SUCCESS) {
+        free(expandedFormula);
+        free(stack);
+        return NULL;
+    }
+    attachStackPool(tempStack, pool); // nodes popped from main stack are reused by temp stack
 
     while (!isEmptyUnion(stack)) { // pop from main and push to temp until main is empty
         if (popUnion(stack, &poppedData, &poppedType) == EXIT_SUCCESS && poppedType == ELEMENT_TYPE) {
@@ -173,10 +156,282 @@ static char *processFormula(const char *formula) {
 }
 
 
-// Reads formulas from specified file and with the helper method calculates the expanded version
+// Initialize the reusable memory of the formula engine
+int initFormulaWorkspace(FormulaWorkspace *workspace) {
+    ExpansionState *state = &(workspace->expansion);
+    state->depth = 0;
+    state->capacity = 16;
+    state->closingCapacity = 256;
+    state->allocations = 2;
+    state->pushes = 0;
+    state->pops = 0;
+    state->frames = (GroupFrame *) malloc(state->capacity * sizeof(GroupFrame));
+    state->closing = (size_t *) malloc(state->closingCapacity * sizeof(size_t));
+    if (state->frames == NULL || state->closing == NULL) {
+        perror("Unable to allocate memory for formula expansion.");
+        free(state->frames);
+        free(state->closing);
+        return EXIT_FAILURE;
+    }
+
+    if (initCountStack(&(workspace->counts)) != EXIT_SUCCESS) {
+        free(state->frames);
+        free(state->closing);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+
+// Free the reusable memory of the formula engine
+void freeFormulaWorkspace(FormulaWorkspace *workspace) {
+    free(workspace->expansion.frames);
+    free(workspace->expansion.closing);
+    freeCountStack(workspace->counts);
+}
+
+
+/**
+ * @brief Finds the matching closing parenthesis of every opening parenthesis of a formula.
+ *
+ * The open parentheses are kept as a linked stack inside the `closing` array itself:
+ * the entry of an open '(' holds the index of the previous open '(' until it is matched.
+ *
+ * @param formula The formula to match.
+ * @param length The number of characters of the formula.
+ * @param state The state whose `closing` array is filled.
+ * @return int Returns 0 on success, or 1 if the parentheses are not balanced or memory runs out.
+ */
+static int matchParentheses(const char *formula, size_t length, ExpansionState *state) {
+    if (length > state->closingCapacity) {
+        size_t *newPtr = (size_t *) realloc(state->closing, length * sizeof(size_t));
+        if (newPtr == NULL) {
+            perror("Unable to allocate memory for formula expansion.");
+            return EXIT_FAILURE;
+        }
+        state->closing = newPtr;
+        state->closingCapacity = length;
+        (state->allocations)++;
+    }
+
+    size_t none = length; // marks the bottom of the stack
+    size_t top = none;
+    for (size_t i = 0; i < length; i++) {
+        if (formula[i] == '(') {
+            state->closing[i] = top;
+            top = i;
+        } else if (formula[i] == ')') {
+            if (top == none) {
+                return EXIT_FAILURE; // extra closing parenthesis
+            }
+            size_t previous = state->closing[top];
+            state->closing[top] = i;
+            top = previous;
+        }
+    }
+
+    return (top == none) ? EXIT_SUCCESS : EXIT_FAILURE; // no parenthesis left open
+}
+
+
+/**
+ * @brief Writes a symbol to the output, separated with a space from the previous one.
+ *
+ * @param out The output to write to.
+ * @param lineStart Whether the symbol is the first of its line (updated).
+ * @param symbol The symbol to write.
+ * @param symbolLen The number of letters of the symbol.
+ * @return int Returns 0 on success, or 1 if writing fails.
+ */
+static int emitSymbol(OutputBuffer *out, bool *lineStart, const char *symbol, size_t symbolLen) {
+    if (!*lineStart && appendOutputChar(out, ' ') != EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+    *lineStart = false;
+    return appendOutput(out, symbol, symbolLen);
+}
+
+
+// Stream the expansion of a single formula into an output buffer
+int expandFormula(const char *formula, size_t length, OutputBuffer *out, FormulaWorkspace *workspace) {
+    ExpansionState *state = &(workspace->expansion);
+    if (matchParentheses(formula, length, state) != EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+    Tokenizer tokens;
+    Token token;
+    bool lineStart = true;
+    long long multiplier;
+    state->depth = 0;
+
+    initTokenizer(&tokens, formula, length);
+    while (nextToken(&tokens, &token)) {
+        if (token.type == TOKEN_SYMBOL) {
+            const char *symbol = formula + token.offset;
+            size_t symbolLen = token.length;
+            multiplier = nextMultiplier(&tokens);
+
+            if (multiplier > 0) {
+                size_t spanStart = out->length;
+                unsigned long flushes = out->flushes;
+                bool atLineStart = lineStart;
+
+                if (emitSymbol(out, &lineStart, symbol, symbolLen) != EXIT_SUCCESS) {
+                    return EXIT_FAILURE;
+                }
+                if (multiplier > 1 && canRepeatOutput(out, spanStart, flushes, atLineStart ? 1 : 0)) {
+                    if (repeatOutput(out, spanStart, " ", atLineStart ? 1 : 0, multiplier - 1) != EXIT_SUCCESS) {
+                        return EXIT_FAILURE;
+                    }
+                } else {
+                    for (long long i = 1; i < multiplier; i++) {
+                        if (emitSymbol(out, &lineStart, symbol, symbolLen) != EXIT_SUCCESS) {
+                            return EXIT_FAILURE;
+                        }
+                    }
+                }
+            }
+        } else if (token.type == TOKEN_OPEN) { // begining of group
+            size_t bodyEnd = state->closing[token.offset];
+            Tokenizer after = tokens;
+            after.position = bodyEnd + 1;
+            multiplier = nextMultiplier(&after);
+            if (multiplier == 0) { // group appears zero times, skip it
+                tokens.position = after.position;
+                continue;
+            }
+
+            if (state->depth == state->capacity) { // double the frames when full
+                GroupFrame *newPtr = (GroupFrame *) realloc(state->frames, 2 * state->capacity * sizeof(GroupFrame));
+                if (newPtr == NULL) {
+                    perror("Unable to allocate memory for formula expansion.");
+                    return EXIT_FAILURE;
+                }
+                state->frames = newPtr;
+                state->capacity *= 2;
+                (state->allocations)++;
+            }
+
+            GroupFrame *frame = &(state->frames[(state->depth)++]);
+            frame->bodyStart = token.offset + 1;
+            frame->bodyEnd = bodyEnd;
+            frame->resume = after.position;
+            frame->remaining = multiplier;
+            frame->spanStart = out->length;
+            frame->flushes = out->flushes;
+            frame->atLineStart = lineStart;
+            (state->pushes)++;
+        } else if (token.type == TOKEN_CLOSE && state->depth > 0) { // end of an iteration of the innermost group
+            GroupFrame *frame = &(state->frames[state->depth - 1]);
+            (frame->remaining)--;
+
+            if (frame->remaining > 0 && out->length == frame->spanStart && out->flushes == frame->flushes) {
+                frame->remaining = 0; // group is empty, repeating it adds nothing
+            } else if (frame->remaining > 0 && canRepeatOutput(out, frame->spanStart, frame->flushes, frame->atLineStart ? 1 : 0)) {
+                // Copy the already emitted iteration instead of expanding it again
+                if (repeatOutput(out, frame->spanStart, " ", frame->atLineStart ? 1 : 0, frame->remaining) != EXIT_SUCCESS) {
+                    return EXIT_FAILURE;
+                }
+                frame->remaining = 0;
+            } else if (frame->remaining > 0) {
+                // Iteration was flushed while written (too large to copy), expand the group again
+                frame->spanStart = out->length;
+                frame->flushes = out->flushes;
+                frame->atLineStart = lineStart;
+                tokens.position = frame->bodyStart;
+                continue;
+            }
+
+            tokens.position = frame->resume; // continue parsing after the group's multiplier
+            (state->depth)--;
+            (state->pops)++;
+        }
+    }
+
+    return appendOutputChar(out, '\n');
+}
+
+
+
+// Write the shortest formula that expands to the same line as the given one
+int groupFormula(const char *formula, size_t length, OutputBuffer *out, FormulaWorkspace *workspace) {
+    ExpansionState *state = &(workspace->expansion);
+    if (matchParentheses(formula, length, state) != EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+    Tokenizer tokens;
+    Token token;
+    char number[24];
+    int pendingGroups = 0; // innermost open groups whose '(' is not written yet, as they may turn out empty
+    char last = ' '; // last character written
+    long long multiplier;
+
+    initTokenizer(&tokens, formula, length);
+    while (nextToken(&tokens, &token)) {
+        if (token.type == TOKEN_SYMBOL) {
+            multiplier = nextMultiplier(&tokens);
+            if (multiplier <= 0) { // expands to nothing
+                continue;
+            }
+
+            for (; pendingGroups > 0; pendingGroups--) { // the open groups are not empty after all
+                if (appendOutputChar(out, '(') != EXIT_SUCCESS) {
+                    return EXIT_FAILURE;
+                }
+                last = '(';
+            }
+
+            // A symbol that starts with a lowercase letter would join the previous letter without a space
+            if (tokenClass[(unsigned char) formula[token.offset]] == CHAR_LOWER && (tokenClass[(unsigned char) last] & (CHAR_UPPER | CHAR_LOWER))
+                && appendOutputChar(out, ' ') != EXIT_SUCCESS) {
+                return EXIT_FAILURE;
+            }
+            if (appendOutput(out, formula + token.offset, token.length) != EXIT_SUCCESS) {
+                return EXIT_FAILURE;
+            }
+            last = formula[token.offset + token.length - 1];
+        } else if (token.type == TOKEN_OPEN) {
+            Tokenizer after = tokens;
+            after.position = state->closing[token.offset] + 1;
+            if (nextMultiplier(&after) == 0) { // group appears zero times, skip it
+                tokens.position = after.position;
+                continue;
+            }
+            pendingGroups++;
+            continue;
+        } else if (token.type == TOKEN_CLOSE) {
+            multiplier = nextMultiplier(&tokens);
+            if (pendingGroups > 0) { // group is empty, nothing to write
+                pendingGroups--;
+                continue;
+            }
+            if (appendOutputChar(out, ')') != EXIT_SUCCESS) {
+                return EXIT_FAILURE;
+            }
+            last = ')';
+        } else {
+            continue; // numbers that don't follow a symbol or a group are ignored by the expander too
+        }
+
+        if (multiplier > 1) { // a negative group multiplier expands the group once, like no multiplier
+            int n = snprintf(number, sizeof(number), "%lld", multiplier);
+            if (appendOutput(out, number, (size_t) n) != EXIT_SUCCESS) {
+                return EXIT_FAILURE;
+            }
+            last = '0';
+        }
+    }
+
+    return appendOutputChar(out, '\n');
+}
+
+// Reads formulas from specified file and streams their expanded version to the output file
 void formulaProcessor(const char *inputFile, const char *outputFile) {
-    FILE *fin = fopen(inputFile, "r"); // open file for read-only
-    if (fin == NULL) { // ensure proper file opening
+    InputReader *fin = NULL;
+    if (openInputReader(&fin, inputFile) != EXIT_SUCCESS) { // ensure proper file opening
         perror("Unable to open input file for formula expansion.");
         return;
     }
@@ -184,161 +439,345 @@ void formulaProcessor(const char *inputFile, const char *outputFile) {
     FILE *fout = fopen(outputFile, "w"); // open file for write-only
     if (fout == NULL) { // ensure proper file opening
         perror("Unable to open output file for writing.");
-        fclose(fin);
+        closeInputReader(fin);
         return;
     }
 
-    char formula[MAX_FORMULA_LENGTH];
-    while (fgets(formula, sizeof(formula), fin)) {
-        formula[strcspn(formula, "\n")] = '\0'; // replace newline character with terminating character
-        char *expandedFormula = processFormula(formula); // calculate expanded formula
-        if (expandedFormula) { // check wether the formula returned is null (error) or not and print accordingly
-            fprintf(fout, "%s\n", expandedFormula);
-            free(expandedFormula);
-        } else {
-            printf("Error processing formula: %s\n", formula);
+    OutputBuffer *out = NULL;
+    FormulaWorkspace workspace;
+    if (initOutputBuffer(&out, fout, OUTPUT_BUFFER_SIZE) != EXIT_SUCCESS) {
+        closeInputReader(fin);
+        fclose(fout);
+        return;
+    }
+    if (initFormulaWorkspace(&workspace) != EXIT_SUCCESS) {
+        freeOutputBuffer(out);
+        closeInputReader(fin);
+        fclose(fout);
+        return;
+    }
+
+    const char *formula;
+    size_t length;
+    while (nextLine(fin, &formula, &length)) { // formulas are read in place, of any length
+        if (expandFormula(formula, length, out, &workspace) != EXIT_SUCCESS) { // stream expanded formula to output
+            printf("Error processing formula: %.*s\n", (int) length, formula);
         }
     }
 
-    fclose(fin);
+    flushOutputBuffer(out);
+    freeFormulaWorkspace(&workspace);
+    freeOutputBuffer(out);
+    closeInputReader(fin);
     fclose(fout);
 }
 
 
-// Reads and calculates total protons number of each formula in the given input file
-void countProtons(const char *inputFile, const char *outputFile, Element periodicTable[]){
-    char tempFile[] = "expanded.txt"; // file that we will store the expanded formulas
+// Calculate the total protons of a single formula with multiplier arithmetic over its groups
+int formulaProtons(const char *formula, size_t length, const SymbolIndex *index, FormulaWorkspace *workspace, long long *total) {
+    CountStack *counts = workspace->counts;
+    Tokenizer tokens;
+    Token token;
+    long long groupTotal;
+
+    resetCountStack(counts);
+
+    initTokenizer(&tokens, formula, length);
+    while (nextToken(&tokens, &token)) {
+        if (token.type == TOKEN_SYMBOL) {
+            int atomicNumber = lookupAtomicNumber(index, token.key); // look-up without copying the symbol
+
+            // Multiplier of the element (1 if there is none)
+            long long multiplier = nextMultiplier(&tokens);
+
+            addCountTop(counts, multiplier * atomicNumber);
+        } else if (token.type == TOKEN_OPEN) { // begining of group
+            if (pushCountGroup(counts) != EXIT_SUCCESS) {
+                return EXIT_FAILURE;
+            }
+        } else if (token.type == TOKEN_CLOSE) { // end of group
+            if (popCountGroup(counts, &groupTotal) != EXIT_SUCCESS) {
+                return EXIT_FAILURE; // closing parenthesis without an opening one
+            }
 
-    FILE *fp = fopen(tempFile, "w+"); // file for read&write (created if not existant)
-    if(fp == NULL){
-        perror("Unable to create file to store expanded formulas");
-        exit(EXIT_FAILURE);
+            // Look for multipliers after the end of group
+            long long groupMultiplier = nextMultiplier(&tokens);
+
+            addCountTop(counts, groupTotal * groupMultiplier);
+        }
+    }
+
+    if (!isEmptyCount(counts)) { // group left open
+        return EXIT_FAILURE;
     }
 
-    formulaProcessor(inputFile, tempFile); // expand the formulas
+    *total = counts->totals[0];
+    return EXIT_SUCCESS;
+}
+
+
+// Count the atoms of each element of a single formula with the products of the group multipliers
+int formulaHistogram(const char *formula, size_t length, const SymbolIndex *index, FormulaWorkspace *workspace, AtomCounts *atoms) {
+    ExpansionState *state = &(workspace->expansion);
+    if (matchParentheses(formula, length, state) != EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+    CountStack *products = workspace->counts; // product of the multipliers of the open groups
+    Tokenizer tokens;
+    Token token;
+    long long multiplier;
+
+    resetCountStack(products);
+    addCountTop(products, 1); // the formula itself is not repeated
+    memset(atoms->count, 0, sizeof(atoms->count));
+
+    initTokenizer(&tokens, formula, length);
+    while (nextToken(&tokens, &token)) {
+        if (token.type == TOKEN_SYMBOL) {
+            int atomicNumber = lookupAtomicNumber(index, token.key);
+            if (atomicNumber < 1 || atomicNumber > MAX_ELEMENTS) {
+                return EXIT_FAILURE; // element can't be counted
+            }
+
+            multiplier = nextMultiplier(&tokens);
+            atoms->count[atomicNumber] += multiplier * products->totals[products->size - 1];
+        } else if (token.type == TOKEN_OPEN) { // begining of group, its multiplier follows the matching ')'
+            long long outer = products->totals[products->size - 1];
+            Tokenizer after = tokens;
+            after.position = state->closing[token.offset] + 1;
+            multiplier = nextMultiplier(&after);
+            if (pushCountGroup(products) != EXIT_SUCCESS) {
+                return EXIT_FAILURE;
+            }
+            addCountTop(products, outer * multiplier);
+        } else if (token.type == TOKEN_CLOSE) { // end of group, its multiplier was applied when it opened
+            long long product;
+            popCountGroup(products, &product);
+            nextMultiplier(&tokens);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+
+// Write the counts of the elements that occur in a formula as Symbol:count pairs
+int writeHistogram(const AtomCounts *atoms, const SymbolIndex *index, OutputBuffer *out) {
+    char number[24];
+    bool first = true;
+
+    for (int i = 1; i <= MAX_ELEMENTS; i++) {
+        if (atoms->count[i] == 0) {
+            continue;
+        }
+
+        int n = snprintf(number, sizeof(number), ":%lld", atoms->count[i]);
+        if ((!first && appendOutputChar(out, ' ') != EXIT_SUCCESS)
+            || appendOutput(out, index->symbol[i], strlen(index->symbol[i])) != EXIT_SUCCESS
+            || appendOutput(out, number, (size_t) n) != EXIT_SUCCESS) {
+            return EXIT_FAILURE;
+        }
+        first = false;
+    }
+
+    return appendOutputChar(out, '\n');
+}
+
+
+// Reads and calculates total protons number of each formula in the given input file
+void countProtons(const char *inputFile, const char *outputFile, Element periodicTable[], int numElements){
+    // Index the table once for all look-ups
+    SymbolIndex localIndex;
+    const SymbolIndex *index = &localIndex;
+    buildSymbolIndex(&localIndex, periodicTable, numElements);
+
+    InputReader *fin = NULL;
+    if(openInputReader(&fin, inputFile) != EXIT_SUCCESS){
+        perror("Unable to open input file for count protons.");
+        return;
+    }
 
     FILE *fout = fopen(outputFile, "w");
     if(fout == NULL){
         perror("Unable to open output file for count protons.");
-        fclose(fp);
-        exit(EXIT_FAILURE);
-    }
-
-    char formula[MAX_FORMULA_LENGTH];
-    while(fgets(formula, sizeof(formula), fp)){ // read each formula 1 by 1
-        const char *p = formula;
-        int totalAtomicNumber = 0;
-        while(*p != '\0'){ // iterate up to the end
-            if (isalpha(*p)) { // if is letter
-                Element element;
-                element.atomicNumber = 0;
-
-                if(isupper(*p) && islower(*(p + 1)) && islower(*(p + 2))){ // three-letter elements
-                    element.chemSymbol[0] = *p;
-                    element.chemSymbol[1] = *(p + 1);
-                    element.chemSymbol[2] = *(p + 2);
-                    element.chemSymbol[3] = '\0';
-                p += 2;
-                } else if (isupper(*p) && islower(*(p + 1))) { // two-letter elements
-                    element.chemSymbol[0] = *p;
-                    element.chemSymbol[1] = *(p + 1);
-                    element.chemSymbol[2] = '\0';
-                    p++;  // skip 2nd letter since we handled it above
-                } else {
-                    // Single-letter element
-                    element.chemSymbol[0] = *p;
-                    element.chemSymbol[1] = '\0';
-                }
+        closeInputReader(fin);
+        return;
+    }
 
-                // After constructing the element, look-up its atomic number
-                element.atomicNumber = getAtomicNumber(periodicTable, MAX_ELEMENTS, element.chemSymbol);
-                totalAtomicNumber += element.atomicNumber;
-            }
-            
-            p++; // move to next character of formula
-        }
+    FormulaWorkspace workspace;
+    if(initFormulaWorkspace(&workspace) != EXIT_SUCCESS){
+        closeInputReader(fin);
+        fclose(fout);
+        return;
+    }
+
+    const char *formula;
+    size_t length;
+    while(nextLine(fin, &formula, &length)){ // read each formula 1 by 1
+        long long totalAtomicNumber = 0;
 
-        fprintf(fout, "%d\n", totalAtomicNumber); // print formula's atomic number in output file
+        if(formulaProtons(formula, length, index, &workspace, &totalAtomicNumber) == EXIT_SUCCESS){
+            fprintf(fout, "%lld\n", totalAtomicNumber); // print formula's atomic number in output file
+        } else {
+            printf("Error processing formula: %.*s\n", (int) length, formula);
+        }
     }
 
-    fclose(fp);
+    freeFormulaWorkspace(&workspace);
+    closeInputReader(fin);
     fclose(fout);
 }
 
 
+#if defined(__SSE2__)
 /**
- * @brief Checks if the parentheses in a given formula are balanced.
+ * @brief Adds the depth changes of the whole 16-byte blocks of a formula to a depth counter.
  *
- * This function iterates over the provided chemical formula string and
- * verifies if the parentheses are balanced using a stack. It pushes
- * opening parentheses '(' onto the stack and pops them when encountering
- * closing parentheses ')'. The function returns true if all parentheses
- * are balanced, otherwise it returns false.
+ * Every block is compared with '(' and ')' at once; blocks without parentheses are skipped
+ * and otherwise the changes (+1 and -1) are added up into the depth after every byte of the
+ * block, whose minimum shows if the depth went below zero inside the block.
  *
- * @param formula A null-terminated string representing a chemical formula.
- * @return true if the parentheses in the formula are balanced, false otherwise.
+ * @param formula The formula to check.
+ * @param length The number of characters of the formula.
+ * @param[in,out] depth The depth counter.
+ * @return size_t The number of characters checked, or `length` + 1 if the depth went below zero.
  */
-static bool checkParentheses(const char *formula){
-    UnionStack *stack = NULL;
-    initUnionStack(&stack);
-
-    bool valid = true; // initially assume that the formula is valid
-    const char *p = formula; // pointer to iterate through the string
-
-    while (*p != '\0' && valid) { // check till end or until imbalance is found
-        if (*p == '(') {
-            pushCharUnion(stack, *p);
-        } else if (*p == ')') {
-            if (!isEmptyUnion(stack)) {
-                StackData poppedData;
-                StackDataType poppedType;
-                popUnion(stack, &poppedData, &poppedType);
-                if (poppedType != CHAR_TYPE || poppedData.charData != '(') {
-                    valid = false; // mismatched parentheses
-                }
-            } else {
-                valid = false; // extra closing parentheses at end
-            }
+static size_t parenthesesBlocks(const char *formula, size_t length, long *depth) {
+    const __m128i openChar = _mm_set1_epi8('(');
+    const __m128i closeChar = _mm_set1_epi8(')');
+    const __m128i bias = _mm_set1_epi8((char) 0x80); // signed to unsigned order, for _mm_min_epu8
+    size_t i = 0;
+
+    for (; i + 16 <= length; i += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i *) (formula + i));
+        __m128i open = _mm_cmpeq_epi8(bytes, openChar); // -1 at every '('
+        __m128i close = _mm_cmpeq_epi8(bytes, closeChar); // -1 at every ')'
+        if (_mm_movemask_epi8(_mm_or_si128(open, close)) == 0) {
+            continue; // no parentheses in the block
+        }
+
+        // Prefix sums of the changes: depth after every byte, relative to the block start
+        __m128i prefix = _mm_sub_epi8(close, open);
+        prefix = _mm_add_epi8(prefix, _mm_slli_si128(prefix, 1));
+        prefix = _mm_add_epi8(prefix, _mm_slli_si128(prefix, 2));
+        prefix = _mm_add_epi8(prefix, _mm_slli_si128(prefix, 4));
+        prefix = _mm_add_epi8(prefix, _mm_slli_si128(prefix, 8));
+
+        // Lowest depth of the block
+        __m128i lowest = _mm_xor_si128(prefix, bias);
+        lowest = _mm_min_epu8(lowest, _mm_shuffle_epi32(lowest, _MM_SHUFFLE(1, 0, 3, 2)));
+        lowest = _mm_min_epu8(lowest, _mm_shuffle_epi32(lowest, _MM_SHUFFLE(2, 3, 0, 1)));
+        lowest = _mm_min_epu8(lowest, _mm_shufflelo_epi16(lowest, _MM_SHUFFLE(2, 3, 0, 1)));
+        lowest = _mm_min_epu8(lowest, _mm_srli_epi16(lowest, 8));
+        int minimum = (int) (signed char) ((_mm_cvtsi128_si32(lowest) & 0xFF) ^ 0x80);
+
+        if (*depth + minimum < 0) {
+            return length + 1; // closing parentheses without an open group
+        }
+        *depth += (signed char) (_mm_extract_epi16(prefix, 7) >> 8); // depth after the last byte
+    }
+
+    return i;
+}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+/**
+ * @brief Adds the depth changes of the whole 16-byte blocks of a formula to a depth counter.
+ *
+ * Every block is compared with '(' and ')' at once; blocks without parentheses are skipped
+ * and otherwise the changes (+1 and -1) are added up into the depth after every byte of the
+ * block, whose minimum shows if the depth went below zero inside the block.
+ *
+ * @param formula The formula to check.
+ * @param length The number of characters of the formula.
+ * @param[in,out] depth The depth counter.
+ * @return size_t The number of characters checked, or `length` + 1 if the depth went below zero.
+ */
+static size_t parenthesesBlocks(const char *formula, size_t length, long *depth) {
+    const uint8x16_t openChar = vdupq_n_u8('(');
+    const uint8x16_t closeChar = vdupq_n_u8(')');
+    const int8x16_t zero = vdupq_n_s8(0);
+    size_t i = 0;
+
+    for (; i + 16 <= length; i += 16) {
+        uint8x16_t bytes = vld1q_u8((const uint8_t *) (formula + i));
+        uint8x16_t open = vceqq_u8(bytes, openChar); // 0xFF at every '('
+        uint8x16_t close = vceqq_u8(bytes, closeChar); // 0xFF at every ')'
+        if (vmaxvq_u8(vorrq_u8(open, close)) == 0) {
+            continue; // no parentheses in the block
+        }
+
+        // Prefix sums of the changes: depth after every byte, relative to the block start
+        int8x16_t prefix = vsubq_s8(vreinterpretq_s8_u8(close), vreinterpretq_s8_u8(open));
+        prefix = vaddq_s8(prefix, vextq_s8(zero, prefix, 15));
+        prefix = vaddq_s8(prefix, vextq_s8(zero, prefix, 14));
+        prefix = vaddq_s8(prefix, vextq_s8(zero, prefix, 12));
+        prefix = vaddq_s8(prefix, vextq_s8(zero, prefix, 8));
+
+        if (*depth + vminvq_s8(prefix) < 0) {
+            return length + 1; // closing parentheses without an open group
         }
-        p++;
+        *depth += vgetq_lane_s8(prefix, 15); // depth after the last byte
     }
 
-    // Check for any leftover opening parentheses in the stack
-    if (valid && !isEmptyUnion(stack)) {
-        valid = false;
+    return i;
+}
+#else
+/**
+ * @brief Portable version of the block check: no characters are checked in blocks.
+ *
+ * @param formula The formula to check.
+ * @param length The number of characters of the formula.
+ * @param[in,out] depth The depth counter.
+ * @return size_t Always 0.
+ */
+static size_t parenthesesBlocks(const char *formula, size_t length, long *depth) {
+    (void) formula;
+    (void) length;
+    (void) depth;
+    return 0;
+}
+#endif
+
+
+// Check the balance of a single formula with a depth counter, 16 characters at a time where possible
+bool balancedParentheses(const char *formula, size_t length) {
+    long depth = 0; // number of open groups
+
+    size_t i = parenthesesBlocks(formula, length, &depth);
+    if (i > length) {
+        return false; // closing parentheses without an open group
     }
 
-    // Clean up: Clear the stack
-    while (!isEmptyUnion(stack)) {
-        StackData tempData;
-        StackDataType tempType;
-        popUnion(stack, &tempData, &tempType);
+    for (; i < length; i++) { // rest of the formula, one character at a time
+        if (formula[i] == '(') {
+            depth++;
+        } else if (formula[i] == ')' && --depth < 0) {
+            return false; // closing parentheses without an open group
+        }
     }
 
-    free(stack);
-    return valid;
+    return (depth == 0);
 }
 
 
 // Validates the balance of parentheses of the formulas contained inside the given file
 bool validateParentheses(const char *inputFile) {
-    FILE *fp = fopen(inputFile, "r"); // open file for reading the formulas
-    if (fp == NULL) {
+    InputReader *fp = NULL;
+    if (openInputReader(&fp, inputFile) != EXIT_SUCCESS) { // open file for reading the formulas
         perror("Error opening file for parentheses validation.");
         return EXIT_FAILURE;
     }
 
-    char formula[MAX_FORMULA_LENGTH];
+    const char *formula;
+    size_t length;
     int lineIndex = 0;
     bool overallValid = true; // assume that all formulas are balanced
 
-    while (fgets(formula, sizeof(formula), fp) != NULL) { // read line-by-line
+    while (nextLine(fp, &formula, &length)) { // read line-by-line, without the newline character
         lineIndex++;
-        if (formula[strlen(formula) - 1] == '\n') {
-            formula[strlen(formula) - 1] = '\0'; // Remove the newline character, if present
-        }
 
-        bool valid = checkParentheses(formula);
+        bool valid = balancedParentheses(formula, length);
 
         if (!valid) { // If not valid, print the error message
             printf("Parentheses NOT balanced in line: %d\n", lineIndex);
@@ -346,7 +785,7 @@ bool validateParentheses(const char *inputFile) {
         }
     }
 
-    fclose(fp);
+    closeInputReader(fp);
     return overallValid; // return overall parentheses balance of file
 }
 
@@ -356,8 +795,10 @@ bool validateParentheses(const char *inputFile) {
 int main(){
 
     Element periodicTable[MAX_ELEMENTS];
-    int numElements = loadPeriodicTable("periodicTable.txt", periodicTable);
-    if(numElements == -1 || numElements == EXIT_FAILURE){
+    SymbolIndex index;
+    bool indexed;
+    int numElements = loadPeriodicTableIndex("periodicTable.txt", periodicTable, &index, &indexed);
+    if(numElements == -1 || numElements == EXIT_FAILURE || !indexed){
         printf("Unable to load periodic table for testing.\n");
         return EXIT_FAILURE;
     }
@@ -368,19 +809,78 @@ int main(){
     const char* invalidFormula = "H2(O";
 
     printf("Validating correct formula: %s\n", validFormula);
-    if (checkParentheses(validFormula)) {
+    if (balancedParentheses(validFormula, strlen(validFormula))) {
         printf("Formula is correctly balanced.\n");
     } else {
         printf("Formula should be balanced but is reported as unbalanced.\n");
     }
 
     printf("Validating incorrect formula: %s\n", invalidFormula);
-    if (!checkParentheses(invalidFormula)) {
+    if (!balancedParentheses(invalidFormula, strlen(invalidFormula))) {
         printf("Correctly identified unbalanced formula.\n");
     } else {
         printf("Failed to identify unbalanced formula.\n");
     }
 
+    // Compare the block check with a plain depth counter on random formulas of parentheses
+    int mismatches = 0;
+    char random[100];
+    srand(1);
+    for (int t = 0; t < 100000; t++) {
+        size_t length = (size_t) (rand() % 100);
+        long depth = 0;
+        bool expected = true;
+        for (size_t i = 0; i < length; i++) {
+            int pick = rand() % 5;
+            random[i] = (pick == 0) ? '(' : (pick == 1) ? ')' : (pick == 2) ? 'H' : (pick == 3) ? 'O' : '2';
+            depth += (random[i] == '(') - (random[i] == ')');
+            expected = expected && depth >= 0;
+        }
+        expected = expected && depth == 0;
+        mismatches += (balancedParentheses(random, length) != expected);
+    }
+    printf("Balance of 100000 random formulas: %d mismatches (expected 0)\n", mismatches);
+
+    // Test a group of more atoms than the first array of the group holds
+    const char *largeGroup = "(H2000O)3";
+    StackPool *pool = NULL;
+    if (initStackPool(&pool) == EXIT_SUCCESS) {
+        char *expanded = processFormula(largeGroup, pool);
+        size_t atoms = 0;
+        for (size_t i = 0; expanded != NULL && expanded[i] != '\0'; i++) {
+            atoms += (expanded[i] == 'H' || expanded[i] == 'O');
+        }
+        printf("Expansion of %s has %zu atoms (expected 6003)\n", largeGroup, atoms);
+        free(expanded);
+        freeStackPool(pool);
+    }
+
+    // Test the element counts of a formula with nested groups
+    printf("Testing element counts.\n");
+    const char *nestedFormula = "Co3(Fe(CN)6)2";
+    FormulaWorkspace workspace;
+    AtomCounts atoms;
+    OutputBuffer *out = NULL;
+    if (initFormulaWorkspace(&workspace) == EXIT_SUCCESS && initOutputBuffer(&out, NULL, 64) == EXIT_SUCCESS) {
+        if (formulaHistogram(nestedFormula, strlen(nestedFormula), &index, &workspace, &atoms) == EXIT_SUCCESS) {
+            writeHistogram(&atoms, &index, out);
+            printf("Counts of %s: %.*s (expected C:12 N:12 Fe:2 Co:3)\n", nestedFormula, (int) out->length - 1, out->data);
+        } else {
+            printf("Failed to count the elements of %s.\n", nestedFormula);
+        }
+
+        // Test the grouped form, whose expansion is the expansion of the formula
+        const char *groupedInput = "Co3 (Fe(C1N)6)2 (H)0";
+        out->length = 0;
+        if (groupFormula(groupedInput, strlen(groupedInput), out, &workspace) == EXIT_SUCCESS) {
+            printf("Grouped form of %s: %.*s (expected Co3(Fe(CN)6)2)\n", groupedInput, (int) out->length - 1, out->data);
+        } else {
+            printf("Failed to group %s.\n", groupedInput);
+        }
+        freeOutputBuffer(out);
+        freeFormulaWorkspace(&workspace);
+    }
+
     /*  TO RUN validateParentheses(inputFile) USE THE CODE BELOW AND PROVDE AN INPUT FILE.
 
         const char* fileName = "input.txt";
@@ -403,7 +903,7 @@ int main(){
     // Counting protons
     printf("Testing protons count. Results at 'protonsDEBUG.txt'.\n");
     printf("Counting protons in file %s\n", inputFile);
-    countProtons(inputFile, "protonsDEBUG.txt", periodicTable);    
+    countProtons(inputFile, "protonsDEBUG.txt", periodicTable, numElements);    
 
 }
 #endif // DEBUG_FEXPANDER
\ No newline at end of file
@@ -13,8 +13,248 @@
 #ifndef FORMULA_EXPANDER
 #define FORMULA_EXPANDER
 #include <stdbool.h>
+#include <stddef.h>
 #include "periodicTable.h"
 #include "unionStack.h"
+#include "countStack.h"
+#include "outputBuffer.h"
+
+
+/**
+ * @struct GroupFrame
+ * @brief State of a group that is being expanded by `expandFormula`.
+ *
+ * @var GroupFrame::bodyStart
+ * Index of the formula right after the group's '('.
+ *
+ * @var GroupFrame::bodyEnd
+ * Index of the formula of the group's matching ')'.
+ *
+ * @var GroupFrame::resume
+ * Index of the formula right after the group's multiplier.
+ *
+ * @var GroupFrame::remaining
+ * Iterations of the group left, including the current one.
+ *
+ * @var GroupFrame::spanStart
+ * Output offset where the current iteration began.
+ *
+ * @var GroupFrame::flushes
+ * Number of output flushes when the current iteration began.
+ *
+ * @var GroupFrame::atLineStart
+ * Whether the current iteration began with the first symbol of the line.
+ */
+typedef struct {
+    size_t bodyStart; // index right after '('
+    size_t bodyEnd; // index of the matching ')'
+    size_t resume; // index right after the group's multiplier
+    long long remaining; // iterations left, including the current one
+    size_t spanStart; // output offset where the current iteration began
+    unsigned long flushes; // output flushes when the current iteration began
+    bool atLineStart; // current iteration began with the first symbol of the line
+} GroupFrame;
+
+
+/**
+ * @struct ExpansionState
+ * @brief Reusable memory of the streaming expander: open groups and matching parentheses.
+ *
+ * @var ExpansionState::frames
+ * The open groups, innermost last.
+ *
+ * @var ExpansionState::depth
+ * The number of open groups.
+ *
+ * @var ExpansionState::capacity
+ * The number of allocated frames.
+ *
+ * @var ExpansionState::closing
+ * The index of the matching ')' of every '(' of the formula being expanded.
+ *
+ * @var ExpansionState::closingCapacity
+ * The number of allocated entries of closing.
+ *
+ * @var ExpansionState::allocations
+ * The number of allocations of frames and closing, growths included.
+ *
+ * @var ExpansionState::pushes
+ * The number of frames pushed since the state was initialized.
+ *
+ * @var ExpansionState::pops
+ * The number of frames popped since the state was initialized.
+ */
+typedef struct {
+    GroupFrame *frames; // open groups, innermost last
+    int depth; // number of open groups
+    int capacity; // allocated frames
+    size_t *closing; // index of the matching ')' of every '('
+    size_t closingCapacity; // allocated entries of closing
+    long allocations; // allocations of frames and closing
+    long long pushes; // frames pushed
+    long long pops; // frames popped
+} ExpansionState;
+
+
+/**
+ * @struct AtomCounts
+ * @brief The number of atoms of each element in a formula.
+ *
+ * @var AtomCounts::count
+ * The number of atoms of the element with each atomic number (index 0 is unused).
+ */
+typedef struct {
+    long long count[MAX_ELEMENTS + 1]; // atoms by atomic number
+} AtomCounts;
+
+
+/**
+ * @struct FormulaWorkspace
+ * @brief Memory reused by the formula engine from one formula to the next.
+ *
+ * A workspace must not be shared by formulas that are processed at the same time,
+ * so every thread uses its own.
+ *
+ * @var FormulaWorkspace::expansion
+ * Memory of the streaming expander.
+ *
+ * @var FormulaWorkspace::counts
+ * Count stack used for multiplier arithmetic.
+ */
+typedef struct {
+    ExpansionState expansion; // memory of expandFormula
+    CountStack *counts; // group totals of formulaProtons
+} FormulaWorkspace;
+
+
+/**
+ * @brief Initializes the reusable memory of the formula engine.
+ *
+ * @param workspace The workspace to initialize.
+ * @return int Returns 0 on success, or 1 if memory allocation fails.
+ */
+int initFormulaWorkspace(FormulaWorkspace *workspace);
+
+
+/**
+ * @brief Frees the reusable memory of the formula engine.
+ *
+ * @param workspace The workspace to free.
+ */
+void freeFormulaWorkspace(FormulaWorkspace *workspace);
+
+
+/**
+ * @brief Expands a chemical formula directly into an output buffer.
+ *
+ * This function produces the same expanded formula as `processFormula`, followed by a
+ * newline, without ever holding the expansion in memory. Symbols are written straight to
+ * the output buffer; a repeated element or group is emitted once and then its span of the
+ * output is copied for the remaining repetitions. If the span no longer is in the buffer
+ * (the buffer was flushed while it was being written) the group is expanded again from
+ * the formula instead. Memory used is bounded by the nesting depth and the buffer size.
+ *
+ * @param formula The compact chemical formula (doesn't need to be null-terminated).
+ * @param length The number of characters of the formula.
+ * @param out The output buffer that the expanded formula is written to.
+ * @param workspace Reusable memory for the open groups and the matching parentheses.
+ * @return int Returns 0 on success, or 1 if the parentheses are not balanced, memory runs out or writing fails.
+ */
+int expandFormula(const char *formula, size_t length, OutputBuffer *out, FormulaWorkspace *workspace);
+
+
+/**
+ * @brief Writes a formula in the shortest form that expands to the same line.
+ *
+ * The grouped form keeps the groups of the formula instead of expanding them, so its
+ * length only depends on the length of the formula. Everything the expander ignores is
+ * dropped: characters that are not symbols, numbers that don't follow a symbol or a group,
+ * multipliers of 1, and symbols and groups that appear zero times or are empty. The result
+ * is itself a formula: `expandFormula` turns it into exactly the line that the original
+ * formula expands to, e.g. `Co3(Fe(CN)6)2` for `Co3 (Fe(C1N)6)2 (H)0`.
+ *
+ * @param formula The compact chemical formula (doesn't need to be null-terminated).
+ * @param length The number of characters of the formula.
+ * @param out The output buffer that the grouped formula is written to.
+ * @param workspace Reusable memory for the matching parentheses.
+ * @return int Returns 0 on success, or 1 if the parentheses are not balanced, memory runs out or writing fails.
+ */
+int groupFormula(const char *formula, size_t length, OutputBuffer *out, FormulaWorkspace *workspace);
+
+
+/**
+ * @brief Calculates the total protons of a formula without expanding it.
+ *
+ * This function parses the compact formula once and keeps a running total for every
+ * open group in a count stack. The atomic number of each element is multiplied by the
+ * multiplier that follows it, and when a group closes its total is multiplied by the
+ * group's multiplier and added to the enclosing group. Symbols are recognised exactly
+ * like in `processFormula`, so the result equals the sum of the atomic numbers of the
+ * expanded formula, while memory only grows with the nesting depth.
+ *
+ * @param formula The compact chemical formula (doesn't need to be null-terminated).
+ * @param length The number of characters of the formula.
+ * @param index The symbol index of the periodic table used to look up atomic numbers.
+ * @param workspace Reusable memory for the group totals.
+ * @param[out] total A pointer to store the total protons of the formula.
+ * @return int Returns 0 on success, or 1 if the parentheses are not balanced or memory runs out.
+ */
+int formulaProtons(const char *formula, size_t length, const SymbolIndex *index, FormulaWorkspace *workspace, long long *total);
+
+
+/**
+ * @brief Counts the atoms of each element of a formula without expanding it.
+ *
+ * The multiplier of every group is read when the group opens (its closing parenthesis is
+ * known from matching the formula first), so each element is counted once with the product
+ * of its own multiplier and the multipliers of all enclosing groups. The work only depends
+ * on the length of the compact formula.
+ *
+ * @param formula The compact chemical formula (doesn't need to be null-terminated).
+ * @param length The number of characters of the formula.
+ * @param index The symbol index of the periodic table used to look up atomic numbers.
+ * @param workspace Reusable memory for the matched parentheses and the group multipliers.
+ * @param[out] atoms The counts of the formula's atoms.
+ * @return int Returns 0 on success, or 1 if the parentheses are not balanced, a symbol is not
+ *             in the periodic table or memory runs out.
+ */
+int formulaHistogram(const char *formula, size_t length, const SymbolIndex *index, FormulaWorkspace *workspace, AtomCounts *atoms);
+
+
+/**
+ * @brief Writes the atom counts of a formula as a line of `Symbol:count` pairs.
+ *
+ * Only elements that occur in the formula are written, in order of atomic number and
+ * separated by spaces, e.g. `H:2 O:1` for H2O.
+ *
+ * @param atoms The counts to write.
+ * @param index The symbol index that provides the symbol of each atomic number.
+ * @param out The output to write to.
+ * @return int Returns 0 on success, or 1 if writing fails.
+ */
+int writeHistogram(const AtomCounts *atoms, const SymbolIndex *index, OutputBuffer *out);
+
+
+/**
+ * @brief Processes a chemical formula and returns its expanded form.
+ *
+ * This function takes a chemical formula in the form of a string, parses it,
+ * and produces an expanded formula where elements are repeated based on
+ * multipliers specified in the formula. It supports nested parentheses and
+ * handles single, double, and triple-letter chemical symbols.
+ *
+ * The whole expansion is built in memory, so this function is meant for single formulas.
+ * `formulaProcessor` streams the expansion of files instead.
+ *
+ * The nodes of the stacks are taken from the given pool. They are not freed one by one;
+ * the caller releases them all at once with `resetStackPool` after the formula is processed.
+ *
+ * @param formula A string representing the chemical formula to be processed.
+ * @param pool The pool that the nodes of the stacks are taken from.
+ * @return A dynamically allocated string containing the expanded formula,
+ *         or NULL if there is an error in allocation or processing.
+ */
+char *processFormula(const char *formula, StackPool *pool);
 
 
 /**
@@ -24,6 +264,10 @@
  * and writes the expanded formulas to a specified output file. The expansion process
  * involves replacing compact chemical notation with the full repeated elements.
  *
+ * The expansion is streamed into a fixed-size output buffer that is written with large
+ * writes, and repeated groups are copied from their first emitted span, so memory use
+ * doesn't depend on the length of the expanded formulas.
+ *
  * @param inputFile The name of the input file containing original compact formulas.
  * @param outputFile The name of the output file where expanded formulas will be written.
  */
@@ -33,23 +277,39 @@ void formulaProcessor(const char *inputFile, const char *outputFile);
 /**
  * @brief Counts the total number of protons in the chemical formulas found in a file.
  * 
- * This function reads expanded chemical formulas from a file and uses the provided
- * periodic table to count the total number of protons for each formula. The result
- * is written to the output file provided.
+ * This function reads the compact chemical formulas from a file and uses the provided
+ * periodic table to count the total number of protons for each formula. The formulas
+ * are never expanded: every group total is multiplied by its multiplier while parsing,
+ * so no temporary file is used. The result is written to the output file provided.
+ * If a file can't be opened or memory runs out, the error is printed and the function returns.
  *
  * @param inputFile The name of the input file containing the chemical formulas (not expanded).
  * @param outputFile The name of the output file where the proton counts will be written.
  * @param periodicTable An array of `Element` structures representing the periodic table,
  *                      used to look up atomic numbers.
+ * @param numElements The number of elements loaded in the periodic table.
+ */
+void countProtons(const char *inputFile, const char *outputfile, Element periodicTable[], int numElements);
+
+
+/**
+ * @brief Checks if the parentheses of a single formula are balanced.
+ *
+ * Only the depth of the open groups is tracked, so no stack is needed. The formula
+ * doesn't have to be null-terminated.
+ *
+ * @param formula The formula to check.
+ * @param length The number of characters of the formula.
+ * @return true if every ')' closes an open '(' and every '(' is closed, false otherwise.
  */
-void countProtons(const char *inputFile, const char *outputfile, Element periodicTable[]);
+bool balancedParentheses(const char *formula, size_t length);
 
 
 /**
  * @brief Validates the balance of parentheses in each formula from a file.
  *
  * This function opens a file, reads each line as a formula, and checks whether
- * the parentheses in the formula are balanced by calling `checkParentheses`.
+ * the parentheses in the formula are balanced by calling `balancedParentheses`.
  * If an imbalance is found, it prints an error message indicating the line number.
  * The function returns true if all formulas in the file are balanced, and false otherwise.
  *
@@ -0,0 +1,222 @@
+/**
+ * @file formulaServer.c
+ * @brief Implementation of the resident mode that answers formula requests.
+ *
+ * This source file provides the loop that reads requests as they arrive, answers every
+ * complete one into an output buffer and flushes the answers once per batch of requests.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "formulaServer.h"
+#include "outputBuffer.h"
+
+
+/**
+ * @brief Checks if the mode of a request is the given one.
+ *
+ * @param mode The mode of the request (not null-terminated).
+ * @param length The number of characters of the mode.
+ * @param name The name of the mode, as in the command line.
+ * @return bool Returns true if they are equal.
+ */
+static bool isMode(const char *mode, size_t length, const char *name) {
+    return length == strlen(name) && memcmp(mode, name, length) == 0;
+}
+
+
+/**
+ * @brief Writes the answer line of a single request.
+ *
+ * @param request The request, a mode and a formula separated by a space, without its newline.
+ * @param length The number of characters of the request.
+ * @param handle The handle with the periodic table and the reusable memory of the engine.
+ * @param out The output buffer that the answer is written to.
+ * @param cache The cache of the answers of previous requests.
+ * @return int Returns 0 on success, or 1 if writing fails.
+ */
+static int answerRequest(const char *request, size_t length, FormulaHandle *handle, OutputBuffer *out, FormulaCache *cache) {
+    if (length > 0 && request[length - 1] == '\r') { // requests of clients that end lines with "\r\n"
+        length--;
+    }
+
+    const char *cached;
+    size_t cachedLength;
+    if (lookupFormula(cache, request, length, &cached, &cachedLength)) { // repeated request
+        return appendOutput(out, cached, cachedLength);
+    }
+
+    const char *space = (const char *) memchr(request, ' ', length);
+    size_t modeLength = (space != NULL) ? (size_t) (space - request) : length;
+    const char *formula = request + modeLength + (space != NULL ? 1 : 0);
+    size_t formulaLength = length - (size_t) (formula - request);
+
+    size_t answerStart = out->length;
+    unsigned long flushes = out->flushes;
+    FormulaStatus status;
+    char line[64];
+
+    if (isMode(request, modeLength, "-pn")) {
+        long long total = 0;
+        status = formula_protons(handle, formula, formulaLength, &total);
+        if (status == FORMULA_OK) {
+            int n = snprintf(line, sizeof(line), "%lld\n", total);
+            if (appendOutput(out, line, (size_t) n) != EXIT_SUCCESS) {
+                return EXIT_FAILURE;
+            }
+        }
+    } else if (isMode(request, modeLength, "-ext")) {
+        status = formula_validate(formula, formulaLength); // nothing is written for unbalanced formulas
+        if (status == FORMULA_OK && expandFormula(formula, formulaLength, out, &(handle->workspace)) != EXIT_SUCCESS) {
+            if (out->flushes != flushes) {
+                return EXIT_FAILURE; // part of the answer was written out
+            }
+            out->length = answerStart;
+            status = FORMULA_NO_MEMORY;
+        }
+    } else if (isMode(request, modeLength, "-hist")) {
+        AtomCounts atoms;
+        status = formula_counts(handle, formula, formulaLength, &atoms);
+        if (status == FORMULA_OK && writeHistogram(&atoms, &(handle->index), out) != EXIT_SUCCESS) {
+            return EXIT_FAILURE;
+        }
+    } else if (isMode(request, modeLength, "-v")) {
+        status = formula_validate(formula, formulaLength);
+        if (status == FORMULA_OK && appendOutput(out, SERVE_BALANCED "\n", sizeof(SERVE_BALANCED)) != EXIT_SUCCESS) {
+            return EXIT_FAILURE;
+        }
+    } else {
+        status = FORMULA_BAD_ARGUMENT; // unknown mode
+    }
+
+    if (status != FORMULA_OK) {
+        const char *message = formula_error(status);
+        if (appendOutput(out, SERVE_ERROR, sizeof(SERVE_ERROR) - 1) != EXIT_SUCCESS
+            || appendOutput(out, message, strlen(message)) != EXIT_SUCCESS
+            || appendOutputChar(out, '\n') != EXIT_SUCCESS) {
+            return EXIT_FAILURE;
+        }
+    } else if (out->flushes == flushes) { // the whole answer is still in the buffer
+        storeFormula(cache, request, length, out->data + answerStart, out->length - answerStart);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+
+// Answer the requests of an input until it ends, flushing once per batch of requests
+int serveFormulas(FILE *input, FILE *output, FormulaHandle *handle, CacheStats *stats) {
+    OutputBuffer *out = NULL;
+    FormulaCache *cache = NULL;
+    size_t capacity = SERVE_CHUNK_SIZE;
+    char *buffer = (char *) malloc(capacity);
+    if (buffer == NULL || initOutputBuffer(&out, output, OUTPUT_BUFFER_SIZE) != EXIT_SUCCESS) {
+        perror("Unable to allocate memory for serving requests.");
+        free(buffer);
+        return EXIT_FAILURE;
+    }
+    if (initFormulaCache(&cache, CACHE_SLOTS, CACHE_BYTES) != EXIT_SUCCESS) {
+        freeOutputBuffer(out);
+        free(buffer);
+        return EXIT_FAILURE;
+    }
+
+    size_t length = 0; // bytes of the buffer, all of them part of an incomplete request
+    int status = EXIT_SUCCESS;
+    while (status == EXIT_SUCCESS) {
+        if (length == capacity) { // a request longer than the buffer, double it
+            char *newPtr = (char *) realloc(buffer, 2 * capacity);
+            if (newPtr == NULL) {
+                perror("Unable to grow the request buffer.");
+                status = EXIT_FAILURE;
+                break;
+            }
+            buffer = newPtr;
+            capacity *= 2;
+        }
+
+        ssize_t n = read(fileno(input), buffer + length, capacity - length); // returns what has arrived, without waiting for more
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0) {
+            perror("Unable to read requests.");
+            status = EXIT_FAILURE;
+            break;
+        } else if (n == 0) { // input ended, a last request may have no newline
+            if (length > 0) {
+                status = answerRequest(buffer, length, handle, out, cache);
+            }
+            break;
+        }
+
+        // Answer every complete request that has arrived
+        size_t searched = length;
+        size_t start = 0;
+        length += (size_t) n;
+        const char *newline;
+        while (status == EXIT_SUCCESS && (newline = (const char *) memchr(buffer + searched, '\n', length - searched)) != NULL) {
+            size_t end = (size_t) (newline - buffer);
+            status = answerRequest(buffer + start, end - start, handle, out, cache);
+            start = end + 1;
+            searched = start;
+        }
+        memmove(buffer, buffer + start, length - start); // keep the incomplete request
+        length -= start;
+
+        // Send the answers of the whole batch at once
+        if (status == EXIT_SUCCESS && (flushOutputBuffer(out) != EXIT_SUCCESS || fflush(output) != 0)) {
+            status = EXIT_FAILURE;
+        }
+    }
+
+    if (flushOutputBuffer(out) != EXIT_SUCCESS || fflush(output) != 0) {
+        status = EXIT_FAILURE;
+    }
+    if (stats != NULL) {
+        *stats = cache->stats;
+    }
+
+    freeFormulaCache(cache);
+    freeOutputBuffer(out);
+    free(buffer);
+    return status;
+}
+
+
+#ifdef DEBUG_FSERVER
+
+int main() {
+    FormulaHandle *handle = NULL;
+    if (formula_open(&handle, "periodicTable.txt") != FORMULA_OK) {
+        printf("Failed to open the periodic table.\n");
+        return EXIT_FAILURE;
+    }
+
+    // Requests of every mode, failed ones, a repeated one and a last one without newline
+    const char *requests = "-pn Co3(Fe(CN)6)2\n-ext K4(ON(SO3)2)2\n-hist H2O\n-v (H2O\n-v H2O\n"
+                           "-pn (H2O\n-hist H2Xy\n-count H2O\n-pn Co3(Fe(CN)6)2\r\n-ext H2O";
+    FILE *input = tmpfile();
+    if (input == NULL || fputs(requests, input) == EOF || fflush(input) != 0) {
+        printf("Failed to write the requests.\n");
+        return EXIT_FAILURE;
+    }
+    rewind(input);
+
+    printf("Answers (expected 289, the expansion, H:2 O:1, an error, balanced, 2 errors, an error, 289, H H O):\n");
+    CacheStats stats = { 0, 0, 0 };
+    int status = serveFormulas(input, stdout, handle, &stats);
+    printf("Status: %d, cache hits: %lld (expected 0, 1)\n", status, stats.hits);
+
+    fclose(input);
+    formula_close(handle);
+    return 0;
+}
+#endif // DEBUG_FSERVER
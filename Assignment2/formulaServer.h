@@ -0,0 +1,52 @@
+/**
+ * @file formulaServer.h
+ * @brief Header file for the resident mode that answers formula requests line by line.
+ *
+ * This file contains the declarations of the `--serve` mode of `parseFormula`. The
+ * periodic table is loaded once, and then every line of the input is a request made of a
+ * mode and a formula, which is answered with a single line of output:
+ *
+ *     -pn Co3(Fe(CN)6)2      ->  289
+ *     -ext H2O               ->  H H O
+ *     -hist H2O              ->  H:2 O:1
+ *     -v (H2O                ->  error: Parentheses NOT balanced
+ *
+ * A valid formula is answered with `balanced` by `-v`, and every failed request with
+ * `error: ` followed by the message of its `FormulaStatus`. Requests are answered in order.
+ *
+ * Clients may send many requests without waiting for the answers. The input is read with
+ * plain `read` calls, which return whatever has arrived, every complete request read is
+ * answered, and the answers of all of them are written with a single flush before waiting
+ * for more input. A lone request is therefore answered right away, and a stream of them
+ * costs one read and one write per batch instead of per line.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs.
+ */
+
+#ifndef FORMULASERVER_H
+#define FORMULASERVER_H
+#include <stdio.h>
+#include "libformula.h"
+#include "formulaCache.h"
+
+#define SERVE_CHUNK_SIZE (1 << 16) /**< Initial size of the request buffer, grown for longer requests */
+#define SERVE_BALANCED "balanced" /**< Answer of a -v request for a balanced formula */
+#define SERVE_ERROR "error: " /**< Prefix of the answer of a failed request */
+
+
+/**
+ * @brief Answers the requests of an input until it ends.
+ *
+ * The answer of every request that succeeds is kept in a FormulaCache, so a repeated
+ * request is answered by copying its answer.
+ *
+ * @param[in] input The file that the requests are read from, with `read` calls on its descriptor.
+ * @param[in] output The file that the answers are written to.
+ * @param[in,out] handle The handle with the periodic table and the reusable memory of the engine.
+ * @param[out] stats A pointer to store the counters of the cache, or NULL.
+ * @return int Returns 0 when the input ends, or 1 if reading, writing or memory allocation fails.
+ */
+int serveFormulas(FILE *input, FILE *output, FormulaHandle *handle, CacheStats *stats);
+
+#endif // FORMULASERVER_H
@@ -0,0 +1,238 @@
+/**
+ * @file formulaStats.c
+ * @brief Implementation of the runtime statistics of `parseFormula`.
+ *
+ * This source file provides the phase timers, the passes that count the symbols, groups
+ * and atoms of the input formulas, the collection of the stack counters of the engine,
+ * and the JSON output of `--stats`.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "formulaStats.h"
+#include "formulaTokenizer.h"
+
+#define ATOM_TOTALS 64 /**< Group totals of countFormulaAtoms kept on the stack before it allocates */
+
+
+/**
+ * @brief Reads a clock in seconds.
+ *
+ * @param clock The clock to read.
+ * @return double The time of the clock, or 0 if it can't be read.
+ */
+static double clockSeconds(clockid_t clock) {
+    struct timespec now;
+    if (clock_gettime(clock, &now) != 0) {
+        return 0;
+    }
+    return (double) now.tv_sec + 1e-9 * (double) now.tv_nsec;
+}
+
+
+// Return the time of a monotonic clock
+double wallSeconds(void) {
+    return clockSeconds(CLOCK_MONOTONIC);
+}
+
+
+// Start timing a phase
+PhaseTime startPhase(void) {
+    PhaseTime start;
+    start.wall = clockSeconds(CLOCK_MONOTONIC);
+    start.cpu = clockSeconds(CLOCK_PROCESS_CPUTIME_ID);
+    return start;
+}
+
+
+// Add the time elapsed since the start of a phase
+void endPhase(PhaseTime *phase, PhaseTime start) {
+    PhaseTime now = startPhase();
+    phase->wall += now.wall - start.wall;
+    phase->cpu += now.cpu - start.cpu;
+}
+
+
+// Count the symbol lookups and groups of a processed formula
+void countFormulaShape(FormulaStats *stats, const char *formula, size_t length, bool lookups) {
+    Tokenizer tokens;
+    Token token;
+    long long depth = 0;
+    initTokenizer(&tokens, formula, length);
+    while (nextToken(&tokens, &token)) {
+        if (token.type == TOKEN_SYMBOL) {
+            stats->lookups += lookups;
+        } else if (token.type == TOKEN_OPEN) {
+            (stats->groups)++;
+            depth++;
+            if (depth > stats->peakDepth) {
+                stats->peakDepth = depth;
+            }
+        } else if (token.type == TOKEN_CLOSE) {
+            depth--;
+        }
+    }
+}
+
+
+// Count the atoms of a balanced formula with the multiplier arithmetic of formulaProtons
+void countFormulaAtoms(FormulaStats *stats, const char *formula, size_t length) {
+    long long local[ATOM_TOTALS];
+    long long *totals = local; // total of every open group, index 0 is the whole formula
+    size_t capacity = ATOM_TOTALS;
+    size_t depth = 0;
+    Tokenizer tokens;
+    Token token;
+    totals[0] = 0;
+
+    initTokenizer(&tokens, formula, length);
+    while (nextToken(&tokens, &token)) {
+        if (token.type == TOKEN_SYMBOL) {
+            totals[depth] += nextMultiplier(&tokens);
+        } else if (token.type == TOKEN_OPEN) {
+            if (depth + 1 == capacity) { // deeper than the totals on the stack, double them on the heap
+                long long *newPtr = (long long *) malloc(2 * capacity * sizeof(long long));
+                if (newPtr == NULL) {
+                    break; // the count is only a statistic, leave it out
+                }
+                memcpy(newPtr, totals, capacity * sizeof(long long));
+                if (totals != local) {
+                    free(totals);
+                }
+                totals = newPtr;
+                capacity *= 2;
+            }
+            totals[++depth] = 0;
+        } else if (token.type == TOKEN_CLOSE && depth > 0) {
+            long long group = totals[depth--];
+            totals[depth] += group * nextMultiplier(&tokens);
+        }
+    }
+
+    if (depth == 0) {
+        stats->atoms += totals[0];
+    }
+    if (totals != local) {
+        free(totals);
+    }
+}
+
+
+// Add the stack counters of a workspace
+void countWorkspaceStacks(FormulaStats *stats, const FormulaWorkspace *workspace) {
+    stats->stackPushes += workspace->expansion.pushes + workspace->counts->pushes;
+    stats->stackPops += workspace->expansion.pops + workspace->counts->pops;
+    stats->allocations += workspace->expansion.allocations + workspace->counts->allocations;
+}
+
+
+// Add the counters of a thread to a total
+void addFormulaStats(FormulaStats *total, const FormulaStats *stats) {
+    total->read += stats->read;
+    total->process += stats->process;
+    total->write += stats->write;
+    total->lines += stats->lines;
+    total->unbalanced += stats->unbalanced;
+    total->atoms += stats->atoms;
+    total->lookups += stats->lookups;
+    total->groups += stats->groups;
+    if (stats->peakDepth > total->peakDepth) {
+        total->peakDepth = stats->peakDepth;
+    }
+    total->stackPushes += stats->stackPushes;
+    total->stackPops += stats->stackPops;
+    total->allocations += stats->allocations;
+    total->bytesRead += stats->bytesRead;
+    total->bytesWritten += stats->bytesWritten;
+    addCacheStats(&total->cache, &stats->cache);
+}
+
+
+/**
+ * @brief Prints a phase as a JSON member.
+ *
+ * @param output The file to print to.
+ * @param name The name of the phase.
+ * @param phase The times of the phase.
+ */
+static void printPhase(FILE *output, const char *name, const PhaseTime *phase) {
+    fprintf(output, "\"%s\":{\"wall_ms\":%.3f,\"cpu_ms\":%.3f},", name, 1e3 * phase->wall, 1e3 * phase->cpu);
+}
+
+
+// Print the statistics as a single-line JSON object
+void printFormulaStats(FILE *output, const char *mode, int threads, const FormulaStats *stats) {
+    fprintf(output, "{\"mode\":\"%s\",\"threads\":%d,\"phases\":{", mode, threads);
+    printPhase(output, "load", &stats->load);
+    printPhase(output, "sort", &stats->sort);
+    printPhase(output, "run", &stats->run);
+    fprintf(output, "\"read\":{\"wall_ms\":%.3f},\"process\":{\"wall_ms\":%.3f},\"write\":{\"wall_ms\":%.3f}},",
+            1e3 * stats->read, 1e3 * stats->process, 1e3 * stats->write);
+    fprintf(output, "\"lines\":%lld,\"unbalanced\":%lld,", stats->lines, stats->unbalanced);
+    fprintf(output, "\"input\":{\"atoms\":%lld,\"lookups\":%lld,\"groups\":%lld,\"peak_depth\":%lld},", stats->atoms,
+            stats->lookups, stats->groups, stats->peakDepth);
+    fprintf(output, "\"stacks\":{\"pushes\":%lld,\"pops\":%lld,\"allocations\":%lld},", stats->stackPushes, stats->stackPops,
+            stats->allocations);
+    fprintf(output, "\"bytes_read\":%lld,\"bytes_written\":%lld,", stats->bytesRead, stats->bytesWritten);
+    fprintf(output, "\"cache\":{\"hits\":%lld,\"misses\":%lld,\"evictions\":%lld}}\n", stats->cache.hits, stats->cache.misses,
+            stats->cache.evictions);
+}
+
+
+#ifdef DEBUG_FSTATS
+
+int main() {
+    FormulaStats stats;
+    memset(&stats, 0, sizeof(stats));
+
+    // Shape of a formula with nested groups
+    const char *formula = "K4(ON(SO3)2)2";
+    countFormulaShape(&stats, formula, strlen(formula), true);
+    printf("Lookups: %lld, groups: %lld, peak depth: %lld (expected 5, 2, 2)\n", stats.lookups, stats.groups, stats.peakDepth);
+
+    // Atoms of formulas with groups, a zero multiplier and a nesting deeper than the totals on the stack
+    countFormulaAtoms(&stats, "H2O", 3);
+    countFormulaAtoms(&stats, "Co3(Fe(CN)6)2", 13);
+    countFormulaAtoms(&stats, "(H)0", 4);
+    char deep[2 * 100 + 2];
+    for (int i = 0; i < 100; i++) {
+        deep[i] = '(';
+        deep[101 + i] = ')';
+    }
+    deep[100] = 'H';
+    countFormulaAtoms(&stats, deep, sizeof(deep) - 1);
+    printf("Atoms: %lld (expected 33)\n", stats.atoms);
+
+    // Stack counters of a workspace that expanded a formula
+    FormulaWorkspace workspace;
+    OutputBuffer *out = NULL;
+    if (initFormulaWorkspace(&workspace) == EXIT_SUCCESS && initOutputBuffer(&out, NULL, 64) == EXIT_SUCCESS) {
+        expandFormula(formula, strlen(formula), out, &workspace);
+        countWorkspaceStacks(&stats, &workspace);
+        printf("Stack pushes: %lld, pops: %lld (expected 2, 2)\n", stats.stackPushes, stats.stackPops);
+        freeOutputBuffer(out);
+        freeFormulaWorkspace(&workspace);
+    }
+
+    // Phases take time
+    PhaseTime phase = { 0, 0 };
+    PhaseTime start = startPhase();
+    volatile double sink = 0;
+    for (int i = 0; i < 1000000; i++) {
+        sink += i;
+    }
+    endPhase(&phase, start);
+    printf("Busy loop: wall %.3f ms, cpu %.3f ms (both above 0)\n", 1e3 * phase.wall, 1e3 * phase.cpu);
+
+    stats.lines = 3;
+    printFormulaStats(stdout, "-ext", 1, &stats);
+    return 0;
+}
+#endif // DEBUG_FSTATS
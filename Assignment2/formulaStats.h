@@ -0,0 +1,217 @@
+/**
+ * @file formulaStats.h
+ * @brief Header file for the runtime statistics of `parseFormula` (`--stats`).
+ *
+ * This file contains the counters and phase timers that `--stats` prints as a single
+ * JSON object on the standard error. The counters are only updated when statistics are
+ * requested: every function of the engine that takes a `FormulaStats` pointer accepts
+ * NULL, and then costs a single test per formula or per batch.
+ *
+ * There are two kinds of counters. The pushes, pops and allocations of the stacks of the
+ * engine are counted by the stacks themselves, once per group, and are collected from the
+ * workspace of every thread. Counters that can be derived from a formula, like its
+ * atoms, symbols and groups, are computed by a separate pass over the input formula, so
+ * the inner loops of the engine are never instrumented for them; they are printed under
+ * "input" in the JSON object.
+ *
+ * Every thread fills its own `FormulaStats`, which is added to the total once the thread
+ * is done, like the counters of the formula caches.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs.
+ */
+
+#ifndef FORMULASTATS_H
+#define FORMULASTATS_H
+#include <stdio.h>
+#include <stddef.h>
+#include "formulaCache.h"
+#include "formulaExpander.h"
+
+
+/**
+ * @struct PhaseTime
+ * @brief The wall-clock and processor time of a phase, in seconds.
+ *
+ * @var PhaseTime::wall
+ * The elapsed real time.
+ *
+ * @var PhaseTime::cpu
+ * The processor time of every thread of the process (more than `wall` when several threads run).
+ */
+typedef struct {
+    double wall; // elapsed real time
+    double cpu; // processor time of the whole process
+} PhaseTime;
+
+
+/**
+ * @struct FormulaStats
+ * @brief The counters and phase timers of a run.
+ *
+ * @var FormulaStats::load
+ * Loading the periodic table.
+ *
+ * @var FormulaStats::sort
+ * Sorting the periodic table.
+ *
+ * @var FormulaStats::run
+ * Processing the input file, from opening it to closing the output file.
+ *
+ * @var FormulaStats::read
+ * Wall time spent reading batches of lines, summed over the threads.
+ *
+ * @var FormulaStats::process
+ * Wall time spent validating and expanding or counting formulas, summed over the threads.
+ *
+ * @var FormulaStats::write
+ * Wall time spent writing the output, summed over the threads.
+ *
+ * @var FormulaStats::lines
+ * The number of formulas read.
+ *
+ * @var FormulaStats::unbalanced
+ * The number of formulas with unbalanced parentheses.
+ *
+ * @var FormulaStats::atoms
+ * The number of atoms of the formulas whose line was written, counted from the input:
+ * the symbols of the -ext lines, or the sum of the -hist counts, also for -pn.
+ *
+ * @var FormulaStats::lookups
+ * The number of symbols of the processed formulas, which are looked up in the periodic
+ * table (-pn and -hist), counted from the input.
+ *
+ * @var FormulaStats::groups
+ * The number of groups of the processed formulas, counted from the input.
+ *
+ * @var FormulaStats::peakDepth
+ * The deepest nesting of groups of the processed formulas, counted from the input.
+ *
+ * @var FormulaStats::stackPushes
+ * The number of groups pushed on the stacks of the engine (the frames of the expander and
+ * the totals of the count stack). The expander skips groups with a zero multiplier, pushes
+ * a group once when it copies its first iteration and again for every iteration it has to
+ * expand again, so this can differ from `groups`.
+ *
+ * @var FormulaStats::stackPops
+ * The number of groups popped from the stacks of the engine.
+ *
+ * @var FormulaStats::allocations
+ * The allocations of the memory that the engine reuses between formulas, growths included.
+ *
+ * @var FormulaStats::bytesRead
+ * The bytes of the lines read, newlines included.
+ *
+ * @var FormulaStats::bytesWritten
+ * The bytes written to the output file.
+ *
+ * @var FormulaStats::cache
+ * The counters of the caches of the output lines.
+ */
+typedef struct {
+    PhaseTime load; // loading the periodic table
+    PhaseTime sort; // sorting the periodic table
+    PhaseTime run; // processing the input file
+    double read; // wall time reading batches, all threads
+    double process; // wall time processing formulas, all threads
+    double write; // wall time writing output, all threads
+    long long lines; // formulas read
+    long long unbalanced; // formulas with unbalanced parentheses
+    long long atoms; // atoms of the written lines (from the input)
+    long long lookups; // symbols looked up in the periodic table (from the input)
+    long long groups; // groups of the processed formulas (from the input)
+    long long peakDepth; // deepest nesting of groups (from the input)
+    long long stackPushes; // groups pushed on the stacks of the engine
+    long long stackPops; // groups popped from the stacks of the engine
+    long long allocations; // allocations of the reusable memory of the engine
+    long long bytesRead; // bytes of the lines read
+    long long bytesWritten; // bytes written to the output
+    CacheStats cache; // counters of the caches of output lines
+} FormulaStats;
+
+
+/**
+ * @brief Returns the current time of a monotonic clock.
+ *
+ * @return double The time in seconds, from an arbitrary start.
+ */
+double wallSeconds(void);
+
+
+/**
+ * @brief Starts timing a phase.
+ *
+ * @return PhaseTime The current wall-clock and processor times, to pass to endPhase.
+ */
+PhaseTime startPhase(void);
+
+
+/**
+ * @brief Adds the time elapsed since the start of a phase to it.
+ *
+ * @param[in,out] phase The phase to add the elapsed time to.
+ * @param[in] start The times returned by startPhase.
+ */
+void endPhase(PhaseTime *phase, PhaseTime start);
+
+
+/**
+ * @brief Counts the symbol lookups and groups of a formula that was processed.
+ *
+ * The formula is tokenized again, so this is only called when statistics are requested.
+ *
+ * @param[in,out] stats The statistics to add the counts to.
+ * @param[in] formula The formula (doesn't need to be null-terminated).
+ * @param[in] length The number of characters of the formula.
+ * @param[in] lookups Whether the mode looks the symbols up in the periodic table.
+ */
+void countFormulaShape(FormulaStats *stats, const char *formula, size_t length, bool lookups);
+
+
+/**
+ * @brief Counts the atoms of the expansion of a balanced formula.
+ *
+ * The atoms are counted from the formula with a running total of every open group, like
+ * `formulaProtons` with every atom weighing 1, so the formula is not expanded and the
+ * stacks of the engine are not used.
+ *
+ * @param[in,out] stats The statistics to add the count to.
+ * @param[in] formula The formula (doesn't need to be null-terminated).
+ * @param[in] length The number of characters of the formula.
+ */
+void countFormulaAtoms(FormulaStats *stats, const char *formula, size_t length);
+
+
+/**
+ * @brief Adds the stack pushes, pops and allocations of a workspace to the statistics.
+ *
+ * @param[in,out] stats The statistics to add the counters to.
+ * @param[in] workspace The workspace, before it is freed.
+ */
+void countWorkspaceStacks(FormulaStats *stats, const FormulaWorkspace *workspace);
+
+
+/**
+ * @brief Adds the counters of a thread to a total.
+ *
+ * The phase times of the run are not added, since they are measured by the main thread.
+ *
+ * @param[in,out] total The total.
+ * @param[in] stats The counters of the thread.
+ */
+void addFormulaStats(FormulaStats *total, const FormulaStats *stats);
+
+
+/**
+ * @brief Prints the statistics as a single-line JSON object.
+ *
+ * Times are printed in milliseconds.
+ *
+ * @param[in] output The file to print to.
+ * @param[in] mode The mode of the run, as in the command line.
+ * @param[in] threads The number of worker threads.
+ * @param[in] stats The statistics.
+ */
+void printFormulaStats(FILE *output, const char *mode, int threads, const FormulaStats *stats);
+
+#endif // FORMULASTATS_H
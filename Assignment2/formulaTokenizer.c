@@ -0,0 +1,104 @@
+/**
+ * @file formulaTokenizer.c
+ * @brief Implementation of the character classes of the formula tokenizer.
+ *
+ * This source file provides the table that gives the class of every character. The
+ * tokenizer itself is defined inline in the header.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "formulaTokenizer.h"
+
+#define O CHAR_OTHER
+#define U CHAR_UPPER
+#define L CHAR_LOWER
+#define D CHAR_DIGIT
+
+// Class of every character, 16 characters per row (only ASCII letters, digits and parentheses are classified)
+const unsigned char tokenClass[256] = {
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, // 0x00
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, // 0x10
+    O, O, O, O, O, O, O, O, CHAR_OPEN, CHAR_CLOSE, O, O, O, O, O, O, // 0x20: ' ' to '/'
+    D, D, D, D, D, D, D, D, D, D, O, O, O, O, O, O, // 0x30: '0' to '?'
+    O, U, U, U, U, U, U, U, U, U, U, U, U, U, U, U, // 0x40: '@' to 'O'
+    U, U, U, U, U, U, U, U, U, U, U, O, O, O, O, O, // 0x50: 'P' to '_'
+    O, L, L, L, L, L, L, L, L, L, L, L, L, L, L, L, // 0x60: '`' to 'o'
+    L, L, L, L, L, L, L, L, L, L, L, O, O, O, O, O, // 0x70: 'p' to DEL
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, // 0x80 to 0xFF: not ASCII
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O,
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O,
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O,
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O,
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O,
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O,
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O
+};
+
+#undef O
+#undef U
+#undef L
+#undef D
+
+
+#ifdef DEBUG_FTOKENIZER
+#include <ctype.h>
+#include <string.h>
+#include "periodicTable.h"
+
+int main() {
+    // The table agrees with the C locale
+    int mismatches = 0;
+    for (int c = 0; c < 256; c++) {
+        unsigned char expected = isupper(c) ? CHAR_UPPER : islower(c) ? CHAR_LOWER : isdigit(c) ? CHAR_DIGIT
+                                 : (c == '(') ? CHAR_OPEN : (c == ')') ? CHAR_CLOSE : CHAR_OTHER;
+        mismatches += (tokenClass[c] != expected);
+    }
+    printf("Character classes that differ from ctype: %d (expected 0)\n", mismatches);
+
+    // Tokens of a formula, with the keys packed as symbolKey packs them
+    const char *formula = "K4(ON(SO3)2)2 x 12 Uuo";
+    const char *names[] = { "END", "SYMBOL", "NUMBER", "OPEN", "CLOSE" };
+    Tokenizer tokenizer;
+    Token token;
+    int wrongKeys = 0;
+
+    initTokenizer(&tokenizer, formula, strlen(formula));
+    while (nextToken(&tokenizer, &token)) {
+        printf("%-6s %2zu %.*s", names[token.type], token.offset, (int) token.length, formula + token.offset);
+        if (token.type == TOKEN_SYMBOL) {
+            wrongKeys += (token.key != symbolKey(formula + token.offset, token.length));
+            printf(" x%lld", nextMultiplier(&tokenizer));
+        } else if (token.type == TOKEN_CLOSE) {
+            printf(" x%lld", nextMultiplier(&tokenizer));
+        } else if (token.type == TOKEN_NUMBER) {
+            printf(" = %lld", token.value);
+        }
+        printf("\n");
+    }
+    printf("Symbols whose key differs from symbolKey: %d (expected 0)\n", wrongKeys);
+
+    // A formula doesn't need to be null-terminated: "Na" cut after its first letter is "N"
+    initTokenizer(&tokenizer, "NaCl", 1);
+    nextToken(&tokenizer, &token);
+    size_t cutLength = token.length;
+    bool more = nextToken(&tokenizer, &token);
+    printf("Cut symbol: %.*s, then more tokens: %d (expected N, 0)\n", (int) cutLength, "NaCl", more);
+
+    // Spaces may separate a multiplier from its symbol, but are not consumed without one
+    initTokenizer(&tokenizer, "H 2O", 4);
+    nextToken(&tokenizer, &token);
+    long long spaced = nextMultiplier(&tokenizer);
+    nextToken(&tokenizer, &token);
+    long long unspaced = nextMultiplier(&tokenizer);
+    initTokenizer(&tokenizer, "H O", 3);
+    nextToken(&tokenizer, &token);
+    long long none = nextMultiplier(&tokenizer);
+    printf("Multipliers of H 2O: %lld %lld, of H O: %lld at %zu (expected 2 1, 1 at 1)\n", spaced, unspaced, none, tokenizer.position);
+
+    return 0;
+}
+#endif // DEBUG_FTOKENIZER
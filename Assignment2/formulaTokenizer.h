@@ -0,0 +1,199 @@
+/**
+ * @file formulaTokenizer.h
+ * @brief Header file for the tokenizer shared by every mode of the formula engine.
+ *
+ * This file contains the definitions of a tokenizer that splits a compact formula into
+ * chemical symbols, numbers and parentheses. A token is only the offset and length of its
+ * characters in the formula, together with the packed key of a symbol (as `symbolKey`
+ * would compute it) or the value of a number, so nothing is copied. The class of every
+ * character comes from a 256-entry table instead of the locale-dependent `ctype` functions.
+ *
+ * Symbols are an uppercase letter followed by up to two lowercase letters; any other
+ * letter is a single-letter symbol without a key. Characters that are not letters, digits
+ * or parentheses are skipped. A multiplier is the number that follows a symbol or a closing
+ * parenthesis, as `nextMultiplier` reads it; skipped characters such as spaces may come
+ * between them, so "H 2O" has two hydrogen atoms like "H2O". The multiplier of a group
+ * applies to the whole group even after a space, where the original expander repeated only
+ * the last symbol of the group.
+ *
+ * The functions are defined here as `static inline`, so the loops of the expander and the
+ * counters that consume the tokens are compiled into a single loop each.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs.
+ */
+
+#ifndef FORMULATOKENIZER_H
+#define FORMULATOKENIZER_H
+#include <stdbool.h>
+#include <stddef.h>
+
+#define CHAR_OTHER 0 /**< Class of the characters that are skipped */
+#define CHAR_UPPER 1 /**< Class of the uppercase letters */
+#define CHAR_LOWER 2 /**< Class of the lowercase letters */
+#define CHAR_DIGIT 4 /**< Class of the decimal digits */
+#define CHAR_OPEN 8 /**< Class of '(' */
+#define CHAR_CLOSE 16 /**< Class of ')' */
+
+extern const unsigned char tokenClass[256]; /**< Class of every character */
+
+
+/**
+ * @enum TokenType
+ * @brief Enum to specify the kind of a token.
+ */
+typedef enum {
+    TOKEN_END, /**< The formula has no more tokens */
+    TOKEN_SYMBOL, /**< A chemical symbol */
+    TOKEN_NUMBER, /**< A number that doesn't follow a symbol or a group */
+    TOKEN_OPEN, /**< An opening parenthesis */
+    TOKEN_CLOSE /**< A closing parenthesis */
+} TokenType;
+
+
+/**
+ * @struct Token
+ * @brief A token of a formula, as a span of the formula.
+ *
+ * @var Token::type
+ * The kind of the token.
+ *
+ * @var Token::offset
+ * The index of the first character of the token in the formula.
+ *
+ * @var Token::length
+ * The number of characters of the token.
+ *
+ * @var Token::key
+ * The packed key of a symbol, or -1 for a symbol that doesn't start with an uppercase letter.
+ *
+ * @var Token::value
+ * The value of a number.
+ */
+typedef struct {
+    TokenType type; // kind of token
+    size_t offset; // first character in the formula
+    size_t length; // number of characters
+    int key; // packed key of a symbol (-1 = not a valid symbol)
+    long long value; // value of a number
+} Token;
+
+
+/**
+ * @struct Tokenizer
+ * @brief The position of the tokenizer in a formula.
+ *
+ * @var Tokenizer::text
+ * The formula (doesn't need to be null-terminated).
+ *
+ * @var Tokenizer::length
+ * The number of characters of the formula.
+ *
+ * @var Tokenizer::position
+ * The index of the next character to read; may be moved to any index by the caller.
+ */
+typedef struct {
+    const char *text; // formula
+    size_t length; // characters of the formula
+    size_t position; // next character to read
+} Tokenizer;
+
+
+/**
+ * @brief Starts tokenizing a formula.
+ *
+ * @param[out] tokenizer The tokenizer to start.
+ * @param[in] text The formula (doesn't need to be null-terminated).
+ * @param[in] length The number of characters of the formula.
+ */
+static inline void initTokenizer(Tokenizer *tokenizer, const char *text, size_t length) {
+    tokenizer->text = text;
+    tokenizer->length = length;
+    tokenizer->position = 0;
+}
+
+
+/**
+ * @brief Reads the next token of a formula.
+ *
+ * @param[in,out] tokenizer The tokenizer, moved past the token.
+ * @param[out] token The token read.
+ * @return bool Returns false at the end of the formula (the token is TOKEN_END), true otherwise.
+ */
+static inline bool nextToken(Tokenizer *tokenizer, Token *token) {
+    const unsigned char *text = (const unsigned char *) tokenizer->text;
+    size_t end = tokenizer->length;
+    size_t i = tokenizer->position;
+
+    while (i < end && tokenClass[text[i]] == CHAR_OTHER) { // skip spaces and other characters
+        i++;
+    }
+    token->offset = i;
+    if (i >= end) {
+        tokenizer->position = end;
+        token->type = TOKEN_END;
+        token->length = 0;
+        return false;
+    }
+
+    unsigned char class = tokenClass[text[i]];
+    size_t length = 1;
+    if (class == CHAR_UPPER) { // key: first letter in base 26, next two letters in base 27 (0 = no letter)
+        int key = (text[i] - 'A') * 27 * 27;
+        if (i + 1 < end && tokenClass[text[i + 1]] == CHAR_LOWER) {
+            key += (text[i + 1] - 'a' + 1) * 27;
+            length = 2;
+            if (i + 2 < end && tokenClass[text[i + 2]] == CHAR_LOWER) {
+                key += text[i + 2] - 'a' + 1;
+                length = 3;
+            }
+        }
+        token->type = TOKEN_SYMBOL;
+        token->key = key;
+    } else if (class == CHAR_LOWER) { // single letter without a symbol
+        token->type = TOKEN_SYMBOL;
+        token->key = -1;
+    } else if (class == CHAR_DIGIT) {
+        long long value = text[i] - '0';
+        while (i + length < end && tokenClass[text[i + length]] == CHAR_DIGIT) {
+            value = (value * 10) + (text[i + length] - '0');
+            length++;
+        }
+        token->type = TOKEN_NUMBER;
+        token->value = value;
+    } else {
+        token->type = (class == CHAR_OPEN) ? TOKEN_OPEN : TOKEN_CLOSE;
+    }
+
+    token->length = length;
+    tokenizer->position = i + length;
+    return true;
+}
+
+
+/**
+ * @brief Reads the multiplier at the position of the tokenizer, if any, after the skipped characters.
+ *
+ * @param[in,out] tokenizer The tokenizer, moved past the digits of the multiplier (not moved without one).
+ * @return long long The multiplier, or 1 if the next character that is not skipped is not a digit.
+ */
+static inline long long nextMultiplier(Tokenizer *tokenizer) {
+    const unsigned char *text = (const unsigned char *) tokenizer->text;
+    size_t i = tokenizer->position;
+    while (i < tokenizer->length && tokenClass[text[i]] == CHAR_OTHER) { // skip spaces like nextToken
+        i++;
+    }
+    if (i >= tokenizer->length || tokenClass[text[i]] != CHAR_DIGIT) {
+        return 1;
+    }
+
+    long long multiplier = 0;
+    while (i < tokenizer->length && tokenClass[text[i]] == CHAR_DIGIT) { // handles multi-digit multipliers too
+        multiplier = (multiplier * 10) + (text[i] - '0');
+        i++;
+    }
+    tokenizer->position = i;
+    return multiplier;
+}
+
+#endif // FORMULATOKENIZER_H
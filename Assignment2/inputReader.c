@@ -0,0 +1,240 @@
+/**
+ * @file inputReader.c
+ * @brief Implementation of the line reader over mapped or buffered input.
+ *
+ * This source file provides the implementations of the functions for reading the lines
+ * of an input file. Functions include opening the input (memory-mapping it when it is a
+ * regular file), returning the next line as a span and closing the input.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "inputReader.h"
+
+
+/**
+ * @brief Tries to memory-map a regular file.
+ *
+ * @param reader The reader to fill with the mapping.
+ * @param inputFile The name of the file.
+ * @return int Returns 0 if the file was mapped (or is empty), or 1 if it must be read instead.
+ */
+static int mapInput(InputReader *reader, const char *inputFile) {
+    int fd = open(inputFile, O_RDONLY);
+    if (fd < 0) {
+        return EXIT_FAILURE;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        close(fd);
+        return EXIT_FAILURE; // pipes and devices are read through the buffer
+    }
+
+    reader->length = (size_t) info.st_size;
+    reader->mapped = true;
+    if (reader->length == 0) { // empty files can't be mapped, there is nothing to read anyway
+        close(fd);
+        reader->data = NULL;
+        return EXIT_SUCCESS;
+    }
+
+    void *mapping = mmap(NULL, reader->length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping stays valid without the descriptor
+    if (mapping == MAP_FAILED) {
+        reader->mapped = false;
+        reader->length = 0;
+        return EXIT_FAILURE;
+    }
+
+    posix_madvise(mapping, reader->length, POSIX_MADV_SEQUENTIAL); // only a hint, failure is harmless
+    reader->data = (char *) mapping;
+    return EXIT_SUCCESS;
+}
+
+
+// Open a file (or the standard input) for reading its lines
+int openInputReader(InputReader **reader, const char *inputFile) {
+    *reader = (InputReader *) malloc(sizeof(InputReader));
+    if (*reader == NULL) {
+        perror("Unable to allocate memory for input reader.");
+        return EXIT_FAILURE;
+    }
+
+    (*reader)->data = NULL;
+    (*reader)->length = 0;
+    (*reader)->position = 0;
+    (*reader)->capacity = 0;
+    (*reader)->mapped = false;
+    (*reader)->file = NULL;
+
+    bool useStdin = (strcmp(inputFile, STDIN_NAME) == 0);
+    if (!useStdin && mapInput(*reader, inputFile) == EXIT_SUCCESS) {
+        return EXIT_SUCCESS;
+    }
+
+    // Fall back to reading the input in chunks
+    (*reader)->file = useStdin ? stdin : fopen(inputFile, "r");
+    if ((*reader)->file == NULL) {
+        free(*reader);
+        *reader = NULL;
+        return EXIT_FAILURE; // errno is left for the caller's message
+    }
+
+    (*reader)->data = (char *) malloc(INPUT_CHUNK_SIZE);
+    if ((*reader)->data == NULL) {
+        perror("Unable to allocate memory for input buffer.");
+        if (!useStdin) {
+            fclose((*reader)->file);
+        }
+        free(*reader);
+        *reader = NULL;
+        return EXIT_FAILURE;
+    }
+    (*reader)->capacity = INPUT_CHUNK_SIZE;
+
+    return EXIT_SUCCESS;
+}
+
+
+/**
+ * @brief Reads more of the input into the buffer, keeping the unread bytes.
+ *
+ * The unread bytes are moved to the front of the buffer, and the buffer is doubled if
+ * they fill it, so a line always fits no matter how long it is.
+ *
+ * @param reader The buffered reader.
+ * @return size_t The number of bytes read, 0 at the end of the input or if reading fails.
+ */
+static size_t fillInput(InputReader *reader) {
+    size_t remaining = reader->length - reader->position;
+    memmove(reader->data, reader->data + reader->position, remaining);
+    reader->length = remaining;
+    reader->position = 0;
+
+    if (reader->length == reader->capacity) { // a single line fills the buffer
+        char *newPtr = (char *) realloc(reader->data, 2 * reader->capacity);
+        if (newPtr == NULL) {
+            perror("Unable to grow input buffer.");
+            return 0;
+        }
+        reader->data = newPtr;
+        reader->capacity *= 2;
+    }
+
+    size_t n = fread(reader->data + reader->length, 1, reader->capacity - reader->length, reader->file);
+    if (n == 0 && ferror(reader->file)) {
+        perror("Unable to read input.");
+    }
+    reader->length += n;
+    return n;
+}
+
+
+// Return the next line as a span of the input
+bool nextLine(InputReader *reader, const char **line, size_t *length) {
+    while (true) {
+        const char *start = reader->data + reader->position;
+        size_t available = reader->length - reader->position;
+        const char *newline = (available > 0) ? (const char *) memchr(start, '\n', available) : NULL;
+
+        if (newline != NULL) {
+            *line = start;
+            *length = (size_t) (newline - start);
+            reader->position += *length + 1; // skip the newline character
+            return true;
+        }
+
+        if (reader->mapped || fillInput(reader) == 0) { // no more input, the rest is the last line
+            if (reader->position == reader->length) {
+                return false;
+            }
+            *line = reader->data + reader->position;
+            *length = reader->length - reader->position;
+            reader->position = reader->length;
+            return true;
+        }
+    }
+}
+
+
+// Close the input and free the reader
+void closeInputReader(InputReader *reader) {
+    if (reader == NULL) {
+        return;
+    }
+
+    if (reader->mapped) {
+        if (reader->data != NULL) {
+            munmap(reader->data, reader->length);
+        }
+    } else {
+        free(reader->data);
+        if (reader->file != stdin) {
+            fclose(reader->file);
+        }
+    }
+    free(reader);
+}
+
+
+#ifdef DEBUG_IREADER
+
+int main() {
+    // Write a file with a line longer than the read buffer and no final newline
+    const char *fileName = "readerDEBUG.txt";
+    FILE *fp = fopen(fileName, "w");
+    if (fp == NULL) {
+        printf("Unable to create test file.\n");
+        return EXIT_FAILURE;
+    }
+    fprintf(fp, "H2O\n\nCo3(Fe(CN)6)2\n");
+    for (int i = 0; i < 3 * INPUT_CHUNK_SIZE; i++) {
+        fputc('C', fp);
+    }
+    fclose(fp);
+
+    // Read it mapped and through the buffer (as if it were a pipe)
+    for (int pass = 0; pass < 2; pass++) {
+        printf("Testing %s reader...\n", (pass == 0) ? "mapped" : "buffered");
+        InputReader *reader = NULL;
+        if (openInputReader(&reader, fileName) != EXIT_SUCCESS) {
+            printf("Failed to open input reader.\n");
+            return EXIT_FAILURE;
+        }
+        if (pass == 1 && reader->mapped) { // reopen the same file through the fallback
+            munmap(reader->data, reader->length);
+            reader->data = (char *) malloc(INPUT_CHUNK_SIZE);
+            reader->capacity = INPUT_CHUNK_SIZE;
+            reader->length = 0;
+            reader->mapped = false;
+            reader->file = fopen(fileName, "r");
+        }
+
+        const char *line;
+        size_t length;
+        int lines = 0;
+        while (nextLine(reader, &line, &length)) {
+            lines++;
+            printf("Line %d: %zu characters '%.*s'\n", lines, length, (int) (length < 20 ? length : 20), line);
+        }
+        printf("Read %d lines (expected 4, the last with %d characters)\n", lines, 3 * INPUT_CHUNK_SIZE);
+        closeInputReader(reader);
+    }
+
+    remove(fileName);
+    printf("Input reader test completed.\n");
+
+    return 0;
+}
+#endif // DEBUG_IREADER
@@ -0,0 +1,92 @@
+/**
+ * @file inputReader.h
+ * @brief Header file for reading the lines of a formula file without copying them.
+ *
+ * This file contains the definitions and function declarations for an input reader.
+ * Regular files are memory-mapped and their lines are returned as spans of the mapping,
+ * so no byte is copied and lines may be of any length. Pipes and the standard input
+ * can't be mapped, so they are read in large chunks into a buffer that grows when a
+ * line doesn't fit.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs.
+ */
+
+#ifndef INPUTREADER_H
+#define INPUTREADER_H
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define INPUT_CHUNK_SIZE (1 << 16) /**< Number of bytes read at once when the input isn't mapped */
+#define STDIN_NAME "-" /**< File name that selects the standard input */
+
+
+/**
+ * @struct InputReader
+ * @brief A structure representing an open input file and the position of its next line.
+ *
+ * @var InputReader::data
+ * The mapped file, or the buffer holding the bytes read so far.
+ *
+ * @var InputReader::length
+ * The number of valid bytes in data.
+ *
+ * @var InputReader::position
+ * The offset in data where the next line starts.
+ *
+ * @var InputReader::capacity
+ * The size of the buffer (0 for a mapped file).
+ *
+ * @var InputReader::mapped
+ * True if the file is memory-mapped, in which case the returned lines stay valid until
+ * the reader is closed. Otherwise a line is only valid until the next call to `nextLine`.
+ *
+ * @var InputReader::file
+ * The file that is read into the buffer (NULL for a mapped file).
+ */
+typedef struct {
+    char *data; // mapping or read buffer
+    size_t length; // valid bytes in data
+    size_t position; // start of the next line
+    size_t capacity; // size of the read buffer
+    bool mapped; // true if data is a file mapping
+    FILE *file; // source of the read buffer
+} InputReader;
+
+
+/**
+ * @brief Opens a file for reading its lines.
+ *
+ * Regular files are memory-mapped; anything else (or a file that can't be mapped) is
+ * read through a buffer. The name STDIN_NAME reads the standard input.
+ *
+ * @param[in,out] reader A pointer to the pointer of the reader to be opened.
+ * @param[in] inputFile The name of the file to read.
+ * @return int Returns 0 on success, or 1 if the file can't be opened or memory runs out.
+ */
+int openInputReader(InputReader **reader, const char *inputFile);
+
+
+/**
+ * @brief Returns the next line of the input without its newline character.
+ *
+ * The line is not null-terminated. A last line without a newline is returned as well.
+ *
+ * @param[in,out] reader The reader to read from.
+ * @param[out] line Set to the first character of the line.
+ * @param[out] length Set to the number of characters of the line.
+ * @return bool Returns true if a line was read, or false at the end of the input or if
+ *              reading fails.
+ */
+bool nextLine(InputReader *reader, const char **line, size_t *length);
+
+
+/**
+ * @brief Closes the input and frees the reader.
+ *
+ * @param[in] reader The reader to close.
+ */
+void closeInputReader(InputReader *reader);
+
+#endif // INPUTREADER_H
@@ -0,0 +1,293 @@
+/**
+ * @file libformula.c
+ * @brief Implementation of the in-memory library API of the formula engine.
+ *
+ * This source file provides the handles of the library and the calls that run the formula
+ * engine on formulas in memory, turning its failures into status codes.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "libformula.h"
+#include "formulaTokenizer.h"
+#include "outputBuffer.h"
+
+
+/**
+ * @brief Allocates a handle and its workspace, without a periodic table.
+ *
+ * @param handle A pointer to store the allocated handle.
+ * @return FormulaStatus FORMULA_OK or FORMULA_NO_MEMORY.
+ */
+static FormulaStatus allocateHandle(FormulaHandle **handle) {
+    *handle = (FormulaHandle *) malloc(sizeof(FormulaHandle));
+    if (*handle == NULL) {
+        return FORMULA_NO_MEMORY;
+    }
+
+    if (initFormulaWorkspace(&((*handle)->workspace)) != EXIT_SUCCESS) {
+        free(*handle);
+        *handle = NULL;
+        return FORMULA_NO_MEMORY;
+    }
+
+    return FORMULA_OK;
+}
+
+
+/**
+ * @brief Finds why the engine failed on a formula.
+ *
+ * The engine only reports that a formula failed; the causes are checked again here, in
+ * the order the engine runs into them, which only costs time for formulas that failed.
+ *
+ * @param handle The handle the formula was processed with.
+ * @param formula The formula.
+ * @param length The number of characters of the formula.
+ * @param symbols Whether a symbol that is not in the periodic table makes the formula fail.
+ * @return FormulaStatus FORMULA_UNBALANCED, FORMULA_UNKNOWN_SYMBOL or FORMULA_NO_MEMORY.
+ */
+static FormulaStatus failureStatus(const FormulaHandle *handle, const char *formula, size_t length, bool symbols) {
+    if (!balancedParentheses(formula, length)) {
+        return FORMULA_UNBALANCED;
+    }
+
+    if (symbols) {
+        Tokenizer tokens;
+        Token token;
+        initTokenizer(&tokens, formula, length);
+        while (nextToken(&tokens, &token)) {
+            if (token.type == TOKEN_SYMBOL && lookupAtomicNumber(&(handle->index), token.key) < 1) {
+                return FORMULA_UNKNOWN_SYMBOL;
+            }
+        }
+    }
+
+    return FORMULA_NO_MEMORY;
+}
+
+
+/**
+ * @brief Ends the line written to a buffer of the caller with '\0' instead of its newline.
+ *
+ * @param out The fixed output buffer over the memory of the caller.
+ * @param written A pointer to store the length of the line without the '\0' (may be NULL).
+ */
+static void terminateLine(OutputBuffer *out, size_t *written) {
+    out->data[out->length - 1] = '\0'; // the engine ends every line with '\n'
+    if (written != NULL) {
+        *written = out->length - 1;
+    }
+}
+
+
+// Open a handle with the periodic table of a file
+FormulaStatus formula_open(FormulaHandle **handle, const char *tableFile) {
+    if (handle == NULL || tableFile == NULL) {
+        return FORMULA_BAD_ARGUMENT;
+    }
+
+    FormulaStatus status = allocateHandle(handle);
+    if (status != FORMULA_OK) {
+        return status;
+    }
+
+    Element elements[MAX_ELEMENTS];
+    bool indexed;
+    loadPeriodicTableIndex(tableFile, elements, &((*handle)->index), &indexed); // straight into the handle, no shared index
+    if (!indexed) {
+        formula_close(*handle);
+        *handle = NULL;
+        return FORMULA_BAD_TABLE;
+    }
+
+    return FORMULA_OK;
+}
+
+
+// Open a handle with a periodic table in memory
+FormulaStatus formula_open_table(FormulaHandle **handle, const Element elements[], int numElements) {
+    if (handle == NULL || (elements == NULL && numElements > 0)) {
+        return FORMULA_BAD_ARGUMENT;
+    }
+    if (numElements < 0 || numElements > MAX_ELEMENTS) {
+        return FORMULA_BAD_TABLE;
+    }
+
+    FormulaStatus status = allocateHandle(handle);
+    if (status != FORMULA_OK) {
+        return status;
+    }
+
+    buildSymbolIndex(&((*handle)->index), elements, numElements);
+    return FORMULA_OK;
+}
+
+
+// Close a handle
+void formula_close(FormulaHandle *handle) {
+    if (handle == NULL) {
+        return;
+    }
+
+    freeFormulaWorkspace(&(handle->workspace));
+    free(handle);
+}
+
+
+// Check the parentheses of a formula
+FormulaStatus formula_validate(const char *formula, size_t length) {
+    if (formula == NULL && length > 0) {
+        return FORMULA_BAD_ARGUMENT;
+    }
+
+    return balancedParentheses(formula, length) ? FORMULA_OK : FORMULA_UNBALANCED;
+}
+
+
+// Calculate the total protons of a formula
+FormulaStatus formula_protons(FormulaHandle *handle, const char *formula, size_t length, long long *total) {
+    if (handle == NULL || total == NULL || (formula == NULL && length > 0)) {
+        return FORMULA_BAD_ARGUMENT;
+    }
+
+    if (formulaProtons(formula, length, &(handle->index), &(handle->workspace), total) != EXIT_SUCCESS) {
+        return failureStatus(handle, formula, length, false);
+    }
+
+    return FORMULA_OK;
+}
+
+
+// Expand a formula into a buffer of the caller
+FormulaStatus formula_expand_into(FormulaHandle *handle, const char *formula, size_t length, char *buffer, size_t capacity, size_t *written) {
+    if (handle == NULL || (buffer == NULL && capacity > 0) || (formula == NULL && length > 0)) {
+        return FORMULA_BAD_ARGUMENT;
+    }
+
+    OutputBuffer out;
+    initFixedOutputBuffer(&out, buffer, capacity);
+    if (expandFormula(formula, length, &out, &(handle->workspace)) != EXIT_SUCCESS) {
+        return out.overflowed ? FORMULA_NO_SPACE : failureStatus(handle, formula, length, false);
+    }
+
+    terminateLine(&out, written);
+    return FORMULA_OK;
+}
+
+
+// Count the atoms of each element of a formula
+FormulaStatus formula_counts(FormulaHandle *handle, const char *formula, size_t length, AtomCounts *atoms) {
+    if (handle == NULL || atoms == NULL || (formula == NULL && length > 0)) {
+        return FORMULA_BAD_ARGUMENT;
+    }
+
+    if (formulaHistogram(formula, length, &(handle->index), &(handle->workspace), atoms) != EXIT_SUCCESS) {
+        return failureStatus(handle, formula, length, true);
+    }
+
+    return FORMULA_OK;
+}
+
+
+// Write the atom counts of a formula into a buffer of the caller
+FormulaStatus formula_counts_into(FormulaHandle *handle, const char *formula, size_t length, char *buffer, size_t capacity, size_t *written) {
+    if (buffer == NULL && capacity > 0) {
+        return FORMULA_BAD_ARGUMENT;
+    }
+
+    AtomCounts atoms;
+    FormulaStatus status = formula_counts(handle, formula, length, &atoms);
+    if (status != FORMULA_OK) {
+        return status;
+    }
+
+    OutputBuffer out;
+    initFixedOutputBuffer(&out, buffer, capacity);
+    if (writeHistogram(&atoms, &(handle->index), &out) != EXIT_SUCCESS) {
+        return FORMULA_NO_SPACE; // nothing else can fail when writing to memory
+    }
+
+    terminateLine(&out, written);
+    return FORMULA_OK;
+}
+
+
+// Describe a status
+const char *formula_error(FormulaStatus status) {
+    switch (status) {
+        case FORMULA_OK:
+            return "Success";
+        case FORMULA_UNBALANCED:
+            return "Parentheses NOT balanced";
+        case FORMULA_UNKNOWN_SYMBOL:
+            return "Symbol not in the periodic table";
+        case FORMULA_NO_SPACE:
+            return "Result doesn't fit in the buffer";
+        case FORMULA_NO_MEMORY:
+            return "Out of memory";
+        case FORMULA_BAD_TABLE:
+            return "Periodic table could not be loaded";
+        case FORMULA_BAD_ARGUMENT:
+            return "Invalid argument";
+    }
+    return "Unknown status";
+}
+
+
+#ifdef DEBUG_LIBFORMULA
+#include <time.h>
+
+int main() {
+    FormulaHandle *handle = NULL;
+    FormulaStatus status = formula_open(&handle, "periodicTable.txt");
+    if (status != FORMULA_OK) {
+        printf("Failed to open handle: %s\n", formula_error(status));
+        return EXIT_FAILURE;
+    }
+
+    // Results of all three modes for a single formula
+    const char *formula = "Co3(Fe(CN)6)2";
+    size_t length = strlen(formula);
+    long long total = 0;
+    char buffer[256];
+    size_t written = 0;
+
+    formula_protons(handle, formula, length, &total);
+    printf("Protons of %s: %lld (expected 289)\n", formula, total);
+    formula_expand_into(handle, formula, length, buffer, sizeof(buffer), &written);
+    printf("Expanded (%zu characters): %s\n", written, buffer);
+    formula_counts_into(handle, formula, length, buffer, sizeof(buffer), &written);
+    printf("Counts: %s (expected C:12 N:12 Fe:2 Co:3)\n", buffer);
+
+    // A formula doesn't need to be null-terminated: the first 3 characters of "H2O2" are "H2O"
+    formula_protons(handle, "H2O2", 3, &total);
+    printf("Protons of the first 3 characters of H2O2: %lld (expected 10)\n", total);
+
+    // Errors are returned, nothing exits
+    printf("Unbalanced: %s\n", formula_error(formula_protons(handle, "(H2O", 4, &total)));
+    printf("Unknown symbol: %s\n", formula_error(formula_counts_into(handle, "XyH2", 4, buffer, sizeof(buffer), &written)));
+    printf("Buffer too small: %s\n", formula_error(formula_expand_into(handle, "H2O", 3, buffer, 5, &written)));
+    status = formula_expand_into(handle, "H2O", 3, buffer, 6, &written);
+    printf("Buffer just large enough: %s, '%s'\n", formula_error(status), buffer);
+    printf("Huge expansion: %s\n", formula_error(formula_expand_into(handle, "(H99999)99999", 13, buffer, sizeof(buffer), &written)));
+    FormulaHandle *missing = NULL;
+    printf("Missing table: %s\n", formula_error(formula_open(&missing, "missingTable.txt")));
+
+    // Time of a call
+    int calls = 1000000;
+    clock_t start = clock();
+    for (int i = 0; i < calls; i++) {
+        formula_protons(handle, formula, length, &total);
+    }
+    double seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+    printf("formula_protons: %.3f us per call\n", 1e6 * seconds / calls);
+
+    formula_close(handle);
+    return 0;
+}
+#endif // DEBUG_LIBFORMULA
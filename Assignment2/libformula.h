@@ -0,0 +1,167 @@
+/**
+ * @file libformula.h
+ * @brief Header file for the in-memory library API of the formula engine.
+ *
+ * This file contains the definitions and function declarations of `libformula`, which lets
+ * other programs use the formula engine without files or a process per request. A handle
+ * holds the symbol index of a periodic table, loaded once, and the memory that the engine
+ * reuses from one formula to the next. Every call works on a formula in memory (which doesn't
+ * need to be null-terminated), writes its result to memory of the caller and reports
+ * failures with a `FormulaStatus` instead of exiting.
+ *
+ * The library keeps no global state, so any number of handles can be used at the same time.
+ * A single handle must not be used by two threads at once; every thread opens its own.
+ * `make lib` builds the library as `libformula.a`.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs.
+ */
+
+#ifndef LIBFORMULA_H
+#define LIBFORMULA_H
+#include <stddef.h>
+#include "periodicTable.h"
+#include "formulaExpander.h"
+
+
+/**
+ * @enum FormulaStatus
+ * @brief Enum to specify the result of a library call.
+ */
+typedef enum {
+    FORMULA_OK, /**< The call succeeded */
+    FORMULA_UNBALANCED, /**< The parentheses of the formula are not balanced */
+    FORMULA_UNKNOWN_SYMBOL, /**< A symbol of the formula is not in the periodic table */
+    FORMULA_NO_SPACE, /**< The result doesn't fit in the buffer of the caller */
+    FORMULA_NO_MEMORY, /**< Memory allocation failed */
+    FORMULA_BAD_TABLE, /**< The periodic table could not be loaded */
+    FORMULA_BAD_ARGUMENT /**< A required pointer is NULL */
+} FormulaStatus;
+
+
+/**
+ * @struct FormulaHandle
+ * @brief A loaded periodic table together with the reusable memory of the engine.
+ *
+ * @var FormulaHandle::index
+ * The symbol index of the periodic table.
+ *
+ * @var FormulaHandle::workspace
+ * The memory reused by the engine from one formula to the next.
+ */
+typedef struct {
+    SymbolIndex index; // symbol index of the periodic table
+    FormulaWorkspace workspace; // memory reused between formulas
+} FormulaHandle;
+
+
+/**
+ * @brief Opens a handle with the periodic table of a text file or an image.
+ *
+ * @param[out] handle A pointer to store the opened handle.
+ * @param[in] tableFile The periodic table file, or an image written by `-img`.
+ * @return FormulaStatus FORMULA_OK, FORMULA_BAD_TABLE if the file can't be loaded, or FORMULA_NO_MEMORY.
+ */
+FormulaStatus formula_open(FormulaHandle **handle, const char *tableFile);
+
+
+/**
+ * @brief Opens a handle with a periodic table that is already in memory.
+ *
+ * @param[out] handle A pointer to store the opened handle.
+ * @param[in] elements The elements of the periodic table (not used after the call).
+ * @param[in] numElements The number of elements.
+ * @return FormulaStatus FORMULA_OK, FORMULA_BAD_TABLE if the number of elements is invalid, or FORMULA_NO_MEMORY.
+ */
+FormulaStatus formula_open_table(FormulaHandle **handle, const Element elements[], int numElements);
+
+
+/**
+ * @brief Closes a handle and frees its memory.
+ *
+ * @param[in] handle The handle to close (may be NULL).
+ */
+void formula_close(FormulaHandle *handle);
+
+
+/**
+ * @brief Checks that the parentheses of a formula are balanced.
+ *
+ * @param[in] formula The formula.
+ * @param[in] length The number of characters of the formula.
+ * @return FormulaStatus FORMULA_OK or FORMULA_UNBALANCED.
+ */
+FormulaStatus formula_validate(const char *formula, size_t length);
+
+
+/**
+ * @brief Calculates the total protons of a formula without expanding it.
+ *
+ * The total is the one written by the `-pn` mode, so a symbol that is not in the periodic
+ * table counts as -1 like there; `formula_counts` rejects such formulas instead.
+ *
+ * @param[in,out] handle The handle.
+ * @param[in] formula The formula.
+ * @param[in] length The number of characters of the formula.
+ * @param[out] total A pointer to store the total protons.
+ * @return FormulaStatus FORMULA_OK, FORMULA_UNBALANCED or FORMULA_NO_MEMORY.
+ */
+FormulaStatus formula_protons(FormulaHandle *handle, const char *formula, size_t length, long long *total);
+
+
+/**
+ * @brief Expands a formula into a buffer of the caller.
+ *
+ * The expansion is the line written by the `-ext` mode, without its newline and with a
+ * terminating '\0', so the buffer needs one byte more than the expanded formula. Repeated
+ * groups are copied inside the buffer, and nothing else is allocated for the output.
+ *
+ * @param[in,out] handle The handle.
+ * @param[in] formula The formula.
+ * @param[in] length The number of characters of the formula.
+ * @param[out] buffer The buffer to write the expansion to (its contents are undefined on failure).
+ * @param[in] capacity The number of bytes of the buffer.
+ * @param[out] written A pointer to store the length of the expansion, without the '\0' (may be NULL).
+ * @return FormulaStatus FORMULA_OK, FORMULA_UNBALANCED, FORMULA_NO_SPACE or FORMULA_NO_MEMORY.
+ */
+FormulaStatus formula_expand_into(FormulaHandle *handle, const char *formula, size_t length, char *buffer, size_t capacity, size_t *written);
+
+
+/**
+ * @brief Counts the atoms of each element of a formula without expanding it.
+ *
+ * @param[in,out] handle The handle.
+ * @param[in] formula The formula.
+ * @param[in] length The number of characters of the formula.
+ * @param[out] atoms The counts of the formula's atoms, by atomic number.
+ * @return FormulaStatus FORMULA_OK, FORMULA_UNBALANCED, FORMULA_UNKNOWN_SYMBOL or FORMULA_NO_MEMORY.
+ */
+FormulaStatus formula_counts(FormulaHandle *handle, const char *formula, size_t length, AtomCounts *atoms);
+
+
+/**
+ * @brief Writes the atom counts of a formula into a buffer of the caller.
+ *
+ * The counts are the `Symbol:count` pairs of the `-hist` mode, without the newline and with
+ * a terminating '\0'.
+ *
+ * @param[in,out] handle The handle.
+ * @param[in] formula The formula.
+ * @param[in] length The number of characters of the formula.
+ * @param[out] buffer The buffer to write the counts to (its contents are undefined on failure).
+ * @param[in] capacity The number of bytes of the buffer.
+ * @param[out] written A pointer to store the length of the counts, without the '\0' (may be NULL).
+ * @return FormulaStatus FORMULA_OK, FORMULA_UNBALANCED, FORMULA_UNKNOWN_SYMBOL, FORMULA_NO_SPACE or FORMULA_NO_MEMORY.
+ */
+FormulaStatus formula_counts_into(FormulaHandle *handle, const char *formula, size_t length, char *buffer, size_t capacity, size_t *written);
+
+
+/**
+ * @brief Describes a status.
+ *
+ * @param[in] status The status returned by a library call.
+ * @return const char* A constant message for the status.
+ */
+const char *formula_error(FormulaStatus status);
+
+#endif // LIBFORMULA_H
@@ -0,0 +1,436 @@
+/**
+ * @file outputBuffer.c
+ * @brief Implementation of the buffered output sink.
+ *
+ * This source file provides the implementations of the functions for managing an output
+ * buffer. Functions include initialization, appending bytes, repeating an already written
+ * span, flushing to the buffer's file and freeing the buffer.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "outputBuffer.h"
+
+
+// Initialize the output buffer
+int initOutputBuffer(OutputBuffer **buffer, FILE *file, size_t capacity) {
+    *buffer = (OutputBuffer *) malloc(sizeof(OutputBuffer));
+    if (*buffer == NULL) {
+        perror("Unable to allocate memory for output buffer initialization.");
+        return EXIT_FAILURE;
+    }
+
+    if (capacity == 0) {
+        capacity = 1;
+    }
+
+    (*buffer)->data = (char *) malloc(capacity);
+    if ((*buffer)->data == NULL) {
+        perror("Unable to allocate memory for output buffer data.");
+        free(*buffer);
+        *buffer = NULL;
+        return EXIT_FAILURE;
+    }
+
+    (*buffer)->length = 0;
+    (*buffer)->capacity = capacity;
+    (*buffer)->file = file;
+    (*buffer)->flushes = 0;
+    (*buffer)->fixed = false;
+    (*buffer)->overflowed = false;
+    (*buffer)->spillLimit = 0;
+    (*buffer)->spill = NULL;
+
+    return EXIT_SUCCESS;
+}
+
+
+// Initialize an output buffer that writes to memory of the caller without growing
+void initFixedOutputBuffer(OutputBuffer *buffer, char *data, size_t capacity) {
+    buffer->data = data;
+    buffer->length = 0;
+    buffer->capacity = capacity;
+    buffer->file = NULL;
+    buffer->flushes = 0;
+    buffer->fixed = true;
+    buffer->overflowed = false;
+    buffer->spillLimit = 0;
+    buffer->spill = NULL;
+}
+
+
+// Set the in-memory bytes of a buffer before it spills to a temporary file
+void setOutputSpillLimit(OutputBuffer *buffer, size_t limit) {
+    buffer->spillLimit = limit;
+}
+
+
+/**
+ * @brief Writes the first n buffered bytes to the file of the buffer.
+ *
+ * The remaining bytes are not moved; the caller decides what stays in the buffer.
+ *
+ * @param buffer The buffer to write from.
+ * @param n The number of bytes to write.
+ * @return int Returns 0 on success, or 1 if writing fails.
+ */
+static int writeOutput(OutputBuffer *buffer, size_t n) {
+    (buffer->flushes)++; // offsets recorded before this point are no longer valid
+    if (n > 0 && fwrite(buffer->data, 1, n, buffer->file) != n) {
+        perror("Unable to write output.");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+
+/**
+ * @brief Grows an in-memory buffer so that it can hold at least `needed` bytes.
+ *
+ * @param buffer The buffer to grow.
+ * @param needed The minimum capacity.
+ * @return int Returns 0 on success, or 1 if memory allocation fails or the buffer is fixed.
+ */
+static int growOutput(OutputBuffer *buffer, size_t needed) {
+    if (buffer->fixed && needed > buffer->capacity) { // memory of the caller, the output doesn't fit
+        buffer->overflowed = true;
+        return EXIT_FAILURE;
+    } else if (buffer->fixed) {
+        return EXIT_SUCCESS;
+    }
+
+    size_t newCapacity = buffer->capacity;
+    while (newCapacity < needed) {
+        newCapacity *= 2;
+    }
+
+    char *newPtr = (char *) realloc(buffer->data, newCapacity); // temp pointer so we don't lose the data
+    if (newPtr == NULL) {
+        perror("Unable to grow output buffer.");
+        return EXIT_FAILURE;
+    }
+
+    buffer->data = newPtr;
+    buffer->capacity = newCapacity;
+    return EXIT_SUCCESS;
+}
+
+
+/**
+ * @brief Moves the output of an in-memory buffer to a temporary file if it would grow past its spill limit.
+ *
+ * Nothing is written yet: the buffer only becomes a file buffer of the temporary file, so
+ * the buffered bytes and the offsets into them stay valid until the next flush.
+ *
+ * @param buffer The buffer.
+ * @param needed The number of bytes the buffer would have to hold.
+ * @return int Returns 0 on success (spilled or not), or 1 if the temporary file can't be created.
+ */
+static int spillOutput(OutputBuffer *buffer, size_t needed) {
+    if (buffer->file != NULL || buffer->spillLimit == 0 || needed <= buffer->spillLimit) {
+        return EXIT_SUCCESS;
+    }
+
+    buffer->spill = tmpfile();
+    if (buffer->spill == NULL) {
+        perror("Unable to create temporary file for output.");
+        return EXIT_FAILURE;
+    }
+    buffer->file = buffer->spill;
+    return EXIT_SUCCESS;
+}
+
+
+// Append bytes to the buffer
+int appendOutput(OutputBuffer *buffer, const char *bytes, size_t n) {
+    if (buffer->length + n > buffer->capacity) {
+        if (spillOutput(buffer, buffer->length + n) != EXIT_SUCCESS) {
+            return EXIT_FAILURE;
+        }
+        if (buffer->file == NULL) { // in-memory output, make space
+            if (growOutput(buffer, buffer->length + n) != EXIT_SUCCESS) {
+                return EXIT_FAILURE;
+            }
+        } else {
+            if (flushOutputBuffer(buffer) != EXIT_SUCCESS) {
+                return EXIT_FAILURE;
+            }
+            if (n > buffer->capacity) { // too large to be buffered, write it directly
+                (buffer->flushes)++;
+                if (fwrite(bytes, 1, n, buffer->file) != n) {
+                    perror("Unable to write output.");
+                    return EXIT_FAILURE;
+                }
+                return EXIT_SUCCESS;
+            }
+        }
+    }
+
+    memcpy(buffer->data + buffer->length, bytes, n);
+    buffer->length += n;
+    return EXIT_SUCCESS;
+}
+
+
+// Append a single byte to the buffer
+int appendOutputChar(OutputBuffer *buffer, char c) {
+    if (buffer->length == buffer->capacity) {
+        return appendOutput(buffer, &c, 1);
+    }
+
+    buffer->data[(buffer->length)++] = c;
+    return EXIT_SUCCESS;
+}
+
+
+// Check if the span starting at spanStart is still in the buffer and small enough to be repeated
+bool canRepeatOutput(OutputBuffer *buffer, size_t spanStart, unsigned long flushes, size_t prefixLen) {
+    if (buffer->flushes != flushes || spanStart > buffer->length) {
+        return false; // span was (partly) written out
+    }
+
+    if (buffer->file == NULL) {
+        return true; // in-memory buffers keep everything
+    }
+
+    size_t unitLen = prefixLen + (buffer->length - spanStart);
+    return (unitLen <= buffer->capacity / 2); // a copy must fit next to the span
+}
+
+
+// Repeat the span at the end of the buffer count more times
+int repeatOutput(OutputBuffer *buffer, size_t spanStart, const char *prefix, size_t prefixLen, long long count) {
+    size_t spanLen = buffer->length - spanStart;
+    size_t unitLen = prefixLen + spanLen;
+    if (count <= 0 || unitLen == 0) {
+        return EXIT_SUCCESS;
+    }
+
+    // Output that would grow past the spill limit continues in a temporary file, with room for a copy next to the span
+    bool tooLarge = ((unsigned long long) count > ((size_t) -1 - buffer->length) / unitLen);
+    if (spillOutput(buffer, tooLarge ? (size_t) -1 : buffer->length + (size_t) count * unitLen) != EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+    if (buffer->spill != NULL && unitLen > buffer->capacity / 2 && growOutput(buffer, 2 * unitLen) != EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+    // In-memory output needs all the copies, make space for them at once
+    if (buffer->file == NULL && tooLarge) {
+        if (buffer->fixed) {
+            buffer->overflowed = true;
+            return EXIT_FAILURE;
+        }
+        fprintf(stderr, "Error: expanded output is too large to be kept in memory.\n");
+        return EXIT_FAILURE;
+    }
+    if (buffer->file == NULL && growOutput(buffer, buffer->length + (size_t) count * unitLen) != EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+    // Build the first copy (prefix + span) so that whole copies end the buffer
+    if (prefixLen > 0) {
+        if (buffer->length + unitLen > buffer->capacity) { // file buffer, write out what comes before the span
+            if (writeOutput(buffer, spanStart) != EXIT_SUCCESS) {
+                return EXIT_FAILURE;
+            }
+            memmove(buffer->data, buffer->data + spanStart, spanLen);
+            buffer->length = spanLen;
+            spanStart = 0;
+        }
+        memcpy(buffer->data + buffer->length, prefix, prefixLen);
+        memcpy(buffer->data + buffer->length + prefixLen, buffer->data + spanStart, spanLen);
+        buffer->length += unitLen;
+        count--;
+    }
+
+    long long copies = 1; // whole copies that end the buffer
+    while (count > 0) {
+        if (buffer->length + unitLen > buffer->capacity) { // file buffer is full, keep only the last copy
+            if (writeOutput(buffer, buffer->length - unitLen) != EXIT_SUCCESS) {
+                return EXIT_FAILURE;
+            }
+            memmove(buffer->data, buffer->data + buffer->length - unitLen, unitLen);
+            buffer->length = unitLen;
+            copies = 1;
+        }
+
+        // Double the copied block as long as it fits
+        long long n = (long long) ((buffer->capacity - buffer->length) / unitLen);
+        if (n > copies) {
+            n = copies;
+        }
+        if (n > count) {
+            n = count;
+        }
+
+        size_t blockLen = (size_t) n * unitLen;
+        memcpy(buffer->data + buffer->length, buffer->data + buffer->length - blockLen, blockLen);
+        buffer->length += blockLen;
+        copies += n;
+        count -= n;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+
+// Write all buffered bytes to the file
+int flushOutputBuffer(OutputBuffer *buffer) {
+    if (buffer->file == NULL) {
+        return EXIT_SUCCESS; // output stays in memory
+    }
+
+    int status = writeOutput(buffer, buffer->length);
+    buffer->length = 0;
+    return status;
+}
+
+
+// Write the spilled and the buffered bytes of an in-memory buffer to a file
+int copyOutputBuffer(OutputBuffer *buffer, FILE *file, size_t *written) {
+    *written = 0;
+    if (buffer->spill != NULL) { // spilled bytes come first
+        char chunk[1 << 16];
+        size_t n;
+        if (fflush(buffer->spill) != 0 || fseek(buffer->spill, 0, SEEK_SET) != 0) {
+            perror("Unable to read spilled output.");
+            return EXIT_FAILURE;
+        }
+        while ((n = fread(chunk, 1, sizeof(chunk), buffer->spill)) > 0) {
+            if (fwrite(chunk, 1, n, file) != n) {
+                perror("Unable to write output.");
+                return EXIT_FAILURE;
+            }
+            *written += n;
+        }
+        if (ferror(buffer->spill) || fseek(buffer->spill, 0, SEEK_END) != 0) {
+            perror("Unable to read spilled output.");
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (fwrite(buffer->data, 1, buffer->length, file) != buffer->length) {
+        perror("Unable to write output.");
+        return EXIT_FAILURE;
+    }
+    *written += buffer->length;
+    return EXIT_SUCCESS;
+}
+
+
+// Discard the buffered bytes
+void clearOutputBuffer(OutputBuffer *buffer) {
+    buffer->length = 0;
+    (buffer->flushes)++; // recorded offsets no longer refer to the same bytes
+    if (buffer->spill != NULL) { // back to memory
+        fclose(buffer->spill);
+        buffer->spill = NULL;
+        buffer->file = NULL;
+    }
+}
+
+
+// Free the buffer
+void freeOutputBuffer(OutputBuffer *buffer) {
+    if (buffer == NULL) {
+        return;
+    }
+
+    if (buffer->spill != NULL) {
+        fclose(buffer->spill);
+    }
+    free(buffer->data);
+    free(buffer);
+}
+
+
+#ifdef DEBUG_OBUFFER
+
+int main() {
+    OutputBuffer *buffer = NULL;
+
+    // Test in-memory buffer growing and repeating
+    printf("Testing in-memory output buffer...\n");
+    if (initOutputBuffer(&buffer, NULL, 4) != EXIT_SUCCESS) {
+        printf("Failed to initialize output buffer.\n");
+        return EXIT_FAILURE;
+    }
+
+    appendOutput(buffer, "C N", 3);
+    repeatOutput(buffer, 0, " ", 1, 2);
+    appendOutputChar(buffer, '\0');
+    printf("Repeated span: '%s' (expected 'C N C N C N')\n", buffer->data);
+    freeOutputBuffer(buffer);
+
+    // Test file buffer that is smaller than the repeated output
+    printf("Testing file output buffer...\n");
+    FILE *fp = tmpfile();
+    if (fp == NULL || initOutputBuffer(&buffer, fp, 16) != EXIT_SUCCESS) {
+        printf("Failed to initialize file output buffer.\n");
+        return EXIT_FAILURE;
+    }
+
+    appendOutput(buffer, "Fe O", 4);
+    unsigned long flushes = buffer->flushes;
+    size_t spanStart = buffer->length;
+    appendOutput(buffer, " Hs", 3);
+    if (canRepeatOutput(buffer, spanStart, flushes, 0)) {
+        repeatOutput(buffer, spanStart, "", 0, 9);
+    }
+    flushOutputBuffer(buffer);
+
+    char written[64] = "";
+    rewind(fp);
+    size_t n = fread(written, 1, sizeof(written) - 1, fp);
+    written[n] = '\0';
+    printf("Written: '%s' (%zu bytes, expected 34)\n", written, n);
+
+    freeOutputBuffer(buffer);
+    fclose(fp);
+
+    // Test in-memory buffer that spills to a temporary file past its limit
+    printf("Testing spilled output buffer...\n");
+    if (initOutputBuffer(&buffer, NULL, 4) != EXIT_SUCCESS) {
+        printf("Failed to initialize output buffer.\n");
+        return EXIT_FAILURE;
+    }
+    setOutputSpillLimit(buffer, 8);
+    appendOutput(buffer, "Na Cl", 5);
+    repeatOutput(buffer, 0, " ", 1, 3); // 23 bytes, past the limit
+    appendOutputChar(buffer, '\n');
+    FILE *copy = tmpfile();
+    size_t copied = 0;
+    if (copy != NULL && copyOutputBuffer(buffer, copy, &copied) == EXIT_SUCCESS) {
+        rewind(copy);
+        n = fread(written, 1, sizeof(written) - 1, copy);
+        written[n] = '\0';
+        printf("Spilled %d, copied '%.*s' (%zu bytes, expected 1, 'Na Cl Na Cl Na Cl Na Cl', 24)\n", buffer->spill != NULL,
+               (int) n - 1, written, copied);
+    }
+    clearOutputBuffer(buffer);
+    printf("Back in memory after clear: %d (expected 1)\n", buffer->spill == NULL && buffer->file == NULL);
+    freeOutputBuffer(buffer);
+    if (copy != NULL) {
+        fclose(copy);
+    }
+
+    // Test fixed buffer over memory of the caller
+    printf("Testing fixed output buffer...\n");
+    char memory[8];
+    OutputBuffer fixed;
+    initFixedOutputBuffer(&fixed, memory, sizeof(memory));
+    appendOutput(&fixed, "H O", 3);
+    int fitted = repeatOutput(&fixed, 0, " ", 1, 1); // 7 bytes fit
+    int overflowed = repeatOutput(&fixed, 0, " ", 1, 1); // 11 bytes don't
+    printf("Fixed: '%.*s', results %d %d, overflowed %d (expected 'H O H O', 0 1 1)\n", (int) fixed.length, memory,
+           fitted, overflowed, fixed.overflowed);
+    printf("Output buffer test completed.\n");
+
+    return 0;
+}
+#endif // DEBUG_OBUFFER
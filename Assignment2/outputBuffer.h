@@ -0,0 +1,208 @@
+/**
+ * @file outputBuffer.h
+ * @brief Header file for a buffered output sink that can repeat already written spans.
+ *
+ * This file contains the definitions and function declarations for an output buffer.
+ * Bytes are collected in a buffer and either written to a file with a single large
+ * `fwrite` when the buffer fills up, or kept in memory with the buffer growing as needed.
+ * A buffer can also be laid over memory of the caller, in which case it never grows and
+ * an append that doesn't fit fails. An in-memory buffer can be given a spill limit: once
+ * its output would grow past the limit, the output moves to a temporary file and the
+ * buffer keeps working like a file buffer, so a huge output doesn't have to fit in memory.
+ *
+ * The buffer can also repeat the bytes written since a given offset, which lets the
+ * formula expander emit a group once and then copy it instead of expanding it again.
+ *
+ * @author  Panagiotis Tsembekis
+ * @bug     No known bugs.
+ */
+
+#ifndef OUTPUTBUFFER_H
+#define OUTPUTBUFFER_H
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define OUTPUT_BUFFER_SIZE (1 << 20) /**< Default capacity of a file output buffer (1 MB) */
+
+
+/**
+ * @struct OutputBuffer
+ * @brief A structure representing a buffered output sink.
+ *
+ * @var OutputBuffer::data
+ * The buffered bytes.
+ *
+ * @var OutputBuffer::length
+ * The number of bytes currently in the buffer.
+ *
+ * @var OutputBuffer::capacity
+ * The size of the data array.
+ *
+ * @var OutputBuffer::file
+ * The file that the buffer is flushed to, or NULL if the output is kept in memory.
+ *
+ * @var OutputBuffer::flushes
+ * The number of times bytes were written out of the buffer. An offset recorded
+ * before a flush no longer refers to the same bytes.
+ *
+ * @var OutputBuffer::fixed
+ * Whether the data belongs to the caller and the buffer never grows.
+ *
+ * @var OutputBuffer::overflowed
+ * Whether an append to a fixed buffer failed because it didn't fit.
+ *
+ * @var OutputBuffer::spillLimit
+ * The number of bytes an in-memory buffer grows to before its output moves to a temporary
+ * file, or 0 if it always grows.
+ *
+ * @var OutputBuffer::spill
+ * The temporary file that the output moved to (also `file` from then on), or NULL.
+ */
+typedef struct {
+    char *data; // buffered bytes
+    size_t length; // bytes in buffer
+    size_t capacity; // size of data
+    FILE *file; // destination of flushes (NULL = grow in memory)
+    unsigned long flushes; // number of writes to file so far
+    bool fixed; // data of the caller, never grows
+    bool overflowed; // an append didn't fit in the fixed data
+    size_t spillLimit; // in-memory bytes before spilling to a temporary file (0 = never)
+    FILE *spill; // temporary file of a spilled buffer (NULL = not spilled)
+} OutputBuffer;
+
+
+/**
+ * @brief Initializes an output buffer.
+ *
+ * @param[in,out] buffer A pointer to the pointer of the buffer to be initialized.
+ * @param[in] file The file to flush the buffer to, or NULL to keep the whole output in memory.
+ * @param[in] capacity The size of the buffer (initial size if the output is kept in memory).
+ * @return int Returns 0 if initialization is successful, or 1 if memory allocation fails.
+ */
+int initOutputBuffer(OutputBuffer **buffer, FILE *file, size_t capacity);
+
+
+/**
+ * @brief Initializes an in-memory output buffer over memory of the caller.
+ *
+ * The buffer is not allocated, never grows and must not be freed with `freeOutputBuffer`.
+ * Appends that don't fit fail silently and set `overflowed`.
+ *
+ * @param[out] buffer The buffer to initialize.
+ * @param[in] data The memory that the output is written to.
+ * @param[in] capacity The number of bytes of data.
+ */
+void initFixedOutputBuffer(OutputBuffer *buffer, char *data, size_t capacity);
+
+
+/**
+ * @brief Sets the number of bytes an in-memory buffer holds before it spills to a temporary file.
+ *
+ * Offsets recorded before the spill stay valid until the next flush, like for file buffers.
+ *
+ * @param[in,out] buffer The in-memory buffer.
+ * @param[in] limit The spill limit in bytes, or 0 to always grow in memory.
+ */
+void setOutputSpillLimit(OutputBuffer *buffer, size_t limit);
+
+
+/**
+ * @brief Appends bytes to the output buffer, flushing or growing it if needed.
+ *
+ * @param[in,out] buffer The buffer to append to.
+ * @param[in] bytes The bytes to append.
+ * @param[in] n The number of bytes to append.
+ * @return int Returns 0 on success, or 1 if writing or memory allocation fails.
+ */
+int appendOutput(OutputBuffer *buffer, const char *bytes, size_t n);
+
+
+/**
+ * @brief Appends a single byte to the output buffer.
+ *
+ * @param[in,out] buffer The buffer to append to.
+ * @param[in] c The byte to append.
+ * @return int Returns 0 on success, or 1 if writing or memory allocation fails.
+ */
+int appendOutputChar(OutputBuffer *buffer, char c);
+
+
+/**
+ * @brief Checks if a span that started at a given number of flushes can still be repeated.
+ *
+ * A span can be repeated if no flush happened since it started and, for file buffers,
+ * if two copies of it (plus a prefix) fit in the buffer.
+ *
+ * @param[in] buffer The buffer to check.
+ * @param[in] spanStart The offset where the span starts.
+ * @param[in] flushes The value of `flushes` when the span started.
+ * @param[in] prefixLen The length of the prefix that will be repeated with the span.
+ * @return bool Returns true if `repeatOutput` can be used for the span.
+ */
+bool canRepeatOutput(OutputBuffer *buffer, size_t spanStart, unsigned long flushes, size_t prefixLen);
+
+
+/**
+ * @brief Repeats the bytes from an offset up to the end of the buffer.
+ *
+ * The span from `spanStart` to the current end is appended `count` more times, each
+ * copy preceded by the given prefix. Large counts are handled by doubling the copied
+ * block, and when the buffer fills up everything except the last copy is flushed, so
+ * the span is never expanded again. The span must be repeatable (see `canRepeatOutput`).
+ *
+ * @param[in,out] buffer The buffer to repeat the span in.
+ * @param[in] spanStart The offset where the span starts.
+ * @param[in] prefix Bytes written before each copy of the span.
+ * @param[in] prefixLen The number of bytes of the prefix.
+ * @param[in] count The number of copies to append.
+ * @return int Returns 0 on success, or 1 if writing or memory allocation fails.
+ */
+int repeatOutput(OutputBuffer *buffer, size_t spanStart, const char *prefix, size_t prefixLen, long long count);
+
+
+/**
+ * @brief Writes all buffered bytes to the buffer's file.
+ *
+ * Buffers that keep their output in memory are left unchanged.
+ *
+ * @param[in,out] buffer The buffer to flush.
+ * @return int Returns 0 on success, or 1 if writing fails.
+ */
+int flushOutputBuffer(OutputBuffer *buffer);
+
+
+/**
+ * @brief Writes the whole output of an in-memory buffer to a file.
+ *
+ * The bytes that spilled to the temporary file are copied first, then the buffered bytes.
+ * The buffer itself is left unchanged.
+ *
+ * @param[in] buffer The in-memory buffer, which may have spilled.
+ * @param[in] file The file to write to.
+ * @param[out] written A pointer to store the number of bytes written.
+ * @return int Returns 0 on success, or 1 if reading the spill or writing fails.
+ */
+int copyOutputBuffer(OutputBuffer *buffer, FILE *file, size_t *written);
+
+
+/**
+ * @brief Discards all buffered bytes without writing them.
+ *
+ * A spilled buffer also discards its temporary file and keeps its output in memory again.
+ *
+ * @param[in,out] buffer The buffer to clear.
+ */
+void clearOutputBuffer(OutputBuffer *buffer);
+
+
+/**
+ * @brief Frees the output buffer without flushing it.
+ *
+ * The temporary file of a spilled buffer is closed and removed.
+ *
+ * @param[in] buffer The buffer to free.
+ */
+void freeOutputBuffer(OutputBuffer *buffer);
+
+#endif // OUTPUTBUFFER_H
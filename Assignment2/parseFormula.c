@@ -12,12 +12,34 @@
  *   Validates balanced parentheses in the specified input file.
  * - ./parseFormula periodicTable.txt -ext <input.txt> <output.txt>
  *   Expands the formulas from the input file and writes them to the output file.
+ *   With `--grouped` the formulas are written in their grouped form instead, which
+ *   `-ext` expands to the same lines.
  * - ./parseFormula periodicTable.txt -pn <input.txt> <output.txt>
  *   Calculates and writes the total number of protons for each formula from the input file to the output file.
+ * - ./parseFormula periodicTable.txt -hist <input.txt> <output.txt>
+ *   Writes the number of atoms of each element of every formula as `Symbol:count` pairs.
+ * - ./parseFormula periodicTable.txt -img <periodicTable.img>
+ *   Saves the periodic table as a binary image. The image can be passed instead of
+ *   periodicTable.txt to any mode and is loaded without parsing.
+ * - ./parseFormula periodicTable.txt --serve
+ *   Keeps running with the table loaded and answers one request per line of the standard
+ *   input, like "-pn H2O", on the standard output.
+ *
+ * Adding `-j N` to the -ext, -pn and -hist modes processes the formulas on N worker threads.
+ * These modes check the parentheses while processing each formula, so the input
+ * is read once. If a formula is not balanced or can't be processed (like a formula with an
+ * unknown symbol in -hist) the output file is left untouched; adding `--per-line-errors`
+ * instead writes a marker line for each such formula and keeps the rest.
+ * Repeated formulas are written from a cache of the output lines; `--cache-stats` prints
+ * its hits and misses to the standard error. `--stats` prints the time of every phase and
+ * the counters of the run to the standard error as a single-line JSON object.
  */
 
 #include "formulaExpander.h"
 #include "periodicTable.h"
+#include "batchProcessor.h"
+#include "formulaServer.h"
+#include "formulaStats.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -31,26 +53,82 @@
  * @return int Returns 0 on successful execution and 1 on error.
  */
 int main(int argc, char *argv[]) {
+
+    // Remove the optional "-j N", "--per-line-errors", "--cache-stats", "--stats" and "--grouped" from the arguments, the rest are positional
+    int threads = 1;
+    ErrorMode errors = ALL_OR_NOTHING;
+    bool cacheStats = false;
+    bool runStats = false;
+    bool grouped = false;
+    FormulaStats stats;
+    memset(&stats, 0, sizeof(stats));
+    int positional = 1;
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--per-line-errors") == 0){
+            errors = PER_LINE_ERRORS;
+        } else if(strcmp(argv[i], "--cache-stats") == 0){
+            cacheStats = true;
+        } else if(strcmp(argv[i], "--stats") == 0){
+            runStats = true;
+        } else if(strcmp(argv[i], "--grouped") == 0){
+            grouped = true;
+        } else if(strcmp(argv[i], "-j") == 0 && i + 1 < argc){
+            threads = atoi(argv[++i]);
+            if(threads < 1 || threads > MAX_THREADS){
+                printf("Number of threads must be between 1 and %d.\n", MAX_THREADS);
+                return 1;
+            }
+        } else{
+            argv[positional++] = argv[i];
+        }
+    }
+    argc = positional;
+    FormulaStats *collected = (cacheStats || runStats) ? &stats : NULL; // nothing is counted otherwise
     
-    if(argc != 4 && argc != 5){ // check for invalid arguments  
+    bool serve = (argc == 3 && strcmp(argv[2], "--serve") == 0);
+    if(argc != 4 && argc != 5 && !serve){ // check for invalid arguments  
         printf("Usage:\n");
         printf("./parseFormula periodicTable.txt -v <input.txt>\n");
-        printf("./parseFormula periodicTable.txt -ext <input.txt> <output.txt>\n");
-        printf("./parseFormula periodicTable.txt -pn <input.txt> <output.txt>\n");
+        printf("./parseFormula periodicTable.txt -ext <input.txt> <output.txt> [--grouped] [-j N] [--per-line-errors] [--cache-stats] [--stats]\n");
+        printf("./parseFormula periodicTable.txt -pn <input.txt> <output.txt> [-j N] [--per-line-errors] [--cache-stats] [--stats]\n");
+        printf("./parseFormula periodicTable.txt -hist <input.txt> <output.txt> [-j N] [--per-line-errors] [--cache-stats] [--stats]\n");
+        printf("./parseFormula periodicTable.txt -img <periodicTable.img>\n");
+        printf("./parseFormula periodicTable.txt --serve [--cache-stats] [--stats]\n");
         return 1;
     }
 
     Element periodicTable[MAX_ELEMENTS];
+    SymbolIndex index; // symbol index of the loaded table, passed to every mode that looks up symbols
+    bool indexed;
 
-    int numElements = loadPeriodicTable(argv[1], periodicTable);
-    if (numElements == EXIT_FAILURE) {
+    PhaseTime start = startPhase();
+    int numElements = loadPeriodicTableIndex(argv[1], periodicTable, &index, &indexed);
+    if (numElements == EXIT_FAILURE || !indexed) {
         printf("Failed to load periodic table.\n");
         return 1;
     }
+    endPhase(&stats.load, start);
 
+    start = startPhase();
     sortPeriodicTable(periodicTable, numElements);
+    endPhase(&stats.sort, start);
+    start = startPhase();
+
+    if(serve){ // Answer Requests Until the Input Ends
+        FormulaHandle *handle = NULL;
+        if(formula_open_table(&handle, periodicTable, numElements) != FORMULA_OK){
+            printf("Failed to load periodic table.\n");
+            return 1;
+        }
+
+        // nothing else is printed, the standard output only carries the answers
+        int status = serveFormulas(stdin, stdout, handle, &stats.cache);
+        formula_close(handle);
+        if(status != EXIT_SUCCESS){
+            return 1;
+        }
 
-    if(strcmp(argv[2], "-v") == 0){ // Parentheses Validate
+    } else if(strcmp(argv[2], "-v") == 0){ // Parentheses Validate
         if(argc != 4){
             printf("Usage: ./parseFormula periodicTable.txt -v <input.txt>\n");
             return 1;
@@ -65,46 +143,104 @@ int main(int argc, char *argv[]) {
             // function validateParentheses will print the appropriate unbalanced lines if exists
         }
    
+    } else if(strcmp(argv[2], "-img") == 0){ // Save Periodic Table Image
+        if(argc != 4){
+            printf("Usage: ./parseFormula periodicTable.txt -img <periodicTable.img>\n");
+            return 1;
+        }
+
+        const char *imageFile = argv[3];
+        printf("Writing periodic table image to %s\n", imageFile);
+        if(savePeriodicTableImage(imageFile, periodicTable, numElements, &index) != EXIT_SUCCESS){
+            return 1;
+        }
+
     } else if(strcmp(argv[2], "-ext") == 0){ // Expand Formulas
         if(argc != 5){
-            printf("Usage: ./parseFormula periodicTable.txt -ext <input.txt> <output.txt>\n");
+            printf("Usage: ./parseFormula periodicTable.txt -ext <input.txt> <output.txt> [--grouped] [-j N] [--per-line-errors] [--cache-stats] [--stats]\n");
             return 1;
         }
 
         const char *inputFile = argv[3];
-        if(!validateParentheses(inputFile)){ // check parentheses before expansion
+        const char *outputFile = argv[4];
+        printf("Compute extended version of formulas in %s\n", inputFile);
+
+        // parentheses are checked while expanding, unbalanced lines are printed in order
+        int status = processBatches(inputFile, outputFile, grouped ? GROUPED_MODE : EXPAND_MODE, NULL, threads, errors, collected);
+        if(status == BATCH_UNBALANCED){
             printf("Imbalanced parentheses in file %s. Cannot proceed with formula expansion.\n", inputFile);
             return 1;
+        } else if(status == BATCH_FAILED){
+            printf("Formulas in file %s could not be processed. Cannot proceed with formula expansion.\n", inputFile);
+            return 1;
+        } else if(status != EXIT_SUCCESS){
+            return 1;
         }
-
-        const char *outputFile = argv[4];
-        printf("Compute extended version of formulas in %s\n", inputFile);
-        formulaProcessor(inputFile, outputFile);
         printf("Writing formulas to %s\n", outputFile);
     } else if(strcmp(argv[2], "-pn") == 0){ // Calculate Total Protons Number
         if(argc != 5){
-            printf("./parseFormula periodicTable.txt -pn <input.txt> <output.txt>\n");
+            printf("./parseFormula periodicTable.txt -pn <input.txt> <output.txt> [-j N] [--per-line-errors] [--cache-stats] [--stats]\n");
             return 1;
         }
 
         const char *inputFile = argv[3];
-        if(!validateParentheses(inputFile)){ // check parentheses before protons count
+        const char *outputFile = argv[4];
+        printf("Compute total proton number of formulas in %s\n", inputFile);
+
+        // parentheses are checked while counting, unbalanced lines are printed in order
+        int status = processBatches(inputFile, outputFile, PROTONS_MODE, &index, threads, errors, collected);
+        if(status == BATCH_UNBALANCED){
             printf("Imbalanced parentheses in file %s. Cannot proceed with calculating protons.\n", inputFile);
             return 1;
+        } else if(status == BATCH_FAILED){
+            printf("Formulas in file %s could not be processed. Cannot proceed with calculating protons.\n", inputFile);
+            return 1;
+        } else if(status != EXIT_SUCCESS){
+            return 1;
         }
+        printf("Writing formulas to %s\n", outputFile);
 
+    } else if(strcmp(argv[2], "-hist") == 0){ // Count Atoms of Each Element
+        if(argc != 5){
+            printf("./parseFormula periodicTable.txt -hist <input.txt> <output.txt> [-j N] [--per-line-errors] [--cache-stats] [--stats]\n");
+            return 1;
+        }
+
+        const char *inputFile = argv[3];
         const char *outputFile = argv[4];
-        printf("Compute total proton number of formulas in %s\n", inputFile);
-        countProtons(inputFile, outputFile, periodicTable);
+        printf("Compute element counts of formulas in %s\n", inputFile);
+
+        // parentheses are checked while counting, unbalanced lines are printed in order
+        int status = processBatches(inputFile, outputFile, HIST_MODE, &index, threads, errors, collected);
+        if(status == BATCH_UNBALANCED){
+            printf("Imbalanced parentheses in file %s. Cannot proceed with counting elements.\n", inputFile);
+            return 1;
+        } else if(status == BATCH_FAILED){
+            printf("Formulas in file %s could not be processed. Cannot proceed with counting elements.\n", inputFile);
+            return 1;
+        } else if(status != EXIT_SUCCESS){
+            return 1;
+        }
         printf("Writing formulas to %s\n", outputFile);
 
     } else{
         printf("Usage:\n");
         printf("./parseFormula periodicTable.txt -v <input.txt>\n");
-        printf("./parseFormula periodicTable.txt -ext <input.txt> <output.txt>\n");
-        printf("./parseFormula periodicTable.txt -pn <input.txt> <output.txt>\n");
+        printf("./parseFormula periodicTable.txt -ext <input.txt> <output.txt> [--grouped] [-j N] [--per-line-errors] [--cache-stats] [--stats]\n");
+        printf("./parseFormula periodicTable.txt -pn <input.txt> <output.txt> [-j N] [--per-line-errors] [--cache-stats] [--stats]\n");
+        printf("./parseFormula periodicTable.txt -hist <input.txt> <output.txt> [-j N] [--per-line-errors] [--cache-stats] [--stats]\n");
+        printf("./parseFormula periodicTable.txt -img <periodicTable.img>\n");
+        printf("./parseFormula periodicTable.txt --serve [--cache-stats] [--stats]\n");
         return 1;
     }
 
+    endPhase(&stats.run, start);
+    if(cacheStats){
+        fprintf(stderr, "Formula cache: %lld hits, %lld misses, %lld evictions\n", stats.cache.hits, stats.cache.misses, stats.cache.evictions);
+    }
+    if(runStats){
+        printFormulaStats(stderr, argv[2], threads, &stats);
+    }
+
     return 0;
 }
@@ -3,7 +3,9 @@
  * @brief Provides implementations for managing and accessing periodic table data.
  *
  * Implements functions to load a periodic table from a file, sort it by atomic number,
- * and retrieve the atomic number of an element given its chemical symbol.
+ * and retrieve the atomic number of an element given its chemical symbol. A loaded table
+ * and its symbol index can also be saved as a binary image, which is loaded back with two
+ * reads instead of parsing the text file.
  * 
  * @author  Panagiotis Tsembekis
  * @bug     No known bugs.
@@ -12,59 +14,189 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
 #include "periodicTable.h"
 
+static SymbolIndex loadedIndex; /**< Symbol index of the table last loaded by loadPeriodicTable */
+static const Element *loadedTable = NULL; /**< Table that loadedIndex was built for, NULL if none */
+static int loadedCount = 0; /**< Number of elements of loadedTable */
 
-// Load the periodic table's elements from specified file
-int loadPeriodicTable(const char *filename, Element elements[]) {
-    FILE *file = fopen(filename, "r"); // open file to read elements
+#define TABLE_IMAGE_MAGIC "PTIMAGE" /**< First bytes of a periodic table image */
+#define TABLE_IMAGE_VERSION 1 /**< Layout version of the image */
+
+
+/**
+ * @brief Header of a periodic table image, followed by the elements and the symbol index.
+ *
+ * The sizes of the structures are stored so that an image written by a build with a
+ * different layout is rejected instead of misread.
+ */
+typedef struct {
+    char magic[8]; // TABLE_IMAGE_MAGIC
+    int version; // TABLE_IMAGE_VERSION
+    int numElements; // number of elements that follow
+    int elementSize; // sizeof(Element)
+    int indexSize; // sizeof(SymbolIndex)
+} TableImageHeader;
+
+
+/**
+ * @brief Reads the elements and the symbol index of an image after its header.
+ *
+ * @param file The image file, positioned after the header.
+ * @param header The header of the image.
+ * @param elements An array to store the loaded elements.
+ * @param index The index to store the symbol index of the image.
+ * @param indexed A pointer to store whether the index was read.
+ * @return int The number of elements loaded, or 'EXIT_FAILURE' if the image is not valid.
+ */
+static int loadTableImage(FILE *file, const TableImageHeader *header, Element elements[], SymbolIndex *index, bool *indexed) {
+    if (header->version != TABLE_IMAGE_VERSION || header->numElements < 0 || header->numElements > MAX_ELEMENTS
+        || header->elementSize != (int) sizeof(Element) || header->indexSize != (int) sizeof(SymbolIndex)) {
+        fprintf(stderr, "Error: periodic table image was written by a different version.\n");
+        return EXIT_FAILURE;
+    }
+
+    size_t n = (size_t) header->numElements;
+    if (fread(elements, sizeof(Element), n, file) != n || fread(index, sizeof(SymbolIndex), 1, file) != 1) {
+        fprintf(stderr, "Error: periodic table image is truncated.\n");
+        return EXIT_FAILURE;
+    }
+
+    *indexed = true;
+    return header->numElements;
+}
+
+
+// Load the periodic table's elements and their symbol index into memory of the caller
+int loadPeriodicTableIndex(const char *filename, Element elements[], SymbolIndex *index, bool *indexed) {
+    *indexed = false;
+    FILE *file = fopen(filename, "rb"); // open file to read elements
     if (file == NULL) {
         perror("Unable to open file to read periodic table elements.");
         return EXIT_FAILURE;
     }
 
+    // A prebuilt image is loaded as it is, anything else is parsed as text
+    TableImageHeader header;
+    if (fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, TABLE_IMAGE_MAGIC, sizeof(header.magic)) == 0) {
+        int loaded = loadTableImage(file, &header, elements, index, indexed);
+        fclose(file);
+        return loaded;
+    }
+    rewind(file);
+
     char symbol[4];
-    int atomicNumber, index = 0;
+    int atomicNumber, count = 0;
 
-    while (index < MAX_ELEMENTS && fscanf(file, "%3s %d", symbol, &atomicNumber) == 2) { // read element symbol & atomic number
+    while (count < MAX_ELEMENTS && fscanf(file, "%3s %d", symbol, &atomicNumber) == 2) { // read element symbol & atomic number
         symbol[sizeof(symbol) - 1] = '\0';  // termination character
         if (strlen(symbol) > 3) { // handle invalid elements
             fprintf(stderr, "Error: Chemical symbol '%s' exceeds maximum length.\n", symbol);
             continue;  // skip this
         }
 
-        // Construct element that will be stored in elements[index]
-        strncpy(elements[index].chemSymbol, symbol, sizeof(elements[index].chemSymbol) - 1); // element name = symbol read
-        elements[index].chemSymbol[sizeof(elements[index].chemSymbol) - 1] = '\0';  // termination character
-        elements[index].atomicNumber = atomicNumber; // assign atomic number
-        index++;
+        // Construct element that will be stored in elements[count]
+        strncpy(elements[count].chemSymbol, symbol, sizeof(elements[count].chemSymbol) - 1); // element name = symbol read
+        elements[count].chemSymbol[sizeof(elements[count].chemSymbol) - 1] = '\0';  // termination character
+        elements[count].atomicNumber = atomicNumber; // assign atomic number
+        count++;
     }
 
     fclose(file);
-    return index; // return index to keep track in parseFormula.c of how many elements we've read
+
+    buildSymbolIndex(index, elements, count); // index the table once for all look-ups
+    *indexed = true;
+
+    return count; // return count to keep track in parseFormula.c of how many elements we've read
+}
+
+
+// Load the periodic table's elements from specified file
+int loadPeriodicTable(const char *filename, Element elements[]) {
+    bool indexed;
+    int loaded = loadPeriodicTableIndex(filename, elements, &loadedIndex, &indexed); // built once, kept for getAtomicNumber
+    loadedTable = indexed ? elements : NULL; // the index may be partly overwritten otherwise
+    loadedCount = loaded;
+    return loaded;
+}
+
+
+/**
+ * @brief Compares two elements by atomic number, for qsort.
+ *
+ * Elements with the same atomic number are ordered by symbol, so the order doesn't depend
+ * on the qsort implementation.
+ *
+ * @param a The first element.
+ * @param b The second element.
+ * @return int A negative, zero or positive value if a comes before, together with or after b.
+ */
+static int compareElements(const void *a, const void *b) {
+    const Element *first = (const Element *) a;
+    const Element *second = (const Element *) b;
+
+    if (first->atomicNumber != second->atomicNumber) {
+        return (first->atomicNumber < second->atomicNumber) ? -1 : 1;
+    }
+    return strcmp(first->chemSymbol, second->chemSymbol);
 }
 
 
 // Sort the periodic table in ascending order based on atomic number
 void sortPeriodicTable(Element elements[], int numElements) {
-    int i, j;
-    Element temp;
-
-    for (i = 0; i < numElements - 1; i++) {
-        for (j = 0; j < numElements - i - 1; j++) {
-            if (elements[j].atomicNumber > elements[j + 1].atomicNumber) { // sort in ascending order
-                // Swap element[i] with element[i + 1]
-                temp = elements[j];
-                elements[j] = elements[j + 1];
-                elements[j + 1] = temp;
-            }
-        }
+    if (numElements > 1) {
+        qsort(elements, (size_t) numElements, sizeof(Element), compareElements);
     }
 }
 
 
+// Save the periodic table and its symbol index as an image that loads without parsing
+int savePeriodicTableImage(const char *filename, Element elements[], int numElements, const SymbolIndex *index) {
+    if (numElements < 0 || numElements > MAX_ELEMENTS) {
+        fprintf(stderr, "Error: invalid number of elements for periodic table image.\n");
+        return EXIT_FAILURE;
+    }
+
+    // Save the index built when the table was loaded, or build one for tables loaded without it
+    SymbolIndex localIndex;
+    if (index == NULL) {
+        buildSymbolIndex(&localIndex, elements, numElements);
+        index = &localIndex;
+    }
+
+    FILE *file = fopen(filename, "wb");
+    if (file == NULL) {
+        perror("Unable to open file to write periodic table image.");
+        return EXIT_FAILURE;
+    }
+
+    TableImageHeader header;
+    memset(&header, 0, sizeof(header)); // no uninitialized padding in the file
+    memcpy(header.magic, TABLE_IMAGE_MAGIC, sizeof(header.magic));
+    header.version = TABLE_IMAGE_VERSION;
+    header.numElements = numElements;
+    header.elementSize = (int) sizeof(Element);
+    header.indexSize = (int) sizeof(SymbolIndex);
+
+    bool written = (fwrite(&header, sizeof(header), 1, file) == 1
+                    && fwrite(elements, sizeof(Element), (size_t) numElements, file) == (size_t) numElements
+                    && fwrite(index, sizeof(SymbolIndex), 1, file) == 1);
+    if (fclose(file) != 0 || !written) {
+        perror("Unable to write periodic table image.");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+
 // Retrieve the atomic number of given symbol
 int getAtomicNumber(Element elements[], int n, const char *symbol) {
+    if (elements == loadedTable && n == loadedCount) { // table is indexed, no need to search it
+        return getIndexedAtomicNumber(&loadedIndex, symbol);
+    }
+
     for (int i = 0; i < n; i++) { // iterate elements table to find the requested symbol
         if (strcmp(elements[i].chemSymbol, symbol) == 0) { // if a match is found return its atomic number
             return elements[i].atomicNumber;
@@ -75,15 +207,75 @@ int getAtomicNumber(Element elements[], int n, const char *symbol) {
 }
 
 
+// Retrieve the atomic number of given symbol from a symbol index
+int getIndexedAtomicNumber(const SymbolIndex *index, const char *symbol) {
+    return lookupAtomicNumber(index, symbolKey(symbol, strlen(symbol)));
+}
+
+
+// Pack a chemical symbol into a key: first letter in base 26, next two letters in base 27 (0 = no letter)
+int symbolKey(const char *symbol, size_t length) {
+    if (length < 1 || length > 3 || symbol[0] < 'A' || symbol[0] > 'Z') {
+        return -1;
+    }
+
+    int key = symbol[0] - 'A';
+    for (size_t i = 1; i < 3; i++) {
+        int letter = 0; // missing letters pack as 0
+        if (i < length) {
+            if (symbol[i] < 'a' || symbol[i] > 'z') {
+                return -1;
+            }
+            letter = symbol[i] - 'a' + 1;
+        }
+        key = (key * 27) + letter;
+    }
+
+    return key;
+}
+
+
+// Build the look-up table from packed symbols to atomic numbers
+void buildSymbolIndex(SymbolIndex *index, const Element elements[], int n) {
+    memset(index->atomicNumber, 0, sizeof(index->atomicNumber));
+    memset(index->symbol, 0, sizeof(index->symbol));
+
+    for (int i = 0; i < n; i++) {
+        int key = symbolKey(elements[i].chemSymbol, strlen(elements[i].chemSymbol));
+        if (key >= 0 && index->atomicNumber[key] == 0) { // keep first occurrence
+            index->atomicNumber[key] = (short) elements[i].atomicNumber;
+        }
+
+        // Reverse look-up, for printing counts by atomic number
+        int number = elements[i].atomicNumber;
+        if (number >= 1 && number <= MAX_ELEMENTS && index->symbol[number][0] == '\0') {
+            strcpy(index->symbol[number], elements[i].chemSymbol);
+        }
+    }
+}
+
+
+// Retrieve the atomic number of a packed symbol
+int lookupAtomicNumber(const SymbolIndex *index, int key) {
+    if (key < 0 || index->atomicNumber[key] == 0) {
+        return -1; // invalid symbol or element not found
+    }
+
+    return index->atomicNumber[key];
+}
+
+
 #ifdef DEBUG_PERIODICTABLE
 
 int main() {
     Element elements[MAX_ELEMENTS];
+    SymbolIndex index;
+    bool indexed;
     int numElements;
 
     // Load the periodic table from the given "periodicTable.txt" file
-    numElements = loadPeriodicTable("periodicTable.txt", elements);
-    if (numElements == -1) {
+    numElements = loadPeriodicTableIndex("periodicTable.txt", elements, &index, &indexed);
+    if (numElements == EXIT_FAILURE || !indexed) {
         printf("Failed to load periodic table.\n");
         return EXIT_FAILURE;
     }
@@ -101,10 +293,16 @@ int main() {
         printf("%-6s | %15d\n", elements[i].chemSymbol, elements[i].atomicNumber);
     }
 
-    // Test retrieval of atomic numbers
+    // Test retrieval of atomic numbers, through the index and by searching the table
+    Element keptElements[MAX_ELEMENTS];
+    int keptCount = loadPeriodicTable("periodicTable.txt", keptElements);
     const char* testSymbols[] = {"H", "Db", "Uus", "None"};
     for (int i = 0; i < sizeof(testSymbols)/sizeof(testSymbols[0]); i++) {
-        int atomicNumber = getAtomicNumber(elements, numElements, testSymbols[i]);
+        int atomicNumber = getIndexedAtomicNumber(&index, testSymbols[i]);
+        if (atomicNumber != getAtomicNumber(elements, numElements, testSymbols[i])
+            || atomicNumber != getAtomicNumber(keptElements, keptCount, testSymbols[i])) {
+            printf("Index and search disagree for %s\n", testSymbols[i]);
+        }
         if (atomicNumber != -1) {
             printf("Atomic number of %s: %d\n", testSymbols[i], atomicNumber);
         } else {
@@ -112,6 +310,30 @@ int main() {
         }
     }
 
+    // Test that the symbol index agrees with the table for every loaded element
+    int mismatches = 0;
+    for (int i = 0; i < numElements; i++) {
+        int key = symbolKey(elements[i].chemSymbol, strlen(elements[i].chemSymbol));
+        if (lookupAtomicNumber(&index, key) != elements[i].atomicNumber) {
+            printf("Index mismatch for %s\n", elements[i].chemSymbol);
+            mismatches++;
+        }
+    }
+    printf("Symbol index checked with %d mismatches.\n", mismatches);
+
+    // Test that an image of the table loads back the same elements and index
+    Element imageElements[MAX_ELEMENTS];
+    SymbolIndex imageIndex;
+    if (savePeriodicTableImage("periodicTableDEBUG.img", elements, numElements, &index) == EXIT_SUCCESS
+        && loadPeriodicTableIndex("periodicTableDEBUG.img", imageElements, &imageIndex, &indexed) == numElements
+        && memcmp(imageElements, elements, numElements * sizeof(Element)) == 0
+        && memcmp(&imageIndex, &index, sizeof(SymbolIndex)) == 0) {
+        printf("Periodic table image loaded back correctly.\n");
+    } else {
+        printf("Periodic table image doesn't match the loaded table.\n");
+    }
+    remove("periodicTableDEBUG.img");
+
     return 0;
 }
 #endif // DEBUG_PERIODICTABLE
\ No newline at end of file
@@ -7,7 +7,8 @@
  * where each struct stores the chemical symbol and atomic number of an element.
  * 
  * The file includes functions to load elements from a file, sort them, and retrieve 
- * an atomic number based on a chemical symbol.
+ * an atomic number based on a chemical symbol. A loaded table can be saved as a binary
+ * image that later loads without parsing.
  * 
  * @author  Panagiotis Tsembekis
  * @bug     No known bugs.
@@ -16,7 +17,11 @@
 #ifndef PERIODIC_TABLE_H
 #define PERIODIC_TABLE_H
 
+#include <stdbool.h>
+#include <stddef.h>
+
 #define MAX_ELEMENTS 118 /**< Maximum number of elements in the periodic table */
+#define SYMBOL_KEYS (26 * 27 * 27) /**< Number of distinct packed keys of 1-3 letter symbols */
 
 
 /**
@@ -38,11 +43,38 @@ typedef struct {
 } Element;
 
 
+/**
+ * @struct SymbolIndex
+ * @brief A direct-indexed lookup table from packed chemical symbols to atomic numbers.
+ *
+ * Every chemical symbol (an uppercase letter followed by up to two lowercase letters) is
+ * packed into a unique key in [0, SYMBOL_KEYS) by `symbolKey`, so a lookup is a single
+ * array access instead of a scan over the periodic table.
+ *
+ * @var SymbolIndex::atomicNumber
+ * The atomic number of the element with each key, or 0 if no element has that symbol.
+ *
+ * @var SymbolIndex::symbol
+ * The chemical symbol of the element with each atomic number (1 to MAX_ELEMENTS), or an
+ * empty string if no element has that atomic number.
+ */
+typedef struct {
+    short atomicNumber[SYMBOL_KEYS];
+    char symbol[MAX_ELEMENTS + 1][4];
+} SymbolIndex;
+
+
 /**
  * @brief Loads the periodic table from a file.
  * 
  * This function reads element data (chemical symbol and atomic number) from a specified file
- * and loads it into an array of Element structs.
+ * and loads it into an array of Element structs. The symbol index of the table is built once
+ * and kept by the module, so `getAtomicNumber` on this array doesn't search it; it is replaced
+ * by the next call. Use `loadPeriodicTableIndex` to get the index into memory of the caller
+ * instead, for example to load tables on several threads.
+ *
+ * If the file is an image written by `savePeriodicTableImage`, the elements are read from it
+ * directly instead.
  * 
  * @param[in] filename The name of the file containing element data.
  * @param[out] elements An array to store the loaded elements.
@@ -51,11 +83,27 @@ typedef struct {
 int loadPeriodicTable(const char *filename, Element elements[]);
 
 
+/**
+ * @brief Loads the periodic table from a file into a symbol index of the caller.
+ *
+ * This function loads a text file or an image like `loadPeriodicTable`, and also stores the
+ * symbol index of the loaded table in `index`: it is built once for a text file, or read from
+ * an image. Nothing is kept by the module, so tables can be loaded by several threads at once.
+ *
+ * @param[in] filename The name of the file containing element data.
+ * @param[out] elements An array to store the loaded elements.
+ * @param[out] index The symbol index of the loaded elements.
+ * @param[out] indexed A pointer to store whether the index was completely built or read.
+ * @return int The number of elements successfully loaded, or 'EXIT_FAILURE' if the file could not be loaded.
+ */
+int loadPeriodicTableIndex(const char *filename, Element elements[], SymbolIndex *index, bool *indexed);
+
+
 /**
  * @brief Sorts the periodic table by atomic number.
  * 
  * This function sorts an array of Element structs in ascending order based on their atomic numbers,
- * using the bubble sort algorithm.
+ * using qsort. Elements with the same atomic number are ordered by symbol.
  * 
  * @param[in,out] elements An array of elements to be sorted.
  * @param[in] numElements The number of elements in the array.
@@ -63,11 +111,28 @@ int loadPeriodicTable(const char *filename, Element elements[]);
 void sortPeriodicTable(Element elements[], int numElements);
 
 
+/**
+ * @brief Saves a periodic table and its symbol index as a binary image.
+ *
+ * The image holds the elements and the symbol index exactly as they are in memory, so
+ * `loadPeriodicTableIndex` loads it without parsing or indexing. An image is only valid for
+ * builds with the same layout of `Element` and `SymbolIndex`, which is checked on load.
+ *
+ * @param[in] filename The name of the image file to write.
+ * @param[in] elements The array of elements to save.
+ * @param[in] numElements The number of elements in the array.
+ * @param[in] index The symbol index of the array, or NULL to build one.
+ * @return int Returns 0 on success, or 1 if the file can't be written.
+ */
+int savePeriodicTableImage(const char *filename, Element elements[], int numElements, const SymbolIndex *index);
+
+
 /**
  * @brief Retrieves the atomic number of an element based on its chemical symbol.
  * 
- * This function searches an array of Element structs for an element with the specified chemical symbol
- * and returns its atomic number.
+ * This function looks up the atomic number of the specified chemical symbol in the symbol index
+ * kept by `loadPeriodicTable` when the array is the one it loaded last, otherwise the array is
+ * searched.
  * 
  * @param[in] elements The array of elements to search through.
  * @param[in] n The number of elements in the array.
@@ -76,4 +141,46 @@ void sortPeriodicTable(Element elements[], int numElements);
  */
 int getAtomicNumber(Element elements[], int n, const char *symbol);
 
+
+/**
+ * @brief Retrieves the atomic number of a chemical symbol from a symbol index.
+ *
+ * @param[in] index The symbol index to use, as built by `loadPeriodicTableIndex` or `buildSymbolIndex`.
+ * @param[in] symbol The chemical symbol to look up (null-terminated).
+ * @return int The atomic number of the element, or -1 if the symbol was not found.
+ */
+int getIndexedAtomicNumber(const SymbolIndex *index, const char *symbol);
+
+
+/**
+ * @brief Packs a chemical symbol into its symbol index key.
+ *
+ * @param[in] symbol The chemical symbol (doesn't need to be null-terminated).
+ * @param[in] length The number of characters of the symbol (1 to 3).
+ * @return int The key of the symbol, or -1 if it is not an uppercase letter followed by lowercase letters.
+ */
+int symbolKey(const char *symbol, size_t length);
+
+
+/**
+ * @brief Builds the symbol index of a periodic table.
+ *
+ * If a symbol appears more than once, the first occurrence is kept, just like a search would find it.
+ *
+ * @param[out] index The index to build.
+ * @param[in] elements The array of elements to index.
+ * @param[in] n The number of elements in the array.
+ */
+void buildSymbolIndex(SymbolIndex *index, const Element elements[], int n);
+
+
+/**
+ * @brief Retrieves the atomic number of a packed symbol key from a symbol index.
+ *
+ * @param[in] index The symbol index to use.
+ * @param[in] key The key of the symbol, as returned by `symbolKey`.
+ * @return int The atomic number of the element, or -1 if the symbol was not found.
+ */
+int lookupAtomicNumber(const SymbolIndex *index, int key);
+
 #endif // PERIODIC_TABLE_H
\ No newline at end of file
@@ -28,11 +28,69 @@ int initUnionStack(UnionStack **stack) {
     // Initialize top of stack as NULL and its size to 0
     (*stack)->top = NULL;
     (*stack)->size = 0;
+    (*stack)->pool = NULL; // allocate every node separately unless a pool is attached
 
     return EXIT_SUCCESS;
 }
 
 
+/**
+ * @brief Gets a node for a push, either from the stack's pool or with malloc.
+ *
+ * @param stack The stack that the node will be pushed to.
+ * @return StackNode* The new node, or NULL if memory allocation fails.
+ */
+static StackNode *allocateNode(UnionStack *stack) {
+    StackPool *pool = stack->pool;
+    if (pool == NULL) {
+        return (StackNode *) malloc(sizeof(StackNode));
+    }
+
+    if (pool->freeList != NULL) { // reuse a popped node
+        StackNode *node = pool->freeList;
+        pool->freeList = node->next;
+        return node;
+    }
+
+    if (pool->current == NULL || pool->used == NODE_BLOCK_SIZE) { // move to next block
+        StackNodeBlock *next = (pool->current == NULL) ? pool->blocks : pool->current->next;
+        if (next == NULL) { // no block left from previous resets, allocate a new one
+            next = (StackNodeBlock *) malloc(sizeof(StackNodeBlock));
+            if (next == NULL) {
+                return NULL;
+            }
+            next->next = NULL;
+            if (pool->current == NULL) {
+                pool->blocks = next;
+            } else {
+                pool->current->next = next;
+            }
+        }
+        pool->current = next;
+        pool->used = 0;
+    }
+
+    return &(pool->current->nodes[(pool->used)++]);
+}
+
+
+/**
+ * @brief Releases a popped node, either back to the stack's pool or with free.
+ *
+ * @param stack The stack that the node was popped from.
+ * @param node The node to release.
+ */
+static void releaseNode(UnionStack *stack, StackNode *node) {
+    if (stack->pool == NULL) {
+        free(node);
+        return;
+    }
+
+    node->next = stack->pool->freeList; // keep node for the next push
+    stack->pool->freeList = node;
+}
+
+
 // Check if the union stack is empty
 bool isEmptyUnion(UnionStack *stack) {
     return (stack->top == NULL); // if the stack's top is NULL -> return false, true otherwise
@@ -46,7 +104,7 @@ int pushCharUnion(UnionStack *stack, char c) {
         return EXIT_FAILURE;
     }
 
-    StackNode *newNode = (StackNode *) malloc(sizeof(StackNode)); // allocate memory for a Node pointer
+    StackNode *newNode = allocateNode(stack); // allocate memory for a Node pointer
     if (newNode == NULL) { // check if required memory can be allocated
         perror("Unable to allocate memory for new node.");
         return EXIT_FAILURE;
@@ -69,7 +127,7 @@ int pushElementUnion(UnionStack *stack, Element element) {
         return EXIT_FAILURE;
     }
 
-    StackNode *newNode = (StackNode *) malloc(sizeof(StackNode)); // alocate memory space for a Node pointer
+    StackNode *newNode = allocateNode(stack); // alocate memory space for a Node pointer
     if (newNode == NULL) { // if required memory can't be allocated print according message
         perror("Unable to allocate memory for new node.");
         return EXIT_FAILURE;
@@ -97,7 +155,7 @@ int popUnion(UnionStack *stack, StackData *returnValue, StackDataType *returnTyp
     *returnType = temp->dataType; // return the type of the data
     stack->top = stack->top->next; // new top is the next node after top
 
-    free(temp); // free space that previous top was taking up
+    releaseNode(stack, temp); // free space that previous top was taking up
     (stack->size)--; // decrease stack's size
 
     if(stack->size == 0){
@@ -118,6 +176,84 @@ StackDataType topUnionType(UnionStack *stack) {
 }
 
 
+// Remove every item of the union stack
+void clearUnionStack(UnionStack *stack) {
+    if (stack == NULL) {
+        return;
+    }
+
+    if (stack->pool == NULL) { // nodes were allocated separately, free them one by one
+        while (stack->top != NULL) {
+            StackNode *temp = stack->top;
+            stack->top = temp->next;
+            free(temp);
+        }
+    }
+
+    // Pooled nodes are released all together by resetStackPool
+    stack->top = NULL;
+    stack->size = 0;
+}
+
+
+// Initialize a pool of stack nodes
+int initStackPool(StackPool **pool) {
+    *pool = (StackPool *) malloc(sizeof(StackPool));
+    if (*pool == NULL) {
+        perror("Unable to allocate memory for stack pool initialization.");
+        return EXIT_FAILURE;
+    }
+
+    // Blocks are allocated on demand
+    (*pool)->blocks = NULL;
+    (*pool)->current = NULL;
+    (*pool)->used = 0;
+    (*pool)->freeList = NULL;
+
+    return EXIT_SUCCESS;
+}
+
+
+// Make an empty stack take its nodes from the pool
+int attachStackPool(UnionStack *stack, StackPool *pool) {
+    if (stack == NULL || !isEmptyUnion(stack)) { // nodes of a different allocator can't be mixed in
+        return EXIT_FAILURE;
+    }
+
+    stack->pool = pool;
+    return EXIT_SUCCESS;
+}
+
+
+// Release all nodes of the pool at once, keeping its blocks
+void resetStackPool(StackPool *pool) {
+    if (pool == NULL) {
+        return;
+    }
+
+    pool->current = NULL; // start carving again from the first block
+    pool->used = 0;
+    pool->freeList = NULL;
+}
+
+
+// Free the pool and its blocks
+void freeStackPool(StackPool *pool) {
+    if (pool == NULL) {
+        return;
+    }
+
+    StackNodeBlock *block = pool->blocks;
+    while (block != NULL) {
+        StackNodeBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+
+    free(pool);
+}
+
+
 // Print the stack
 void printUnionStack(UnionStack *stack) {
     if (stack == NULL || stack->top == NULL) {
@@ -198,6 +334,28 @@ int main() {
         printf("Error after clear: Popping from an empty stack should fail.\n");
     }
 
+    // Test a pooled stack, pushing more nodes than a single block holds
+    printf("Testing pooled stack...\n");
+    StackPool *pool = NULL;
+    if (initStackPool(&pool) != EXIT_SUCCESS || attachStackPool(stack, pool) != EXIT_SUCCESS) {
+        printf("Failed to attach pool to stack.\n");
+        return EXIT_FAILURE;
+    }
+
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 3 * NODE_BLOCK_SIZE; i++) {
+            pushElementUnion(stack, (Element){.chemSymbol = "C", .atomicNumber = 6});
+        }
+        popUnion(stack, &data, &type); // popped node is reused by the next push
+        pushCharUnion(stack, 'b');
+        printf("Round %d: stack size %d, top type %s\n", round + 1, stack->size, topUnionType(stack) == CHAR_TYPE ? "char" : "element");
+        clearUnionStack(stack);
+        resetStackPool(pool); // release whole round at once
+    }
+
+    freeStackPool(pool);
+    free(stack);
+
     printf("Stack operations test completed.\n");
     
     return 0;
@@ -74,22 +74,75 @@ typedef struct StackNode {
 } StackNode;
 
 
+#define NODE_BLOCK_SIZE 1024 /**< Number of nodes allocated at once by a StackPool */
+
+
+/**
+ * @struct StackNodeBlock
+ * @brief A contiguous block of stack nodes owned by a StackPool.
+ *
+ * @var StackNodeBlock::next
+ * Pointer to the next block of the pool.
+ *
+ * @var StackNodeBlock::nodes
+ * The nodes of the block.
+ */
+typedef struct StackNodeBlock {
+    struct StackNodeBlock *next; // pointer to next block
+    StackNode nodes[NODE_BLOCK_SIZE]; // nodes handed out in order
+} StackNodeBlock;
+
+
+/**
+ * @struct StackPool
+ * @brief A pool of stack nodes that can be shared by several union stacks.
+ *
+ * Nodes are carved out of large contiguous blocks instead of being allocated one by one,
+ * and popped nodes are kept in a free list to be reused by the next push. Resetting the
+ * pool releases every node handed out in a single operation while keeping the blocks
+ * for reuse, so processing many formulas doesn't touch the allocator after the first one.
+ *
+ * @var StackPool::blocks
+ * Pointer to the first block of the pool.
+ *
+ * @var StackPool::current
+ * Pointer to the block that new nodes are carved from.
+ *
+ * @var StackPool::used
+ * The number of nodes carved from the current block.
+ *
+ * @var StackPool::freeList
+ * Linked list of popped nodes waiting to be reused.
+ */
+typedef struct {
+    StackNodeBlock *blocks; // first block of the pool
+    StackNodeBlock *current; // block that nodes are carved from
+    int used; // nodes carved from current block
+    StackNode *freeList; // popped nodes that can be reused
+} StackPool;
+
+
 /**
  * @struct UnionStack
  * @brief A structure representing the stack itself.
  * 
  * The stack consists of a linked list of StackNodes. Each node stores a union of either 
  * a char or an Element, and the stack keeps track of the top node and its current size.
+ * The nodes are either allocated one by one or, if a pool is attached, taken from the pool.
  * 
  * @var UnionStack::top
  * Pointer to the top node of the stack.
  * 
  * @var UnionStack::size
  * The current number of elements in the stack.
+ *
+ * @var UnionStack::pool
+ * Pointer to the pool the nodes are taken from, or NULL to allocate every node separately.
  */
 typedef struct {
     StackNode *top; // pointer to the top of the stack
     int size; // current size of the stack
+    StackPool *pool; // pool of nodes (NULL = malloc every node)
 } UnionStack;
 
 
@@ -170,6 +223,60 @@ int popUnion(UnionStack *stack, StackData *returnValue, StackDataType *returnTyp
 StackDataType topUnionType(UnionStack *stack);
 
 
+/**
+ * @brief Removes every item from the union stack.
+ *
+ * If the stack uses a pool, the nodes are not released one by one; they are released
+ * together with the rest of the pool's nodes by `resetStackPool`. Otherwise every node is freed.
+ *
+ * @param[in,out] stack The stack to clear.
+ */
+void clearUnionStack(UnionStack *stack);
+
+
+/**
+ * @brief Initializes a pool of stack nodes.
+ *
+ * The pool starts without any blocks; the first block is allocated by the first push.
+ *
+ * @param[in,out] pool A pointer to the pointer of the pool to be initialized.
+ * @return int Returns 0 if initialization is successful, or 1 if memory allocation fails.
+ */
+int initStackPool(StackPool **pool);
+
+
+/**
+ * @brief Attaches a pool to an empty union stack.
+ *
+ * All the following pushes of the stack take their nodes from the pool and all pops
+ * return them to it. Several stacks can share the same pool.
+ *
+ * @param[in,out] stack The stack that will use the pool.
+ * @param[in] pool The pool to take nodes from.
+ * @return int Returns 0 on success, or 1 if the stack is not empty.
+ */
+int attachStackPool(UnionStack *stack, StackPool *pool);
+
+
+/**
+ * @brief Releases every node handed out by the pool in a single operation.
+ *
+ * The blocks of the pool are kept for reuse. Every stack attached to the pool must be
+ * cleared with `clearUnionStack` (or be empty) before the pool is reset.
+ *
+ * @param[in,out] pool The pool to reset.
+ */
+void resetStackPool(StackPool *pool);
+
+
+/**
+ * @brief Frees a pool and all of its blocks.
+ *
+ * @param[in] pool The pool to free.
+ */
+void freeStackPool(StackPool *pool);
+
+
 /**
  * @brief Prints the entire union stack (for debugging purposes).
  * 